@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FrameLog.hpp"
+#include "MarketFeed.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace dom
+{
+    // --bench: captured or synthetic frames through the production
+    // decode -> apply -> ladder path, timed frame by frame, output discarded.
+
+    // Heap allocations made so far by the calling thread. Only a SHAH_BACKEND_BENCH
+    // build counts them (BenchAllocator.cpp replaces the global operator new);
+    // otherwise always 0 and countsAllocations() is false.
+    [[nodiscard]] std::uint64_t threadAllocations();
+    [[nodiscard]] bool countsAllocations();
+    // Peak resident set of the process in bytes; 0 where the OS does not say.
+    [[nodiscard]] std::uint64_t peakRssBytes();
+    // Monotonic nanoseconds; the bench's trace clock.
+    [[nodiscard]] std::int64_t steadyNs();
+
+    // Swallows everything written to it and counts the bytes.
+    class NullSink : public std::ostream
+    {
+    public:
+        NullSink() : std::ostream(&buf_) {}
+        [[nodiscard]] std::uint64_t bytes() const { return buf_.bytes; }
+
+    private:
+        struct Buf : std::streambuf
+        {
+            std::uint64_t bytes{0};
+            int_type overflow(int_type ch) override
+            {
+                ++bytes;
+                return traits_type::not_eof(ch);
+            }
+            std::streamsize xsputn(const char*, std::streamsize n) override
+            {
+                bytes += static_cast<std::uint64_t>(n);
+                return n;
+            }
+        };
+        Buf buf_;
+    };
+
+    struct SyntheticSessionOptions
+    {
+        std::size_t frames{200000};
+        std::size_t symbols{1};
+        std::size_t levelsPerSide{120};
+        std::size_t compression{1};
+        std::size_t snapshotDepth{500};
+        std::int64_t throttleMs{50};
+    };
+
+    // A MEXC session shaped like a --capture of a --multiplex backend. It has a Meta
+    // record, exchangeInfo and depth bodies per symbol (Rest keys are path and query
+    // only; the caller adds the host), a subscribe and a finished load per symbol,
+    // then depth deltas and deals frames round-robin over the symbols. Each symbol
+    // gets an update every 100 ms, like the @100ms channels. Deterministic.
+    [[nodiscard]] std::vector<Record> syntheticMexcSession(const SyntheticSessionOptions& options);
+
+    // Per-frame timings of one bench run; every stamp is steadyNs().
+    class BenchStats
+    {
+    public:
+        enum Stage
+        {
+            DepthFrame, // whole onBinaryFrame/onTextFrame call, book updates
+            DealsFrame, // same, trades
+            Decode,     // frame in -> decoded
+            Apply,      // decoded -> applied to the book
+            Emit,       // applied -> ladders written (updates that emitted only)
+            StageCount
+        };
+
+        // Room for `frames` samples per stage, so recording never allocates.
+        explicit BenchStats(std::size_t frames);
+
+        void onFrame(bool depth, std::int64_t ns, std::uint64_t allocations);
+        void onUpdate(const FrameTrace& trace, std::size_t ladders, std::int64_t doneNs);
+
+        // Human-readable table on `text`, one {"type":"bench",...} line on `json`.
+        void report(std::ostream& text,
+                    std::ostream& json,
+                    std::int64_t elapsedNs,
+                    std::uint64_t outputBytes,
+                    std::size_t symbols) const;
+
+    private:
+        std::array<std::vector<std::int64_t>, StageCount> samples_;
+        std::uint64_t frames_{0};
+        std::uint64_t allocations_{0};
+        std::uint64_t updates_{0};
+        std::uint64_t ladders_{0};
+    };
+} // namespace dom
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <string_view>
+
+namespace dom
+{
+    // Control command sent by the GUI on the backend's stdin, one JSON object per line:
+    //   {"cmd":"subscribe","stream":3,"symbol":"ETHUSDT","levels":200,"compression":1}
+    //   {"cmd":"unsubscribe","stream":3}
+    //   {"cmd":"set-levels","stream":3,"levels":200}
+    //   {"cmd":"set-compression","stream":3,"factor":5}
+    //   {"cmd":"set-throttle","stream":3,"ms":25}
+    //   {"cmd":"resubscribe-symbol","stream":3,"symbol":"ETHUSDT"}
+    //   {"cmd":"request-keyframe","stream":3}
+    //   {"cmd":"consumer-report","stream":3,"seq":812,"paintMs":3.5,"visible":true}
+    //   {"cmd":"prefetch","symbol":"ETHUSDT"}
+    // "stream" defaults to 0, the stream created from --symbol on the command line.
+    struct Command
+    {
+        enum class Type
+        {
+            Subscribe,
+            Unsubscribe,
+            SetLevels,
+            SetCompression,
+            SetThrottle,
+            ResubscribeSymbol,
+            RequestKeyframe,
+            ConsumerReport,
+            Prefetch
+        };
+
+        Type type{Type::RequestKeyframe};
+        int stream{0};
+        std::int64_t value{0}; // levels / factor / ms; levels for subscribe; seq for consumer-report
+        std::int64_t compression{1}; // subscribe only
+        bool reload{false};          // subscribe only: load the book afresh even if resident
+        std::string symbol;
+        // consumer-report only: how long the last frame took to paint, and
+        // whether the column is on screen at all.
+        double paintMs{0.0};
+        bool visible{true};
+    };
+
+    [[nodiscard]] const char* commandName(Command::Type type);
+
+    // Parses one command line. Returns false and fills `error` on malformed input.
+    bool parseCommand(std::string_view line, Command& out, std::string& error);
+
+    // Starts a detached thread that reads commands from `in` until EOF and passes
+    // every well-formed one to `handler` (called on the reader thread). `onLine`,
+    // if set, sees the raw line of each such command first (--capture); `onEnd`, if
+    // set, runs on the reader thread once `in` is at EOF or fails.
+    void startCommandReader(std::istream& in,
+                            std::function<void(const Command&)> handler,
+                            std::function<void(std::string_view line)> onLine = {},
+                            std::function<void()> onEnd = {});
+} // namespace dom
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace dom
+{
+    // Capture file written by --capture and read by --replay. After an 8-byte magic
+    // it is a flat sequence of records, appended as they happen:
+    //   kind:u8  timeUs:i64  keySize:u16  key  size:u32  payload   (little-endian)
+    // timeUs is the local wall clock (wallClockUs) of the event.
+    enum class RecordKind : std::uint8_t
+    {
+        Meta = 'M',    // JSON: exchange, symbol, multiplex, levels, compression, throttle
+        Rest = 'R',    // REST body; key = "host/path?query"
+        Text = 'T',    // WebSocket text frame as passed to MarketFeed
+        Binary = 'B',  // WebSocket binary frame as passed to MarketFeed
+        Command = 'C', // stdin command line
+        Loaded = 'L'   // background instrument load finished; key = symbol, payload "1"/"0"
+    };
+
+    struct Record
+    {
+        RecordKind kind{RecordKind::Meta};
+        std::int64_t timeUs{0};
+        std::string key;
+        std::string payload;
+    };
+
+    // Thread-safe: the socket loop, the command reader and instrument loads all append.
+    class FrameLogWriter
+    {
+    public:
+        // Truncates `path`. Throws std::runtime_error if it cannot be opened.
+        explicit FrameLogWriter(const std::string& path);
+        ~FrameLogWriter();
+
+        // Flushes when the previous flush is 200 ms older than timeUs.
+        void append(RecordKind kind, std::int64_t timeUs, std::string_view key, std::string_view payload);
+        // Flushes records still buffered if the last flush is 200 ms older than
+        // nowUs, so a quiet session's tail reaches the file without a later append.
+        void flushIfDue(std::int64_t nowUs);
+        void flush();
+
+    private:
+        std::mutex mutex_;
+        std::ofstream out_;
+        std::int64_t lastFlushUs_{0};
+        bool unflushed_{false};
+    };
+
+    class FrameLogReader
+    {
+    public:
+        // Throws std::runtime_error if `path` is missing or not a capture file.
+        explicit FrameLogReader(const std::string& path);
+
+        // False at the end of the file. A record cut short by a killed writer counts
+        // as the end, with a warning.
+        bool next(Record& out);
+        // Back to the first record.
+        void rewind();
+
+    private:
+        std::string path_;
+        std::ifstream in_;
+    };
+} // namespace dom
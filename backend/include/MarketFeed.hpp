@@ -0,0 +1,246 @@
+#pragma once
+
+#include "CommandChannel.hpp"
+#include "MexcProto.hpp"
+#include "OrderBook.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dom
+{
+    enum class Venue
+    {
+        Mexc,
+        UzxSpot,
+        UzxSwap
+    };
+
+    // How one consumer (a ladder column in the GUI) wants a symbol's book rendered.
+    struct StreamSettings
+    {
+        std::string symbol;
+        std::size_t levelsPerSide{120};
+        std::size_t compression{1};
+        std::chrono::milliseconds throttle{50};
+    };
+
+    // Where one book update spent its time inside the backend. Microseconds since
+    // the Unix epoch on the local clock; 0 when a stage is unknown.
+    struct FrameTrace
+    {
+        std::int64_t exchangeUs{0}; // exchange send time, corrected by the clock offset
+        std::int64_t receivedUs{0}; // frame returned by the socket
+        std::int64_t decodedUs{0};  // protobuf/JSON decoded
+        std::int64_t appliedUs{0};  // applied to the OrderBook
+    };
+
+    // Books of symbols no stream shows any more, kept subscribed and current so a
+    // column flipping back to one gets its ladder without a REST reload.
+    struct WarmCacheStats
+    {
+        std::uint64_t hits{0};      // subscribes answered from a resident book
+        std::uint64_t misses{0};    // subscribes that had to load the book
+        std::uint64_t evictions{0}; // warm books dropped for the caps below
+        std::size_t symbols{0};     // warm books right now
+        std::size_t bytes{0};       // their estimated size
+    };
+
+    // Exchange-side state of one backend process: one OrderBook per subscribed
+    // symbol, any number of output streams on top of them. The transport owns the
+    // socket and pushes raw frames in; everything that reaches stdout is a JSON line
+    // tagged with the stream id it belongs to.
+    //
+    // All public members are thread-safe. Frames, commands and background
+    // instrument loads are serialised on one mutex.
+    class MarketFeed : public std::enable_shared_from_this<MarketFeed>
+    {
+    public:
+        // Sends one text frame on the exchange socket.
+        using SendText = std::function<bool(const std::string&)>;
+        // Fetches tick size and a REST snapshot for `symbol` into `book` (blocking).
+        using LoadInstrument = std::function<bool(const std::string& symbol, OrderBook& book)>;
+        // Runs a background instrument load for `symbol`; by default on a detached thread.
+        using SpawnLoad = std::function<void(const std::string& symbol, std::function<void()> load)>;
+        // Fetches `symbol`'s instrument metadata ahead of a subscribe (blocking).
+        using PrefetchInstrument = std::function<void(const std::string& symbol)>;
+        // Time base for throttling and back-pressure; steady_clock::now by default.
+        using Clock = std::function<std::chrono::steady_clock::time_point()>;
+        // Source of the FrameTrace stamps; wallClockUs by default.
+        using TraceClock = std::int64_t (*)();
+        // Sees every book update applied from a frame, with the trace clock right after
+        // the ladders it triggered were written (none when every stream was throttled).
+        using UpdateObserver = std::function<void(const FrameTrace& trace, std::size_t ladders, std::int64_t doneAt)>;
+
+        MarketFeed(Venue venue, std::ostream& out, LoadInstrument load);
+
+        // Adds or retargets a stream; the first stream on a symbol subscribes it and
+        // loads its book in the background.
+        void addStream(int id, StreamSettings settings);
+        // Same, with a book the caller already loaded (the startup symbol).
+        void addStream(int id, StreamSettings settings, OrderBook book);
+        void handleCommand(const Command& cmd);
+
+        // Transport hooks. attachSocket() (re)subscribes every resident symbol and
+        // reloads the books a dropped connection left stale; detachSocket() marks
+        // every book stale until then.
+        void attachSocket(SendText send);
+        void detachSocket();
+        // `receivedUs` is wallClockUs() taken as the socket returned the frame.
+        void onBinaryFrame(const void* data, std::size_t len, std::int64_t receivedUs);
+        void onTextFrame(std::string_view text, std::int64_t receivedUs);
+
+        // Exchange clock minus local clock, used to place exchange send times on the
+        // local timeline in ladder traces.
+        void setExchangeClockOffsetMs(double offsetMs);
+
+        // Once a second while live: a "heartbeat" line per stream, a keep-alive ping
+        // where the venue wants one from the client, and a retry of failed reloads.
+        void heartbeat();
+        // Time since the socket last delivered a frame; zero while detached or with
+        // nothing subscribed.
+        [[nodiscard]] std::chrono::milliseconds socketIdle() const;
+
+        // Replay hooks: recorded time instead of the real clock, and loads finished at
+        // the point the capture saw them finish. Set before the first stream.
+        void setClock(Clock clock);
+        void setLoadSpawner(SpawnLoad spawn);
+        // Handler for "prefetch" commands, run on a detached thread; without one
+        // (replay, bench) they are ignored.
+        void setPrefetcher(PrefetchInstrument prefetch);
+
+        // --bench hooks: a finer trace clock (the fields then hold its units, not
+        // microseconds) and per-update timings.
+        void setTraceClock(TraceClock clock);
+        void setUpdateObserver(UpdateObserver observer);
+
+        // At most `symbols` warm books taking at most `bytes` together; the least
+        // recently shown goes first. 0 symbols frees a book with its last stream.
+        void setWarmCache(std::size_t symbols, std::size_t bytes);
+
+        [[nodiscard]] std::size_t streamCount() const;
+        [[nodiscard]] std::size_t symbolCount() const; // warm books included
+        [[nodiscard]] WarmCacheStats warmCacheStats() const;
+
+    private:
+        struct PendingFrame
+        {
+            std::string data;
+            std::int64_t receivedUs{0};
+        };
+
+        enum class DepthResult
+        {
+            Ignored, // not a depth push, or already covered by the book's version
+            Applied,
+            Gap      // updates between the book and this push were missed
+        };
+
+        struct SymbolBook
+        {
+            OrderBook book;
+            bool ready{false};
+            FrameTrace lastTrace; // update behind the book's current state
+            // No stream on the symbol; still subscribed and updated. Ordered by
+            // warmSince for eviction (smallest = least recently shown).
+            bool warm{false};
+            std::uint64_t warmSince{0};
+            // Missed updates while the socket was down; cleared by the next full book
+            // (a REST reload on MEXC, the next push on UZX).
+            bool stale{false};
+            std::uint64_t loadId{0}; // load in flight, 0 if none
+            // Depth frames received while the load was in flight, raw: the tick size
+            // may only arrive with the load. finishLoad() replays those newer than the
+            // snapshot.
+            std::deque<PendingFrame> pending;
+        };
+
+        struct Stream
+        {
+            StreamSettings settings;
+            std::chrono::steady_clock::time_point lastEmit{};
+            // Command to acknowledge once the symbol's book has loaded; empty if none.
+            std::string pendingAck;
+
+            // Consumer feedback (consumer-report). Until the first report arrives the
+            // stream runs at settings.throttle with no back-pressure, as before.
+            std::uint64_t seq{0};         // last ladder emitted
+            std::uint64_t renderedSeq{0}; // last ladder the consumer painted
+            bool reported{false};
+            bool visible{true};
+            bool dirty{false};            // book changed since the last emitted ladder
+            double paintMs{0.0};          // smoothed paint time
+        };
+
+        void subscribeLocked(int id, StreamSettings settings, const char* ackCmd);
+        void unsubscribeLocked(int id);
+        void releaseSymbolLocked(const std::string& symbol);
+        void dropSymbolLocked(const std::string& symbol);
+        // Evicts warm books until both caps hold, plus room for `reserve` more symbols
+        // under the MEXC channel limit.
+        void trimWarmLocked(std::size_t reserve);
+        [[nodiscard]] WarmCacheStats warmCacheStatsLocked() const;
+        void loadAsync(const std::string& symbol);
+        void finishLoad(const std::string& symbol, std::uint64_t loadId, OrderBook&& book, bool ok);
+        // Decodes a MEXC depth push onto entry.book, filling `trace` up to decodedUs.
+        DepthResult applyDepthLocked(const std::string& symbol, SymbolBook& entry, const void* data,
+                                     std::size_t len, std::int64_t receivedUs, FrameTrace& trace);
+
+        void emitLadderLocked(int id, Stream& stream, const SymbolBook& entry, const FrameTrace* trace = nullptr);
+        void emitIfDueLocked(int id, Stream& stream, const SymbolBook& entry, const FrameTrace& trace);
+        // Heartbeat lines for every stream, or only those on `symbol`.
+        void emitHeartbeatsLocked(const std::string* symbol = nullptr);
+        // Stamps `trace` as applied, keeps it with the book and emits to due streams.
+        void publishLocked(const std::string& symbol, SymbolBook& entry, FrameTrace& trace);
+        void onConsumerReportLocked(int id, Stream& stream, const Command& cmd);
+        [[nodiscard]] static std::chrono::milliseconds emitIntervalOf(const Stream& stream);
+        // `cache` ("hit"/"miss") tells the consumer whether the book was resident;
+        // `error` why a failed command failed, when it is something the user can act on.
+        void emitAckLocked(int id, const std::string& cmd, bool ok, const std::string& symbol,
+                           const char* cache = nullptr, const char* error = nullptr);
+
+        [[nodiscard]] std::string subscriptionMessage(bool subscribe, const std::string& symbol) const;
+        [[nodiscard]] std::size_t levelsHintLocked(const std::string& symbol) const;
+
+        Venue venue_;
+        std::ostream& out_;
+        LoadInstrument load_;
+        SpawnLoad spawnLoad_;
+        PrefetchInstrument prefetch_;
+        Clock clock_;
+        TraceClock traceClock_;
+        UpdateObserver observer_;
+        SendText send_;
+        std::int64_t clockOffsetUs_{0};
+        std::chrono::steady_clock::time_point lastFrame_{};
+        std::chrono::steady_clock::time_point lastPing_{};
+        std::uint64_t loadCounter_{0};
+        mutable std::mutex mutex_;
+        std::map<std::string, SymbolBook, std::less<>> books_;
+        std::map<int, Stream> streams_;
+        std::size_t warmSymbols_{6};
+        std::size_t warmBytes_{16u << 20};
+        std::uint64_t warmClock_{0};
+        WarmCacheStats warmStats_; // hits, misses and evictions; sizes are computed
+
+        // Scratch buffers reused across frames (guarded by mutex_).
+        std::string channel_;
+        std::vector<std::pair<OrderBook::Tick, double>> asks_;
+        std::vector<std::pair<OrderBook::Tick, double>> bids_;
+        std::vector<PublicAggreDeal> deals_;
+    };
+
+    [[nodiscard]] std::int64_t wallClockMs();
+    [[nodiscard]] std::int64_t wallClockUs();
+} // namespace dom
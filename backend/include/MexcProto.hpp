@@ -0,0 +1,56 @@
+#pragma once
+
+#include "OrderBook.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dom
+{
+    // Minimal decoders for the MEXC PushDataV3ApiWrapper messages we subscribe to
+    // (see wsproto/websocket-proto-main). Prices are converted to ticks on the way in.
+
+    struct PublicAggreDeal
+    {
+        double price{};
+        double quantity{};
+        bool buy{};
+        std::int64_t time{};
+    };
+
+    // Returns the wrapper's channel (field 1) without copying; empty if absent.
+    [[nodiscard]] std::string_view peekChannel(const void* data, std::size_t len);
+
+    // Wrapper sendTime (field 6, exchange ms since epoch), else createTime (field 5); 0 if absent.
+    [[nodiscard]] std::int64_t peekSendTime(const void* data, std::size_t len);
+
+    // Symbol is the last "@"-separated component of a push channel name.
+    [[nodiscard]] std::string_view symbolFromChannel(std::string_view channel);
+
+    // Update ids a depth push covers: it moves the book from version from - 1 to
+    // version to. 0 when the frame does not carry them.
+    struct DepthVersions
+    {
+        std::uint64_t from{};
+        std::uint64_t to{};
+    };
+
+    // publicAggreDepths (field 313): fills asks/bids with (tick, qty) pairs.
+    bool parsePushWrapper(const void* data,
+                          std::size_t len,
+                          std::string& channelOut,
+                          double tickSize,
+                          std::vector<std::pair<OrderBook::Tick, double>>& asks,
+                          std::vector<std::pair<OrderBook::Tick, double>>& bids,
+                          DepthVersions& versions);
+
+    // publicAggreDeals (field 314). Returns false when the frame carries no deals.
+    bool parseDealsFromWrapper(const void* data,
+                               std::size_t len,
+                               std::string& channelOut,
+                               std::vector<PublicAggreDeal>& deals);
+} // namespace dom
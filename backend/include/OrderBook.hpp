@@ -39,6 +39,13 @@ namespace dom
         [[nodiscard]] double bestAsk() const;
         [[nodiscard]] double tickSize() const;
 
+        // Exchange update id the book reflects (REST lastUpdateId, then each delta's
+        // toVersion); 0 if the venue does not version its updates.
+        void setVersion(std::uint64_t version);
+        [[nodiscard]] std::uint64_t version() const;
+        // Price levels held on both sides, for memory accounting.
+        [[nodiscard]] std::size_t levelCount() const;
+
         [[nodiscard]] std::vector<Level> ladder(std::size_t levelsPerSide) const;
 
     private:
@@ -47,6 +54,7 @@ namespace dom
         BookSide bids_; // key: tick index, value: qty
         BookSide asks_;
         double tickSize_{0.0};
+        std::uint64_t version_{0};
 
         // Center of the ladder in ticks; adjusted slowly to avoid jumping.
         mutable Tick centerTick_{0};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dom
+{
+    // A venue's WebSocket or REST server. Defaults to the real exchange;
+    // --endpoint / --rest-endpoint point it elsewhere (e.g. scripts/mock_exchange.py).
+    struct Endpoint
+    {
+        bool secure{true};
+        std::string host;
+        std::uint16_t port{443};
+        std::string path; // WebSocket only
+    };
+
+    // scheme://host[:port][/path] with scheme ws, wss, http or https.
+    // Throws std::runtime_error on anything else.
+    Endpoint parseEndpoint(const std::string& url);
+
+    enum class MessageType
+    {
+        Text,
+        Binary
+    };
+
+    class WebSocket;
+
+    // Callbacks of one WebSocket. They run on a transport thread, never two at once
+    // for the same socket.
+    struct WebSocketHandler
+    {
+        // `socket` is the one connect() returned, usable until onClose returns; it
+        // may run before connect() itself has returned.
+        std::function<void(WebSocket& socket)> onOpen;
+        // One whole message, fragments already joined. `receivedUs` is wallClockUs()
+        // when its first byte came off the socket.
+        std::function<void(MessageType type, std::string_view payload, std::int64_t receivedUs)> onMessage;
+        // Last callback of the socket, whether the server, the network, close() or
+        // Transport::stop() ended it, and also when it never got to onOpen.
+        std::function<void(const std::string& reason)> onClose;
+    };
+
+    class WebSocket
+    {
+    public:
+        virtual ~WebSocket() = default;
+
+        // Thread-safe. False once the socket is closing.
+        virtual bool sendText(std::string_view text) = 0;
+        // Thread-safe. onClose follows.
+        virtual void close() = 0;
+    };
+
+    // Network access for the backend: blocking REST calls and event-driven
+    // WebSockets. WinHTTP on Windows (a thread per socket); elsewhere non-blocking
+    // sockets on one epoll thread, with TLS when built with OpenSSL.
+    class Transport
+    {
+    public:
+        virtual ~Transport() = default;
+
+        // Blocking GET on the calling thread; the body whatever the status, or
+        // nullopt (after logging why) when no response arrived.
+        virtual std::optional<std::string> httpGet(const Endpoint& server, const std::string& pathAndQuery) = 0;
+
+        // Starts a WebSocket to server.host:port/path. Null (after logging why) when
+        // it cannot even be started; later failures arrive as onClose.
+        virtual std::shared_ptr<WebSocket> connect(const Endpoint& server, WebSocketHandler handler) = 0;
+
+        // Services sockets on the calling thread until none is left or stop() is called.
+        virtual void run() = 0;
+        // Thread-safe. Closes every socket and makes run() return.
+        virtual void stop() = 0;
+    };
+
+    [[nodiscard]] std::unique_ptr<Transport> makeTransport();
+} // namespace dom
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace dom::ws
+{
+    // RFC 6455 client side: handshake key, masked client frames and a parser for
+    // the (unmasked) frames a server sends. No I/O here; the transports own that.
+
+    enum class Opcode : std::uint8_t
+    {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    // Fresh Sec-WebSocket-Key: 16 random bytes, base64.
+    [[nodiscard]] std::string makeClientKey();
+    // The Sec-WebSocket-Accept a server must answer `clientKey` with.
+    [[nodiscard]] std::string acceptFor(std::string_view clientKey);
+
+    // Appends one FIN frame, masked with a fresh key as clients must.
+    void appendClientFrame(std::string& out, Opcode opcode, std::string_view payload);
+
+    // Incremental parser for server frames. Bytes go in as the socket returns them;
+    // whole messages (fragments joined) and control frames come out.
+    class FrameParser
+    {
+    public:
+        struct Message
+        {
+            Opcode opcode{Opcode::Text}; // never Continuation
+            std::string payload;
+            // `receivedUs` of the read that delivered the message's first byte.
+            std::int64_t receivedUs{0};
+        };
+
+        enum class Status
+        {
+            Message,
+            NeedMore,
+            Error // protocol violation; error() says which, the connection is unusable
+        };
+
+        explicit FrameParser(std::size_t maxMessage = 16 * 1024 * 1024);
+
+        void feed(const char* data, std::size_t len, std::int64_t receivedUs);
+        // Call until it stops returning Message.
+        Status next(Message& out);
+        [[nodiscard]] const std::string& error() const { return error_; }
+
+    private:
+        std::string buffer_;
+        std::size_t offset_{0};
+        std::int64_t headUs_{0}; // receivedUs of buffer_[offset_]
+        std::int64_t lastFeedUs_{0};
+
+        std::string fragments_;
+        Opcode fragmentOpcode_{Opcode::Text};
+        bool inFragment_{false};
+        std::int64_t fragmentUs_{0};
+
+        std::size_t maxMessage_;
+        std::string error_;
+    };
+} // namespace dom::ws
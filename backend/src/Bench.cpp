@@ -0,0 +1,366 @@
+#include "Bench.hpp"
+
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#    include <psapi.h>
+#else
+#    include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include <json.hpp>
+
+namespace dom
+{
+    namespace
+    {
+        using json = nlohmann::json;
+
+        void putVarint(std::string& out, std::uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        void putBytes(std::string& out, std::uint32_t field, std::string_view bytes)
+        {
+            putVarint(out, (static_cast<std::uint64_t>(field) << 3) | 2);
+            putVarint(out, bytes.size());
+            out.append(bytes);
+        }
+
+        void putUint(std::string& out, std::uint32_t field, std::uint64_t value)
+        {
+            putVarint(out, static_cast<std::uint64_t>(field) << 3);
+            putVarint(out, value);
+        }
+
+        std::string priceText(std::int64_t tick)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.2f", static_cast<double>(tick) / 100.0);
+            return buf;
+        }
+
+        std::string qtyText(double qty)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.4f", qty);
+            return buf;
+        }
+
+        // PushDataV3ApiWrapper around one body message (see MexcProto.hpp).
+        std::string wrapper(const std::string& channel, std::uint32_t bodyField, const std::string& body, std::int64_t timeMs)
+        {
+            std::string out;
+            putBytes(out, 1, channel);
+            putBytes(out, bodyField, body);
+            putUint(out, 5, static_cast<std::uint64_t>(timeMs));
+            putUint(out, 6, static_cast<std::uint64_t>(timeMs));
+            return out;
+        }
+
+        struct SyntheticSymbol
+        {
+            std::string name;
+            std::int64_t mid{10000}; // 100.00 at a 0.01 tick
+            std::uint64_t version{1}; // lastUpdateId of the snapshot, then each push's toVersion
+        };
+
+        std::int64_t percentile(std::vector<std::int64_t>& v, double p)
+        {
+            if (v.empty())
+            {
+                return 0;
+            }
+            const auto rank = static_cast<std::size_t>(p * static_cast<double>(v.size() - 1));
+            std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(rank), v.end());
+            return v[rank];
+        }
+    } // namespace
+
+#ifndef SHAH_BACKEND_BENCH
+    // BenchAllocator.cpp provides these in a SHAH_BACKEND_BENCH build.
+    std::uint64_t threadAllocations()
+    {
+        return 0;
+    }
+
+    bool countsAllocations()
+    {
+        return false;
+    }
+#endif
+
+    std::uint64_t peakRssBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.PeakWorkingSetSize;
+        }
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#    ifdef __APPLE__
+        return static_cast<std::uint64_t>(usage.ru_maxrss);
+#    else
+        return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#    endif
+#endif
+    }
+
+    std::int64_t steadyNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    std::vector<Record> syntheticMexcSession(const SyntheticSessionOptions& options)
+    {
+        std::mt19937 rng(12345);
+        std::uniform_real_distribution<double> qty(0.01, 250.0);
+        std::geometric_distribution<int> offset(0.12); // most changes near the touch
+        std::uniform_int_distribution<int> coin(0, 99);
+
+        const std::size_t symbolCount = std::max<std::size_t>(1, options.symbols);
+        std::vector<SyntheticSymbol> symbols(symbolCount);
+        for (std::size_t i = 0; i < symbolCount; ++i)
+        {
+            symbols[i].name = "BENCH" + std::to_string(i) + "USDT";
+        }
+
+        std::vector<Record> out;
+        out.reserve(1 + symbolCount * 4 + options.frames);
+        std::int64_t nowUs = wallClockUs();
+
+        auto add = [&out](RecordKind kind, std::int64_t timeUs, std::string key, std::string payload) {
+            Record r;
+            r.kind = kind;
+            r.timeUs = timeUs;
+            r.key = std::move(key);
+            r.payload = std::move(payload);
+            out.push_back(std::move(r));
+        };
+
+        const json meta = {{"exchange", "mexc"},
+                           {"symbol", symbols.front().name},
+                           {"multiplex", true},
+                           {"levels", options.levelsPerSide},
+                           {"compression", options.compression},
+                           {"throttleMs", options.throttleMs},
+                           {"snapshotDepth", options.snapshotDepth}};
+        add(RecordKind::Meta, nowUs, {}, meta.dump());
+
+        for (std::size_t i = 0; i < symbolCount; ++i)
+        {
+            const std::string& name = symbols[i].name;
+            const json info = {{"symbols", json::array({{{"symbol", name}, {"quotePrecision", 2}}})}};
+            add(RecordKind::Rest, nowUs, "/api/v3/exchangeInfo?symbol=" + name, info.dump());
+
+            json bids = json::array();
+            json asks = json::array();
+            for (std::size_t level = 1; level <= options.snapshotDepth; ++level)
+            {
+                const auto d = static_cast<std::int64_t>(level);
+                bids.push_back({priceText(symbols[i].mid - d + 1), qtyText(qty(rng))});
+                asks.push_back({priceText(symbols[i].mid + d), qtyText(qty(rng))});
+            }
+            const json depth = {{"lastUpdateId", 1}, {"bids", bids}, {"asks", asks}};
+            add(RecordKind::Rest,
+                nowUs,
+                "/api/v3/depth?symbol=" + name + "&limit=" + std::to_string(options.snapshotDepth),
+                depth.dump());
+
+            const json subscribe = {{"cmd", "subscribe"},
+                                    {"stream", i},
+                                    {"symbol", name},
+                                    {"levels", options.levelsPerSide},
+                                    {"compression", options.compression}};
+            add(RecordKind::Command, nowUs, {}, subscribe.dump());
+            add(RecordKind::Loaded, nowUs, name, "1");
+        }
+
+        const std::int64_t stepUs = std::max<std::int64_t>(1, 100'000 / static_cast<std::int64_t>(symbolCount));
+        for (std::size_t f = 0; f < options.frames; ++f)
+        {
+            nowUs += stepUs;
+            SyntheticSymbol& sym = symbols[f % symbolCount];
+            const std::int64_t timeMs = nowUs / 1000;
+
+            // One frame in five carries trades, the rest depth changes.
+            if (coin(rng) < 20)
+            {
+                std::string deals;
+                for (int t = 0; t < 3; ++t)
+                {
+                    const bool buy = coin(rng) < 50;
+                    std::string deal;
+                    putBytes(deal, 1, priceText(buy ? sym.mid + 1 : sym.mid));
+                    putBytes(deal, 2, qtyText(qty(rng) / 10.0));
+                    putUint(deal, 3, buy ? 1 : 2);
+                    putUint(deal, 4, static_cast<std::uint64_t>(timeMs));
+                    putBytes(deals, 1, deal);
+                }
+                putBytes(deals, 2, "spot@public.aggre.deals.v3.api.pb@100ms");
+                add(RecordKind::Binary,
+                    nowUs,
+                    {},
+                    wrapper("spot@public.aggre.deals.v3.api.pb@100ms@" + sym.name, 314, deals, timeMs));
+                continue;
+            }
+
+            if (coin(rng) < 10)
+            {
+                sym.mid += coin(rng) < 50 ? -1 : 1;
+            }
+            std::string depth;
+            for (int c = 0; c < 10; ++c)
+            {
+                const bool ask = coin(rng) < 50;
+                const std::int64_t d = 1 + offset(rng);
+                const std::int64_t tick = ask ? sym.mid + d : sym.mid - d + 1;
+                // Some changes empty a level, as real deltas do.
+                const double q = coin(rng) < 20 ? 0.0 : qty(rng);
+                std::string item;
+                putBytes(item, 1, priceText(tick));
+                putBytes(item, 2, qtyText(q));
+                putBytes(depth, ask ? 1 : 2, item);
+            }
+            putBytes(depth, 3, "spot@public.aggre.depth.v3.api.pb@100ms");
+            ++sym.version;
+            putBytes(depth, 4, std::to_string(sym.version));
+            putBytes(depth, 5, std::to_string(sym.version));
+            add(RecordKind::Binary,
+                nowUs,
+                {},
+                wrapper("spot@public.aggre.depth.v3.api.pb@100ms@" + sym.name, 313, depth, timeMs));
+        }
+        return out;
+    }
+
+    BenchStats::BenchStats(std::size_t frames)
+    {
+        for (auto& s : samples_)
+        {
+            s.reserve(frames);
+        }
+    }
+
+    void BenchStats::onFrame(bool depth, std::int64_t ns, std::uint64_t allocations)
+    {
+        samples_[depth ? DepthFrame : DealsFrame].push_back(ns);
+        ++frames_;
+        allocations_ += allocations;
+    }
+
+    void BenchStats::onUpdate(const FrameTrace& trace, std::size_t ladders, std::int64_t doneNs)
+    {
+        ++updates_;
+        samples_[Decode].push_back(trace.decodedUs - trace.receivedUs);
+        samples_[Apply].push_back(trace.appliedUs - trace.decodedUs);
+        if (ladders > 0)
+        {
+            samples_[Emit].push_back(doneNs - trace.appliedUs);
+            ladders_ += ladders;
+        }
+    }
+
+    void BenchStats::report(std::ostream& text,
+                            std::ostream& out,
+                            std::int64_t elapsedNs,
+                            std::uint64_t outputBytes,
+                            std::size_t symbols) const
+    {
+        static const char* const names[StageCount] = {"depth frame", "deals frame", "decode", "apply", "emit"};
+        static const char* const keys[StageCount] = {"depthFrame", "dealsFrame", "decode", "apply", "emit"};
+
+        const double seconds = static_cast<double>(std::max<std::int64_t>(1, elapsedNs)) / 1e9;
+        const double perFrame = frames_ ? 1.0 / static_cast<double>(frames_) : 0.0;
+        const double framesPerSec = static_cast<double>(frames_) / seconds;
+        const std::uint64_t rss = peakRssBytes();
+        auto us = [](std::int64_t ns) { return static_cast<double>(ns) / 1000.0; };
+
+        json j;
+        j["type"] = "bench";
+        j["frames"] = frames_;
+        j["symbols"] = symbols;
+        j["seconds"] = seconds;
+        j["framesPerSec"] = framesPerSec;
+        j["updates"] = updates_;
+        j["ladders"] = ladders_;
+        if (countsAllocations())
+        {
+            j["allocationsPerFrame"] = static_cast<double>(allocations_) * perFrame;
+        }
+        else
+        {
+            j["allocationsPerFrame"] = nullptr;
+        }
+        j["bytesPerFrame"] = static_cast<double>(outputBytes) * perFrame;
+        j["peakRssBytes"] = rss;
+
+        char line[160];
+        std::snprintf(line,
+                      sizeof(line),
+                      "[bench] %llu frames over %zu symbols in %.3f s: %.0f frames/s\n",
+                      static_cast<unsigned long long>(frames_),
+                      symbols,
+                      seconds,
+                      framesPerSec);
+        text << line << "[bench] per frame, us:     p50      p99      max      n\n";
+        for (int i = 0; i < StageCount; ++i)
+        {
+            std::vector<std::int64_t> v = samples_[i];
+            if (v.empty())
+            {
+                continue;
+            }
+            const std::int64_t p50 = percentile(v, 0.50);
+            const std::int64_t p99 = percentile(v, 0.99);
+            const std::int64_t max = *std::max_element(v.begin(), v.end());
+            std::snprintf(line,
+                          sizeof(line),
+                          "  %-12s %10.2f %8.2f %8.1f %7zu\n",
+                          names[i],
+                          us(p50),
+                          us(p99),
+                          us(max),
+                          v.size());
+            text << line;
+            j["stages"][keys[i]] = {{"p50Us", us(p50)}, {"p99Us", us(p99)}, {"maxUs", us(max)}, {"count", v.size()}};
+        }
+        char allocations[48] = "allocations not counted";
+        if (countsAllocations())
+        {
+            std::snprintf(allocations,
+                          sizeof(allocations),
+                          "%.1f allocations/frame",
+                          static_cast<double>(allocations_) * perFrame);
+        }
+        std::snprintf(line,
+                      sizeof(line),
+                      "[bench] %llu ladders, %s, %.0f output bytes/frame, peak RSS %.1f MB\n",
+                      static_cast<unsigned long long>(ladders_),
+                      allocations,
+                      static_cast<double>(outputBytes) * perFrame,
+                      static_cast<double>(rss) / (1024.0 * 1024.0));
+        text << line << std::flush;
+        out << j.dump() << std::endl;
+    }
+} // namespace dom
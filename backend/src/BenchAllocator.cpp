@@ -0,0 +1,69 @@
+// Heap allocation counting for --bench (-DSHAH_BACKEND_BENCH=ON builds only).
+// Replacing the global operator new costs every allocation a thread-local
+// increment and the platform allocator, so production builds leave it out.
+
+#include "Bench.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local std::uint64_t allocationCount = 0;
+
+    void* countedAlloc(std::size_t size)
+    {
+        ++allocationCount;
+        if (void* p = std::malloc(size ? size : 1))
+        {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+} // namespace
+
+// Counting replacements for the global allocation functions. The nothrow forms
+// forward here by default; over-aligned allocations keep the library's own pair.
+void* operator new(std::size_t size)
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace dom
+{
+    std::uint64_t threadAllocations()
+    {
+        return allocationCount;
+    }
+
+    bool countsAllocations()
+    {
+        return true;
+    }
+} // namespace dom
@@ -0,0 +1,218 @@
+#include "CommandChannel.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+#include <json.hpp>
+
+namespace dom
+{
+    namespace
+    {
+        using json = nlohmann::json;
+
+        bool readPositive(const json& j, const char* key, std::int64_t& out, std::string& error)
+        {
+            const auto it = j.find(key);
+            if (it == j.end() || !it->is_number_integer() || it->get<std::int64_t>() < 0)
+            {
+                error = std::string("missing or invalid \"") + key + "\"";
+                return false;
+            }
+            out = it->get<std::int64_t>();
+            return true;
+        }
+    } // namespace
+
+    const char* commandName(Command::Type type)
+    {
+        switch (type)
+        {
+        case Command::Type::Subscribe:
+            return "subscribe";
+        case Command::Type::Unsubscribe:
+            return "unsubscribe";
+        case Command::Type::SetLevels:
+            return "set-levels";
+        case Command::Type::SetCompression:
+            return "set-compression";
+        case Command::Type::SetThrottle:
+            return "set-throttle";
+        case Command::Type::ResubscribeSymbol:
+            return "resubscribe-symbol";
+        case Command::Type::RequestKeyframe:
+            return "request-keyframe";
+        case Command::Type::ConsumerReport:
+            return "consumer-report";
+        case Command::Type::Prefetch:
+            return "prefetch";
+        }
+        return "unknown";
+    }
+
+    bool parseCommand(std::string_view line, Command& out, std::string& error)
+    {
+        json j;
+        try
+        {
+            j = json::parse(line.begin(), line.end());
+        }
+        catch (const std::exception& ex)
+        {
+            error = ex.what();
+            return false;
+        }
+
+        if (!j.is_object())
+        {
+            error = "command is not an object";
+            return false;
+        }
+
+        const std::string cmd = j.value("cmd", std::string());
+        out = Command{};
+        if (j.contains("stream"))
+        {
+            std::int64_t stream = 0;
+            if (!readPositive(j, "stream", stream, error))
+            {
+                return false;
+            }
+            out.stream = static_cast<int>(stream);
+        }
+
+        if (cmd == "subscribe")
+        {
+            out.type = Command::Type::Subscribe;
+            out.symbol = j.value("symbol", std::string());
+            if (out.symbol.empty())
+            {
+                error = "missing \"symbol\"";
+                return false;
+            }
+            if (!readPositive(j, "levels", out.value, error))
+            {
+                return false;
+            }
+            if (j.contains("compression") && !readPositive(j, "compression", out.compression, error))
+            {
+                return false;
+            }
+            const auto reloadIt = j.find("reload");
+            out.reload = reloadIt != j.end() && reloadIt->is_boolean() && reloadIt->get<bool>();
+            return true;
+        }
+        if (cmd == "unsubscribe")
+        {
+            out.type = Command::Type::Unsubscribe;
+            return true;
+        }
+        if (cmd == "set-levels")
+        {
+            out.type = Command::Type::SetLevels;
+            return readPositive(j, "levels", out.value, error);
+        }
+        if (cmd == "set-compression")
+        {
+            out.type = Command::Type::SetCompression;
+            return readPositive(j, "factor", out.value, error);
+        }
+        if (cmd == "set-throttle")
+        {
+            out.type = Command::Type::SetThrottle;
+            return readPositive(j, "ms", out.value, error);
+        }
+        if (cmd == "resubscribe-symbol")
+        {
+            out.type = Command::Type::ResubscribeSymbol;
+            out.symbol = j.value("symbol", std::string());
+            if (out.symbol.empty())
+            {
+                error = "missing \"symbol\"";
+                return false;
+            }
+            return true;
+        }
+        if (cmd == "request-keyframe")
+        {
+            out.type = Command::Type::RequestKeyframe;
+            return true;
+        }
+        if (cmd == "consumer-report")
+        {
+            out.type = Command::Type::ConsumerReport;
+            if (!readPositive(j, "seq", out.value, error))
+            {
+                return false;
+            }
+            const auto paintIt = j.find("paintMs");
+            if (paintIt != j.end() && paintIt->is_number())
+            {
+                out.paintMs = std::max(0.0, paintIt->get<double>());
+            }
+            const auto visibleIt = j.find("visible");
+            if (visibleIt != j.end() && visibleIt->is_boolean())
+            {
+                out.visible = visibleIt->get<bool>();
+            }
+            return true;
+        }
+
+        if (cmd == "prefetch")
+        {
+            out.type = Command::Type::Prefetch;
+            out.symbol = j.value("symbol", std::string());
+            if (out.symbol.empty())
+            {
+                error = "missing \"symbol\"";
+                return false;
+            }
+            return true;
+        }
+
+        error = "unknown command '" + cmd + "'";
+        return false;
+    }
+
+    void startCommandReader(std::istream& in,
+                            std::function<void(const Command&)> handler,
+                            std::function<void(std::string_view line)> onLine,
+                            std::function<void()> onEnd)
+    {
+        // Detached on purpose: the thread sits in a blocking read on stdin and must not
+        // keep the process alive (or call std::terminate) when main() returns.
+        std::thread([&in, handler = std::move(handler), onLine = std::move(onLine), onEnd = std::move(onEnd)]() {
+            std::string line;
+            while (std::getline(in, line))
+            {
+                if (!line.empty() && line.back() == '\r')
+                {
+                    line.pop_back();
+                }
+                if (line.empty())
+                {
+                    continue;
+                }
+
+                Command cmd;
+                std::string error;
+                if (!parseCommand(line, cmd, error))
+                {
+                    std::cerr << "[backend] bad command: " << error << std::endl;
+                    continue;
+                }
+                if (onLine)
+                {
+                    onLine(line);
+                }
+                handler(cmd);
+            }
+            if (onEnd)
+            {
+                onEnd();
+            }
+        }).detach();
+    }
+} // namespace dom
@@ -0,0 +1,983 @@
+#include "MarketFeed.hpp"
+#include "Transport.hpp"
+#include "WebSocketCodec.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef SHAH_BACKEND_TLS
+#    include <openssl/err.h>
+#    include <openssl/ssl.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace dom
+{
+    namespace
+    {
+        constexpr std::size_t kReadChunk = 256 * 1024;
+        constexpr int kHttpTimeoutSec = 15;
+
+        std::string sysError(const char* where)
+        {
+            return std::string(where) + ": " + std::strerror(errno);
+        }
+
+        // Resolves and connects a TCP socket; non-blocking sockets come back with the
+        // connect still in progress. -1 (after logging) on failure.
+        int openSocket(const Endpoint& server, bool nonBlocking)
+        {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* found = nullptr;
+            const std::string port = std::to_string(server.port);
+            // Name lookup blocks; connects happen at startup and on resubscribe, not per frame.
+            if (const int rc = getaddrinfo(server.host.c_str(), port.c_str(), &hints, &found); rc != 0)
+            {
+                std::cerr << "[backend] resolve " << server.host << ": " << gai_strerror(rc) << std::endl;
+                return -1;
+            }
+
+            int fd = -1;
+            for (addrinfo* ai = found; ai; ai = ai->ai_next)
+            {
+                fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | (nonBlocking ? SOCK_NONBLOCK : 0),
+                              ai->ai_protocol);
+                if (fd < 0)
+                {
+                    continue;
+                }
+                const int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                if (!nonBlocking)
+                {
+                    timeval tv{kHttpTimeoutSec, 0};
+                    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+                }
+                if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || (nonBlocking && errno == EINPROGRESS))
+                {
+                    break;
+                }
+                ::close(fd);
+                fd = -1;
+            }
+            if (fd < 0)
+            {
+                std::cerr << "[backend] " << sysError(("connect " + server.host).c_str()) << std::endl;
+            }
+            freeaddrinfo(found);
+            return fd;
+        }
+
+#ifdef SHAH_BACKEND_TLS
+        SSL_CTX* tlsContext()
+        {
+            static SSL_CTX* ctx = [] {
+                SSL_CTX* c = SSL_CTX_new(TLS_client_method());
+                if (c)
+                {
+                    SSL_CTX_set_default_verify_paths(c);
+                    SSL_CTX_set_verify(c, SSL_VERIFY_PEER, nullptr);
+                    // A write that would block is retried from out_, which onWake() may
+                    // have grown (and moved) in between.
+                    SSL_CTX_set_mode(c, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_ENABLE_PARTIAL_WRITE);
+                }
+                return c;
+            }();
+            return ctx;
+        }
+
+        std::string tlsError(const char* where)
+        {
+            std::string msg = where;
+            msg += ": ";
+            const unsigned long e = ERR_get_error();
+            msg += e ? ERR_error_string(e, nullptr) : "connection closed";
+            return msg;
+        }
+
+        SSL* newTls(int fd, const std::string& host)
+        {
+            SSL_CTX* ctx = tlsContext();
+            SSL* ssl = ctx ? SSL_new(ctx) : nullptr;
+            if (!ssl)
+            {
+                std::cerr << "[backend] " << tlsError("SSL_new") << std::endl;
+                return nullptr;
+            }
+            SSL_set_fd(ssl, fd);
+            SSL_set_tlsext_host_name(ssl, host.c_str());
+            SSL_set1_host(ssl, host.c_str());
+            SSL_set_connect_state(ssl);
+            return ssl;
+        }
+#else
+        using SSL = void;
+#endif
+
+        bool tlsAvailable(const Endpoint& server)
+        {
+#ifdef SHAH_BACKEND_TLS
+            (void) server;
+            return true;
+#else
+            if (server.secure)
+            {
+                std::cerr << "[backend] " << server.host
+                          << ": built without OpenSSL, only ws:// and http:// endpoints work" << std::endl;
+            }
+            return !server.secure;
+#endif
+        }
+
+        std::string upgradeRequest(const Endpoint& server, const std::string& key)
+        {
+            std::string req = "GET " + (server.path.empty() ? std::string("/") : server.path) + " HTTP/1.1\r\n";
+            req += "Host: " + server.host + ":" + std::to_string(server.port) + "\r\n";
+            req += "User-Agent: ShahTerminal/1.0\r\n";
+            req += "Upgrade: websocket\r\nConnection: Upgrade\r\n";
+            req += "Sec-WebSocket-Key: " + key + "\r\n";
+            req += "Sec-WebSocket-Version: 13\r\n\r\n";
+            return req;
+        }
+
+        // Header value by case-insensitive name from a raw response head; empty if absent.
+        std::string headerValue(std::string_view head, std::string_view name)
+        {
+            std::size_t pos = head.find("\r\n");
+            while (pos != std::string_view::npos && pos + 2 < head.size())
+            {
+                const std::size_t start = pos + 2;
+                const std::size_t end = head.find("\r\n", start);
+                const std::string_view line = head.substr(start, end - start);
+                const std::size_t colon = line.find(':');
+                if (colon == name.size() &&
+                    std::equal(name.begin(), name.end(), line.begin(), [](char a, char b) {
+                        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+                    }))
+                {
+                    std::string_view value = line.substr(colon + 1);
+                    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+                    {
+                        value.remove_prefix(1);
+                    }
+                    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+                    {
+                        value.remove_suffix(1);
+                    }
+                    return std::string(value);
+                }
+                pos = end;
+            }
+            return {};
+        }
+
+        int statusOf(std::string_view head)
+        {
+            // "HTTP/1.1 101 Switching Protocols"
+            const std::size_t sp = head.find(' ');
+            if (sp == std::string_view::npos || sp + 4 > head.size())
+            {
+                return 0;
+            }
+            return std::atoi(std::string(head.substr(sp + 1, 3)).c_str());
+        }
+
+        std::string dechunk(std::string_view body)
+        {
+            std::string out;
+            std::size_t pos = 0;
+            while (pos < body.size())
+            {
+                const std::size_t eol = body.find("\r\n", pos);
+                if (eol == std::string_view::npos)
+                {
+                    break;
+                }
+                const std::size_t size = std::strtoul(std::string(body.substr(pos, eol - pos)).c_str(), nullptr, 16);
+                pos = eol + 2;
+                if (size == 0 || pos + size > body.size())
+                {
+                    break;
+                }
+                out.append(body.substr(pos, size));
+                pos += size + 2;
+            }
+            return out;
+        }
+
+        class EpollTransport;
+
+        // One WebSocket on the reactor. Everything but sendText/close runs on the
+        // reactor thread; those two only queue and wake it.
+        class EpollWebSocket final : public WebSocket, public std::enable_shared_from_this<EpollWebSocket>
+        {
+        public:
+            enum class State
+            {
+                Connecting,
+                TlsHandshake,
+                Upgrading,
+                Open,
+                Closed
+            };
+
+            EpollWebSocket(EpollTransport& owner, Endpoint server, WebSocketHandler handler, int fd)
+                : owner_(owner)
+                , server_(std::move(server))
+                , handler_(std::move(handler))
+                , fd_(fd)
+            {
+            }
+
+            ~EpollWebSocket() override { release(); }
+
+            bool sendText(std::string_view text) override;
+            void close() override;
+
+            int fd() const { return fd_; }
+            State state() const { return state_; }
+
+            // Reactor side. Each returns false once the socket is finished (onClose sent).
+            bool onEvents(std::uint32_t events, std::vector<char>& scratch);
+            bool onWake();
+            void finish(const std::string& reason);
+
+        private:
+            // >0 bytes, 0 would block, -1 EOF or error (reason_ says which).
+            long readSome(char* buf, std::size_t len);
+            long writeSome(const char* buf, std::size_t len);
+            bool onConnected();
+            bool continueTls();
+            bool onReadable(std::vector<char>& scratch);
+            bool onUpgradeResponse(std::int64_t receivedUs);
+            bool drainFrames();
+            bool flush();
+            void watch();
+            void release();
+
+            EpollTransport& owner_;
+            Endpoint server_;
+            WebSocketHandler handler_;
+            int fd_;
+            SSL* ssl_{nullptr};
+            bool tlsWantsWrite_{false};
+            // SSL_write needs the socket readable first; EPOLLOUT would only spin.
+            bool tlsWriteWantsRead_{false};
+            State state_{State::Connecting};
+            std::string key_;
+            std::string head_;
+            ws::FrameParser parser_;
+            ws::FrameParser::Message message_;
+            std::string out_;
+            std::uint32_t watched_{0};
+            std::string reason_;
+
+            // Shared with other threads.
+            std::mutex mutex_;
+            std::string queued_;
+            bool closeRequested_{false};
+            bool closing_{false};
+        };
+
+        class EpollTransport final : public Transport
+        {
+        public:
+            EpollTransport()
+                : epoll_(epoll_create1(EPOLL_CLOEXEC))
+                , wake_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+            {
+                if (epoll_ < 0 || wake_ < 0)
+                {
+                    throw std::runtime_error(sysError("epoll/eventfd"));
+                }
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                ev.data.fd = wake_;
+                epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &ev);
+            }
+
+            ~EpollTransport() override
+            {
+                for (auto& [fd, socket] : sockets_)
+                {
+                    socket->finish("transport destroyed");
+                }
+                ::close(wake_);
+                ::close(epoll_);
+            }
+
+            std::optional<std::string> httpGet(const Endpoint& server, const std::string& pathAndQuery) override;
+            std::shared_ptr<WebSocket> connect(const Endpoint& server, WebSocketHandler handler) override;
+            void run() override;
+            void stop() override
+            {
+                stopping_ = true;
+                wake();
+            }
+
+            void wake()
+            {
+                const std::uint64_t one = 1;
+                [[maybe_unused]] const auto n = ::write(wake_, &one, sizeof(one));
+            }
+
+            void watch(int fd, std::uint32_t events)
+            {
+                epoll_event ev{};
+                ev.events = events;
+                ev.data.fd = fd;
+                epoll_ctl(epoll_, EPOLL_CTL_MOD, fd, &ev);
+            }
+
+            void forget(int fd) { epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr); }
+
+        private:
+            int epoll_;
+            int wake_;
+            std::atomic<bool> stopping_{false};
+            std::mutex mutex_; // sockets_: connect() may run on any thread
+            std::map<int, std::shared_ptr<EpollWebSocket>> sockets_;
+        };
+
+        bool EpollWebSocket::sendText(std::string_view text)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (closing_)
+                {
+                    return false;
+                }
+                ws::appendClientFrame(queued_, ws::Opcode::Text, text);
+            }
+            owner_.wake();
+            return true;
+        }
+
+        void EpollWebSocket::close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (closing_)
+                {
+                    return;
+                }
+                closeRequested_ = true;
+                closing_ = true;
+            }
+            owner_.wake();
+        }
+
+        long EpollWebSocket::readSome(char* buf, std::size_t len)
+        {
+#ifdef SHAH_BACKEND_TLS
+            if (ssl_)
+            {
+                const int n = SSL_read(ssl_, buf, static_cast<int>(len));
+                if (n > 0)
+                {
+                    return n;
+                }
+                const int err = SSL_get_error(ssl_, n);
+                if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+                {
+                    tlsWantsWrite_ = err == SSL_ERROR_WANT_WRITE;
+                    return 0;
+                }
+                reason_ = err == SSL_ERROR_ZERO_RETURN ? "closed by server" : tlsError("SSL_read");
+                return -1;
+            }
+#endif
+            const ssize_t n = ::recv(fd_, buf, len, 0);
+            if (n > 0)
+            {
+                return n;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            {
+                return 0;
+            }
+            reason_ = n == 0 ? "closed by server" : sysError("recv");
+            return -1;
+        }
+
+        long EpollWebSocket::writeSome(const char* buf, std::size_t len)
+        {
+#ifdef SHAH_BACKEND_TLS
+            if (ssl_)
+            {
+                const int n = SSL_write(ssl_, buf, static_cast<int>(len));
+                tlsWriteWantsRead_ = false;
+                if (n > 0)
+                {
+                    return n;
+                }
+                const int err = SSL_get_error(ssl_, n);
+                if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+                {
+                    tlsWriteWantsRead_ = err == SSL_ERROR_WANT_READ;
+                    return 0;
+                }
+                reason_ = tlsError("SSL_write");
+                return -1;
+            }
+#endif
+            const ssize_t n = ::send(fd_, buf, len, MSG_NOSIGNAL);
+            if (n >= 0)
+            {
+                return n;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                return 0;
+            }
+            reason_ = sysError("send");
+            return -1;
+        }
+
+        bool EpollWebSocket::onEvents(std::uint32_t events, std::vector<char>& scratch)
+        {
+            if (state_ == State::Connecting)
+            {
+                if ((events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) == 0)
+                {
+                    return true;
+                }
+                return onConnected();
+            }
+            if (state_ == State::TlsHandshake)
+            {
+                return continueTls();
+            }
+            const bool readable = (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+            if (readable && !onReadable(scratch))
+            {
+                return false;
+            }
+            if ((events & EPOLLOUT) != 0 || tlsWantsWrite_ || (readable && tlsWriteWantsRead_))
+            {
+                return flush();
+            }
+            return true;
+        }
+
+        bool EpollWebSocket::onConnected()
+        {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0)
+            {
+                finish(std::string("connect: ") + std::strerror(err));
+                return false;
+            }
+#ifdef SHAH_BACKEND_TLS
+            if (server_.secure)
+            {
+                ssl_ = newTls(fd_, server_.host);
+                if (!ssl_)
+                {
+                    finish("TLS setup failed");
+                    return false;
+                }
+                state_ = State::TlsHandshake;
+                return continueTls();
+            }
+#endif
+            key_ = ws::makeClientKey();
+            out_ += upgradeRequest(server_, key_);
+            state_ = State::Upgrading;
+            return flush();
+        }
+
+        bool EpollWebSocket::continueTls()
+        {
+#ifdef SHAH_BACKEND_TLS
+            const int rc = SSL_do_handshake(ssl_);
+            if (rc != 1)
+            {
+                const int err = SSL_get_error(ssl_, rc);
+                if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+                {
+                    tlsWantsWrite_ = err == SSL_ERROR_WANT_WRITE;
+                    watch();
+                    return true;
+                }
+                finish(tlsError("TLS handshake"));
+                return false;
+            }
+            tlsWantsWrite_ = false;
+            key_ = ws::makeClientKey();
+            out_ += upgradeRequest(server_, key_);
+            state_ = State::Upgrading;
+            return flush();
+#else
+            finish("TLS not available");
+            return false;
+#endif
+        }
+
+        bool EpollWebSocket::onReadable(std::vector<char>& scratch)
+        {
+            tlsWantsWrite_ = false;
+            for (;;)
+            {
+                const long n = readSome(scratch.data(), scratch.size());
+                if (n == 0)
+                {
+                    break;
+                }
+                if (n < 0)
+                {
+                    finish(reason_);
+                    return false;
+                }
+                const std::int64_t receivedUs = wallClockUs();
+                if (state_ == State::Upgrading)
+                {
+                    head_.append(scratch.data(), static_cast<std::size_t>(n));
+                    if (!onUpgradeResponse(receivedUs))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    parser_.feed(scratch.data(), static_cast<std::size_t>(n), receivedUs);
+                }
+                // Hand over what is complete before reading more, so a fast server
+                // cannot make one socket starve the others or grow the buffer.
+                if (state_ == State::Open && !drainFrames())
+                {
+                    return false;
+                }
+                // A short plain read means the socket is drained. TLS reads return one
+                // record at a time and may leave decrypted bytes inside OpenSSL that
+                // epoll cannot see, so those keep reading until it says WANT_READ.
+                if (!ssl_ && static_cast<std::size_t>(n) < scratch.size())
+                {
+                    break;
+                }
+            }
+            return true;
+        }
+
+        bool EpollWebSocket::onUpgradeResponse(std::int64_t receivedUs)
+        {
+            const std::size_t end = head_.find("\r\n\r\n");
+            if (end == std::string::npos)
+            {
+                if (head_.size() > 16 * 1024)
+                {
+                    finish("upgrade response too large");
+                    return false;
+                }
+                return true;
+            }
+            const std::string_view head(head_.data(), end + 2);
+            if (statusOf(head) != 101)
+            {
+                finish("upgrade refused: " + std::string(head.substr(0, head.find("\r\n"))));
+                return false;
+            }
+            if (headerValue(head, "Sec-WebSocket-Accept") != ws::acceptFor(key_))
+            {
+                finish("upgrade response has a wrong Sec-WebSocket-Accept");
+                return false;
+            }
+            // Frames may already follow the response in the same read.
+            parser_.feed(head_.data() + end + 4, head_.size() - end - 4, receivedUs);
+            head_.clear();
+            head_.shrink_to_fit();
+            state_ = State::Open;
+            if (handler_.onOpen)
+            {
+                handler_.onOpen(*this);
+            }
+            return state_ == State::Open;
+        }
+
+        bool EpollWebSocket::drainFrames()
+        {
+            for (;;)
+            {
+                const auto status = parser_.next(message_);
+                if (status == ws::FrameParser::Status::NeedMore)
+                {
+                    return true;
+                }
+                if (status == ws::FrameParser::Status::Error)
+                {
+                    finish("protocol error: " + parser_.error());
+                    return false;
+                }
+                switch (message_.opcode)
+                {
+                case ws::Opcode::Text:
+                case ws::Opcode::Binary:
+                    if (handler_.onMessage)
+                    {
+                        handler_.onMessage(message_.opcode == ws::Opcode::Text ? MessageType::Text
+                                                                               : MessageType::Binary,
+                                           message_.payload,
+                                           message_.receivedUs);
+                    }
+                    break;
+                case ws::Opcode::Ping:
+                    ws::appendClientFrame(out_, ws::Opcode::Pong, message_.payload);
+                    if (!flush())
+                    {
+                        return false;
+                    }
+                    break;
+                case ws::Opcode::Close:
+                {
+                    // Echo the status code back, then drop the connection.
+                    ws::appendClientFrame(out_, ws::Opcode::Close, std::string_view(message_.payload).substr(0, 2));
+                    flush();
+                    std::string reason = "closed by server";
+                    if (message_.payload.size() >= 2)
+                    {
+                        const auto* p = reinterpret_cast<const unsigned char*>(message_.payload.data());
+                        reason += " (" + std::to_string((p[0] << 8) | p[1]) + ")";
+                    }
+                    finish(reason);
+                    return false;
+                }
+                default:
+                    break; // unsolicited pongs
+                }
+                if (state_ != State::Open)
+                {
+                    return false; // a handler closed it
+                }
+            }
+        }
+
+        bool EpollWebSocket::onWake()
+        {
+            bool closeNow = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (state_ == State::Open)
+                {
+                    out_ += queued_;
+                    queued_.clear();
+                }
+                closeNow = closeRequested_;
+            }
+            if (closeNow)
+            {
+                if (state_ == State::Open)
+                {
+                    ws::appendClientFrame(out_, ws::Opcode::Close, std::string_view("\x03\xe8", 2)); // 1000
+                    flush();
+                }
+                finish("closed");
+                return false;
+            }
+            return state_ != State::Open || flush();
+        }
+
+        bool EpollWebSocket::flush()
+        {
+            while (!out_.empty())
+            {
+                const long n = writeSome(out_.data(), out_.size());
+                if (n < 0)
+                {
+                    finish(reason_);
+                    return false;
+                }
+                if (n == 0)
+                {
+                    break;
+                }
+                out_.erase(0, static_cast<std::size_t>(n));
+            }
+            watch();
+            return true;
+        }
+
+        void EpollWebSocket::watch()
+        {
+            std::uint32_t events = EPOLLIN;
+            if (state_ == State::Connecting || (!out_.empty() && !tlsWriteWantsRead_) || tlsWantsWrite_)
+            {
+                events |= EPOLLOUT;
+            }
+            if (events != watched_)
+            {
+                owner_.watch(fd_, events);
+                watched_ = events;
+            }
+        }
+
+        void EpollWebSocket::finish(const std::string& reason)
+        {
+            if (state_ == State::Closed)
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closing_ = true;
+                queued_.clear();
+            }
+            state_ = State::Closed;
+            owner_.forget(fd_);
+            release();
+            if (handler_.onClose)
+            {
+                handler_.onClose(reason);
+            }
+        }
+
+        void EpollWebSocket::release()
+        {
+#ifdef SHAH_BACKEND_TLS
+            if (ssl_)
+            {
+                SSL_free(ssl_);
+                ssl_ = nullptr;
+            }
+#endif
+            if (fd_ >= 0)
+            {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+
+        std::shared_ptr<WebSocket> EpollTransport::connect(const Endpoint& server, WebSocketHandler handler)
+        {
+            if (!tlsAvailable(server))
+            {
+                return nullptr;
+            }
+            const int fd = openSocket(server, true);
+            if (fd < 0)
+            {
+                return nullptr;
+            }
+            auto socket = std::make_shared<EpollWebSocket>(*this, server, std::move(handler), fd);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                sockets_[fd] = socket;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT;
+            ev.data.fd = fd;
+            epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev);
+            return socket;
+        }
+
+        void EpollTransport::run()
+        {
+            std::vector<char> scratch(kReadChunk);
+            std::vector<epoll_event> events(64);
+            for (;;)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (sockets_.empty())
+                    {
+                        return;
+                    }
+                }
+                const int n = epoll_wait(epoll_, events.data(), static_cast<int>(events.size()), -1);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    std::cerr << "[backend] " << sysError("epoll_wait") << std::endl;
+                    return;
+                }
+
+                std::vector<std::shared_ptr<EpollWebSocket>> finished;
+                for (int i = 0; i < n; ++i)
+                {
+                    const int fd = events[i].data.fd;
+                    if (fd == wake_)
+                    {
+                        std::uint64_t count = 0;
+                        [[maybe_unused]] const auto r = ::read(wake_, &count, sizeof(count));
+                        std::vector<std::shared_ptr<EpollWebSocket>> all;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            for (auto& [sfd, socket] : sockets_)
+                            {
+                                all.push_back(socket);
+                            }
+                        }
+                        for (auto& socket : all)
+                        {
+                            if (stopping_)
+                            {
+                                socket->finish("transport stopped");
+                            }
+                            if (socket->state() == EpollWebSocket::State::Closed || !socket->onWake())
+                            {
+                                finished.push_back(socket);
+                            }
+                        }
+                        continue;
+                    }
+
+                    std::shared_ptr<EpollWebSocket> socket;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        const auto it = sockets_.find(fd);
+                        if (it != sockets_.end())
+                        {
+                            socket = it->second;
+                        }
+                    }
+                    if (socket && socket->state() != EpollWebSocket::State::Closed &&
+                        !socket->onEvents(events[i].events, scratch))
+                    {
+                        finished.push_back(socket);
+                    }
+                }
+
+                if (!finished.empty())
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (auto it = sockets_.begin(); it != sockets_.end();)
+                    {
+                        if (it->second->state() == EpollWebSocket::State::Closed)
+                        {
+                            it = sockets_.erase(it);
+                        }
+                        else
+                        {
+                            ++it;
+                        }
+                    }
+                }
+                if (stopping_)
+                {
+                    return;
+                }
+            }
+        }
+
+        std::optional<std::string> EpollTransport::httpGet(const Endpoint& server, const std::string& pathAndQuery)
+        {
+            if (!tlsAvailable(server))
+            {
+                return std::nullopt;
+            }
+            const int fd = openSocket(server, false);
+            if (fd < 0)
+            {
+                return std::nullopt;
+            }
+            SSL* ssl = nullptr;
+#ifdef SHAH_BACKEND_TLS
+            if (server.secure)
+            {
+                ssl = newTls(fd, server.host);
+                if (!ssl || SSL_connect(ssl) != 1)
+                {
+                    std::cerr << "[backend] " << tlsError(("TLS " + server.host).c_str()) << std::endl;
+                    if (ssl)
+                    {
+                        SSL_free(ssl);
+                    }
+                    ::close(fd);
+                    return std::nullopt;
+                }
+            }
+#endif
+            auto io = [ssl, fd](bool write, char* buf, std::size_t len) -> long {
+#ifdef SHAH_BACKEND_TLS
+                if (ssl)
+                {
+                    return write ? SSL_write(ssl, buf, static_cast<int>(len)) : SSL_read(ssl, buf, static_cast<int>(len));
+                }
+#else
+                (void) ssl;
+#endif
+                return write ? ::send(fd, buf, len, MSG_NOSIGNAL) : ::recv(fd, buf, len, 0);
+            };
+
+            std::string request = "GET " + pathAndQuery + " HTTP/1.1\r\nHost: " + server.host +
+                                  "\r\nUser-Agent: ShahTerminal/1.0\r\nAccept: */*\r\nConnection: close\r\n\r\n";
+            bool ok = true;
+            for (std::size_t sent = 0; ok && sent < request.size();)
+            {
+                const long n = io(true, request.data() + sent, request.size() - sent);
+                ok = n > 0;
+                sent += ok ? static_cast<std::size_t>(n) : 0;
+            }
+            std::string response;
+            if (ok)
+            {
+                char buf[16 * 1024];
+                for (;;)
+                {
+                    const long n = io(false, buf, sizeof(buf));
+                    if (n <= 0)
+                    {
+                        break;
+                    }
+                    response.append(buf, static_cast<std::size_t>(n));
+                }
+            }
+#ifdef SHAH_BACKEND_TLS
+            if (ssl)
+            {
+                SSL_free(ssl);
+            }
+#endif
+            ::close(fd);
+
+            const std::size_t end = response.find("\r\n\r\n");
+            if (!ok || end == std::string::npos)
+            {
+                std::cerr << "[backend] GET " << server.host << pathAndQuery << ": no response" << std::endl;
+                return std::nullopt;
+            }
+            const std::string_view head(response.data(), end + 2);
+            std::string_view body(response.data() + end + 4, response.size() - end - 4);
+            if (headerValue(head, "Transfer-Encoding").find("chunked") != std::string::npos)
+            {
+                return dechunk(body);
+            }
+            const std::string length = headerValue(head, "Content-Length");
+            if (!length.empty())
+            {
+                body = body.substr(0, std::strtoul(length.c_str(), nullptr, 10));
+            }
+            return std::string(body);
+        }
+    } // namespace
+
+    std::unique_ptr<Transport> makeTransport()
+    {
+        return std::make_unique<EpollTransport>();
+    }
+} // namespace dom
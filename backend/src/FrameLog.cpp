@@ -0,0 +1,149 @@
+#include "FrameLog.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr char kMagic[8] = {'S', 'H', 'C', 'A', 'P', '0', '0', '1'};
+    // The writer runs inside a process the GUI kills on exit; bound what is lost.
+    constexpr std::int64_t kFlushIntervalUs = 200'000;
+
+    template <typename T>
+    void putLe(std::string& out, T value)
+    {
+        auto bits = static_cast<std::uint64_t>(value);
+        for (std::size_t i = 0; i < sizeof(T); ++i)
+        {
+            out.push_back(static_cast<char>(bits & 0xFF));
+            bits >>= 8;
+        }
+    }
+
+    template <typename T>
+    bool getLe(std::istream& in, T& value)
+    {
+        unsigned char bytes[sizeof(T)];
+        if (!in.read(reinterpret_cast<char*>(bytes), sizeof(T)))
+        {
+            return false;
+        }
+        std::uint64_t bits = 0;
+        for (std::size_t i = sizeof(T); i-- > 0;)
+        {
+            bits = (bits << 8) | bytes[i];
+        }
+        value = static_cast<T>(bits);
+        return true;
+    }
+} // namespace
+
+namespace dom
+{
+    FrameLogWriter::FrameLogWriter(const std::string& path)
+        : out_(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!out_)
+        {
+            throw std::runtime_error("cannot open capture file " + path);
+        }
+        out_.write(kMagic, sizeof(kMagic));
+    }
+
+    FrameLogWriter::~FrameLogWriter()
+    {
+        flush();
+    }
+
+    void FrameLogWriter::append(RecordKind kind, std::int64_t timeUs, std::string_view key, std::string_view payload)
+    {
+        std::string header;
+        header.reserve(1 + 8 + 2 + key.size() + 4);
+        header.push_back(static_cast<char>(kind));
+        putLe(header, timeUs);
+        putLe(header, static_cast<std::uint16_t>(key.size()));
+        header.append(key.data(), key.size());
+        putLe(header, static_cast<std::uint32_t>(payload.size()));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        out_.write(header.data(), static_cast<std::streamsize>(header.size()));
+        out_.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        unflushed_ = true;
+        if (timeUs - lastFlushUs_ >= kFlushIntervalUs)
+        {
+            out_.flush();
+            lastFlushUs_ = timeUs;
+            unflushed_ = false;
+        }
+    }
+
+    void FrameLogWriter::flushIfDue(std::int64_t nowUs)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (unflushed_ && nowUs - lastFlushUs_ >= kFlushIntervalUs)
+        {
+            out_.flush();
+            lastFlushUs_ = nowUs;
+            unflushed_ = false;
+        }
+    }
+
+    void FrameLogWriter::flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out_.flush();
+        unflushed_ = false;
+    }
+
+    FrameLogReader::FrameLogReader(const std::string& path)
+        : path_(path)
+        , in_(path, std::ios::binary)
+    {
+        if (!in_)
+        {
+            throw std::runtime_error("cannot open capture file " + path);
+        }
+        rewind();
+    }
+
+    void FrameLogReader::rewind()
+    {
+        in_.clear();
+        in_.seekg(0);
+        char magic[sizeof(kMagic)] = {};
+        if (!in_.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kMagic))
+        {
+            throw std::runtime_error(path_ + " is not a capture file");
+        }
+    }
+
+    bool FrameLogReader::next(Record& out)
+    {
+        char kind = 0;
+        if (!in_.get(kind))
+        {
+            return false;
+        }
+        std::uint16_t keySize = 0;
+        std::uint32_t size = 0;
+        bool ok = getLe(in_, out.timeUs) && getLe(in_, keySize);
+        if (ok)
+        {
+            out.key.resize(keySize);
+            ok = static_cast<bool>(in_.read(out.key.data(), keySize)) && getLe(in_, size);
+        }
+        if (ok)
+        {
+            out.payload.resize(size);
+            ok = static_cast<bool>(in_.read(out.payload.data(), size));
+        }
+        if (!ok)
+        {
+            std::cerr << "[backend] " << path_ << ": truncated record, stopping there" << std::endl;
+            return false;
+        }
+        out.kind = static_cast<RecordKind>(kind);
+        return true;
+    }
+} // namespace dom
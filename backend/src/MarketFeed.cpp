@@ -0,0 +1,1134 @@
+#include "MarketFeed.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include <json.hpp>
+
+namespace
+{
+    using json = nlohmann::json;
+
+    // A hidden column only has to be roughly current when it is shown again.
+    constexpr std::chrono::milliseconds kHiddenInterval{1000};
+    // Slowest rate a visible column is ever throttled down to.
+    constexpr std::chrono::milliseconds kMaxInterval{1000};
+    // Keep the GUI thread at most half busy painting any one column.
+    constexpr double kPaintBudgetFactor = 2.0;
+    // A ladder never reported as painted (minimised window, dropped report) stops
+    // holding back the next one after this long.
+    constexpr std::chrono::milliseconds kPendingTimeout{1000};
+    // MEXC caps a connection at 30 channels, two of which each symbol takes.
+    constexpr std::size_t kMexcMaxSymbols = 15;
+    // Rough cost of one price level in an OrderBook side (std::map node).
+    constexpr std::size_t kBytesPerLevel = 64;
+    // MEXC drops a connection that neither pings nor gets data for a minute; a ping
+    // also gives a quiet book's socket a frame for the stall check in main.cpp.
+    constexpr std::chrono::milliseconds kPingInterval{10000};
+    // Depth pushes kept per symbol while its snapshot loads; ten a second at 100 ms
+    // aggregation. Past this the oldest go, and finishLoad() reloads if it needed them.
+    constexpr std::size_t kMaxPendingFrames = 256;
+    // Folds a contiguous, top-to-bottom ladder into rows of `factor` ticks each.
+    // Bucket boundaries match what the GUI used to compute on its side:
+    // bucketTick = (tick / factor) * factor.
+    std::vector<dom::Level> compressLadder(const std::vector<dom::Level>& levels,
+                                           double tickSize,
+                                           dom::OrderBook::Tick factor)
+    {
+        std::vector<dom::Level> out;
+        out.reserve(levels.size() / static_cast<std::size_t>(factor) + 2);
+        dom::OrderBook::Tick currentBucket = 0;
+        for (const auto& lvl : levels)
+        {
+            const auto tick = static_cast<dom::OrderBook::Tick>(std::llround(lvl.price / tickSize));
+            const auto bucket = (tick / factor) * factor;
+            if (out.empty() || bucket != currentBucket)
+            {
+                currentBucket = bucket;
+                out.push_back(dom::Level{static_cast<double>(bucket) * tickSize, 0.0, 0.0});
+            }
+            out.back().bidQuantity += lvl.bidQuantity;
+            out.back().askQuantity += lvl.askQuantity;
+        }
+        return out;
+    }
+
+    double bucketPrice(double price, double tickSize, dom::OrderBook::Tick factor)
+    {
+        if (price <= 0.0 || tickSize <= 0.0)
+        {
+            return price;
+        }
+        const auto tick = static_cast<dom::OrderBook::Tick>(std::llround(price / tickSize));
+        return static_cast<double>((tick / factor) * factor) * tickSize;
+    }
+
+    double detectUzxTick(std::string_view priceStr)
+    {
+        auto pos = priceStr.find('.');
+        if (pos == std::string_view::npos)
+        {
+            return 1.0;
+        }
+        const int decimals = static_cast<int>(priceStr.size() - pos - 1);
+        if (decimals <= 0 || decimals > 12) return 0.0;
+        return std::pow(10.0, -decimals);
+    }
+
+    // UZX pushes full books as [["price","qty"], ...]. The book's tick size is the
+    // source of truth; it is only guessed from the price text when still unknown.
+    void parseUzxSide(const json& side,
+                      dom::OrderBook& book,
+                      std::vector<std::pair<dom::OrderBook::Tick, double>>& out)
+    {
+        out.clear();
+        if (!side.is_array()) return;
+        for (const auto& lvl : side)
+        {
+            if (!lvl.is_array() || lvl.size() < 2) continue;
+            const std::string priceStr = lvl[0].get<std::string>();
+            const std::string qtyStr = lvl[1].get<std::string>();
+            const double price = std::atof(priceStr.c_str());
+            const double qty = std::atof(qtyStr.c_str());
+            if (price <= 0.0 || qty <= 0.0) continue;
+            if (book.tickSize() <= 0.0)
+            {
+                const double detected = detectUzxTick(priceStr);
+                if (detected > 0.0)
+                {
+                    book.setTickSize(detected);
+                }
+            }
+            const double tickSize = book.tickSize();
+            if (tickSize <= 0.0) continue;
+            const auto tick = static_cast<dom::OrderBook::Tick>(std::llround(price / tickSize));
+            out.emplace_back(tick, qty);
+        }
+    }
+} // namespace
+
+namespace dom
+{
+    std::int64_t wallClockMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    std::int64_t wallClockUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+    MarketFeed::MarketFeed(Venue venue, std::ostream& out, LoadInstrument load)
+        : venue_(venue)
+        , out_(out)
+        , load_(std::move(load))
+        , clock_([] { return std::chrono::steady_clock::now(); })
+        , traceClock_(wallClockUs)
+    {
+    }
+
+    void MarketFeed::setClock(Clock clock)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clock_ = std::move(clock);
+    }
+
+    void MarketFeed::setLoadSpawner(SpawnLoad spawn)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spawnLoad_ = std::move(spawn);
+    }
+
+    void MarketFeed::setPrefetcher(PrefetchInstrument prefetch)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        prefetch_ = std::move(prefetch);
+    }
+
+    void MarketFeed::setTraceClock(TraceClock clock)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        traceClock_ = clock;
+    }
+
+    void MarketFeed::setUpdateObserver(UpdateObserver observer)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        observer_ = std::move(observer);
+    }
+
+    void MarketFeed::setWarmCache(std::size_t symbols, std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        warmSymbols_ = symbols;
+        warmBytes_ = bytes;
+        trimWarmLocked(0);
+    }
+
+    void MarketFeed::addStream(int id, StreamSettings settings)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribeLocked(id, std::move(settings), nullptr);
+    }
+
+    void MarketFeed::addStream(int id, StreamSettings settings, OrderBook book)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SymbolBook& entry = books_[settings.symbol];
+        entry.book = std::move(book);
+        entry.ready = true;
+        subscribeLocked(id, std::move(settings), nullptr);
+    }
+
+    void MarketFeed::handleCommand(const Command& cmd)
+    {
+        using Type = Command::Type;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        const char* name = commandName(cmd.type);
+
+        if (cmd.type == Type::Prefetch)
+        {
+            // No stream and no ack: the GUI warms a fresh process with the symbols of
+            // its saved layout, so a later subscribe only has to load the book.
+            if (prefetch_)
+            {
+                std::thread([prefetch = prefetch_, symbol = cmd.symbol]() { prefetch(symbol); }).detach();
+            }
+            return;
+        }
+
+        if (cmd.type == Type::Subscribe)
+        {
+            StreamSettings settings;
+            settings.symbol = cmd.symbol;
+            settings.levelsPerSide = cmd.value > 0 ? static_cast<std::size_t>(cmd.value) : 500;
+            settings.compression = static_cast<std::size_t>(std::max<std::int64_t>(1, cmd.compression));
+            const auto existing = streams_.find(cmd.stream);
+            if (existing != streams_.end())
+            {
+                settings.throttle = existing->second.settings.throttle;
+            }
+            bool shared = false;
+            if (cmd.reload)
+            {
+                // A book only this stream (or the warm cache) holds is dropped, channel
+                // and all, so the subscribe loads it like a new symbol. One other
+                // streams show is reloaded in place once this stream has joined it.
+                for (const auto& [id, other] : streams_)
+                {
+                    shared = shared || (id != cmd.stream && other.settings.symbol == cmd.symbol);
+                }
+                if (!shared && books_.count(cmd.symbol) != 0)
+                {
+                    std::cerr << "[backend] reloading " << cmd.symbol << std::endl;
+                    dropSymbolLocked(cmd.symbol);
+                }
+            }
+            subscribeLocked(cmd.stream, std::move(settings), name);
+            const auto bookIt = books_.find(cmd.symbol);
+            if (shared && bookIt != books_.end() && bookIt->second.ready && bookIt->second.loadId == 0)
+            {
+                std::cerr << "[backend] reloading shared " << cmd.symbol << std::endl;
+                loadAsync(cmd.symbol);
+            }
+            return;
+        }
+
+        auto it = streams_.find(cmd.stream);
+        if (it == streams_.end() && cmd.type == Type::ConsumerReport)
+        {
+            // Report racing an unsubscribe.
+            return;
+        }
+        if (it == streams_.end())
+        {
+            std::cerr << "[backend] " << name << ": unknown stream " << cmd.stream << std::endl;
+            emitAckLocked(cmd.stream, name, false, cmd.symbol);
+            return;
+        }
+
+        Stream& stream = it->second;
+        if (cmd.type == Type::ConsumerReport)
+        {
+            // Sent once per painted frame; deliberately not acknowledged.
+            onConsumerReportLocked(cmd.stream, stream, cmd);
+            return;
+        }
+
+        switch (cmd.type)
+        {
+        case Type::Unsubscribe:
+            emitAckLocked(cmd.stream, name, true, stream.settings.symbol);
+            unsubscribeLocked(cmd.stream);
+            return;
+        case Type::ResubscribeSymbol:
+        {
+            StreamSettings settings = stream.settings;
+            settings.symbol = cmd.symbol;
+            subscribeLocked(cmd.stream, std::move(settings), name);
+            return;
+        }
+        case Type::SetLevels:
+            // Same clamp as parseArgs: 0 means the default depth.
+            stream.settings.levelsPerSide = cmd.value > 0 ? static_cast<std::size_t>(cmd.value) : 500;
+            break;
+        case Type::SetCompression:
+            stream.settings.compression = static_cast<std::size_t>(std::max<std::int64_t>(1, cmd.value));
+            break;
+        case Type::SetThrottle:
+            stream.settings.throttle = std::chrono::milliseconds(cmd.value);
+            break;
+        default:
+            break;
+        }
+
+        const auto bookIt = books_.find(stream.settings.symbol);
+        if (bookIt != books_.end() && bookIt->second.ready)
+        {
+            emitLadderLocked(cmd.stream, stream, bookIt->second);
+        }
+        emitAckLocked(cmd.stream, name, true, stream.settings.symbol);
+    }
+
+    void MarketFeed::attachSocket(SendText send)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        send_ = std::move(send);
+        lastFrame_ = clock_();
+        lastPing_ = lastFrame_;
+        for (const auto& [symbol, entry] : books_)
+        {
+            const std::string msg = subscriptionMessage(true, symbol);
+            if (!send_(msg))
+            {
+                std::cerr << "[backend] failed to subscribe " << symbol << std::endl;
+                continue;
+            }
+            std::cerr << "[backend] sent " << msg << std::endl;
+            // MEXC deltas only make sense on top of a book that missed none of them.
+            if (venue_ == Venue::Mexc && entry.stale && entry.ready && entry.loadId == 0)
+            {
+                loadAsync(symbol);
+            }
+        }
+    }
+
+    void MarketFeed::detachSocket()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        send_ = nullptr;
+        for (auto& [symbol, entry] : books_)
+        {
+            entry.stale = true;
+        }
+        emitHeartbeatsLocked();
+    }
+
+    void MarketFeed::heartbeat()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        emitHeartbeatsLocked();
+        if (!send_)
+        {
+            return;
+        }
+        const auto now = clock_();
+        if (venue_ == Venue::Mexc && !books_.empty() && now - lastPing_ >= kPingInterval)
+        {
+            lastPing_ = now;
+            send_(R"({"method":"PING"})");
+        }
+        for (const auto& [symbol, entry] : books_)
+        {
+            if (venue_ == Venue::Mexc && entry.stale && entry.ready && entry.loadId == 0)
+            {
+                loadAsync(symbol);
+            }
+        }
+    }
+
+    std::chrono::milliseconds MarketFeed::socketIdle() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!send_ || books_.empty())
+        {
+            return std::chrono::milliseconds(0);
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(clock_() - lastFrame_);
+    }
+
+    void MarketFeed::onBinaryFrame(const void* data, std::size_t len, std::int64_t receivedUs)
+    {
+        const std::string_view channel = peekChannel(data, len);
+        const std::string_view symbol = symbolFromChannel(channel);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastFrame_ = clock_();
+        auto bookIt = symbol.empty() && books_.size() == 1 ? books_.begin() : books_.find(symbol);
+        if (bookIt == books_.end())
+        {
+            // Not (or no longer) subscribed.
+            return;
+        }
+        SymbolBook& entry = bookIt->second;
+        if (entry.loadId != 0 && channel.find("aggre.depth") != std::string_view::npos)
+        {
+            // The REST snapshot is loading; finishLoad() replays what it does not cover.
+            if (entry.pending.size() >= kMaxPendingFrames)
+            {
+                entry.pending.pop_front();
+            }
+            entry.pending.push_back({std::string(static_cast<const char*>(data), len), receivedUs});
+            return;
+        }
+        if (!entry.ready || entry.book.tickSize() <= 0.0)
+        {
+            return;
+        }
+
+        try
+        {
+            // Try trades first
+            if (parseDealsFromWrapper(data, len, channel_, deals_))
+            {
+                for (const auto& [id, stream] : streams_)
+                {
+                    if (stream.settings.symbol != bookIt->first)
+                    {
+                        continue;
+                    }
+                    for (const auto& d : deals_)
+                    {
+                        json t;
+                        t["type"] = "trade";
+                        t["stream"] = id;
+                        t["symbol"] = stream.settings.symbol;
+                        t["price"] = d.price;
+                        t["qty"] = d.quantity;
+                        t["side"] = d.buy ? "buy" : "sell";
+                        t["timestamp"] = d.time;
+                        out_ << t.dump() << std::endl;
+                    }
+                }
+                return;
+            }
+
+            FrameTrace trace;
+            switch (applyDepthLocked(bookIt->first, entry, data, len, receivedUs, trace))
+            {
+            case DepthResult::Applied:
+                publishLocked(bookIt->first, entry, trace);
+                break;
+            case DepthResult::Gap:
+                // Further deltas would build on a wrong book: show it as stale and reload.
+                entry.stale = true;
+                emitHeartbeatsLocked(&bookIt->first);
+                loadAsync(bookIt->first);
+                break;
+            case DepthResult::Ignored:
+                break;
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "[backend] decode/apply error: " << ex.what() << std::endl;
+        }
+    }
+
+    MarketFeed::DepthResult MarketFeed::applyDepthLocked(const std::string& symbol,
+                                                         SymbolBook& entry,
+                                                         const void* data,
+                                                         std::size_t len,
+                                                         std::int64_t receivedUs,
+                                                         FrameTrace& trace)
+    {
+        OrderBook& book = entry.book;
+        DepthVersions versions;
+        if (!parsePushWrapper(data, len, channel_, book.tickSize(), asks_, bids_, versions))
+        {
+            return DepthResult::Ignored;
+        }
+        // Unversioned pushes (or book) are applied as they come, as before versions were read.
+        if (versions.to != 0 && book.version() != 0)
+        {
+            if (versions.to <= book.version())
+            {
+                return DepthResult::Ignored;
+            }
+            if (versions.from > book.version() + 1)
+            {
+                std::cerr << "[backend] " << symbol << " missed updates " << book.version() + 1 << ".."
+                          << versions.from - 1 << ", reloading" << std::endl;
+                return DepthResult::Gap;
+            }
+        }
+        const std::int64_t sendTimeMs = peekSendTime(data, len);
+        trace.exchangeUs = sendTimeMs > 0 ? sendTimeMs * 1000 - clockOffsetUs_ : 0;
+        trace.receivedUs = receivedUs;
+        trace.decodedUs = traceClock_();
+        book.applyDelta(bids_, asks_, levelsHintLocked(symbol));
+        if (versions.to != 0)
+        {
+            book.setVersion(versions.to);
+        }
+        return DepthResult::Applied;
+    }
+
+    void MarketFeed::onTextFrame(std::string_view text, std::int64_t receivedUs)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastFrame_ = clock_();
+        json j;
+        try
+        {
+            j = json::parse(text.begin(), text.end());
+        }
+        catch (...)
+        {
+            std::cerr << "[backend] text frame: " << text << std::endl;
+            return;
+        }
+
+        if (venue_ == Venue::Mexc)
+        {
+            // PING / служебные сообщения
+            const auto methodIt = j.find("method");
+            if (methodIt != j.end() && methodIt->is_string() && *methodIt == "PING")
+            {
+                if (send_)
+                {
+                    send_(R"({"method":"PONG"})");
+                }
+            }
+            else if (j.value("msg", std::string()) != "PONG")
+            {
+                std::cerr << "[backend] control: " << text << std::endl;
+            }
+            return;
+        }
+
+        try
+        {
+            if (j.contains("ping"))
+            {
+                json pong = {{"pong", j["ping"]}};
+                if (send_)
+                {
+                    send_(pong.dump());
+                }
+                return;
+            }
+            const auto dataIt = j.find("data");
+            if (dataIt == j.end() || !dataIt->is_object())
+            {
+                return;
+            }
+            const json& data = *dataIt;
+
+            // Route by product_name; a single-symbol feed also accepts untagged frames.
+            const std::string product = data.value("product_name", std::string());
+            auto bookIt = product.empty() && books_.size() == 1 ? books_.begin() : books_.find(product);
+            if (bookIt == books_.end() || !bookIt->second.ready)
+            {
+                return;
+            }
+            OrderBook& book = bookIt->second.book;
+            parseUzxSide(data["bids"], book, bids_);
+            parseUzxSide(data["asks"], book, asks_);
+
+            FrameTrace trace;
+            // UZX has no clock endpoint to estimate an offset from; its ts is taken as is.
+            const auto tsIt = j.find("ts");
+            if (tsIt != j.end() && tsIt->is_number_integer())
+            {
+                trace.exchangeUs = tsIt->get<std::int64_t>() * 1000 - clockOffsetUs_;
+            }
+            trace.receivedUs = receivedUs;
+            trace.decodedUs = traceClock_();
+            book.loadSnapshot(bids_, asks_);
+            if (bookIt->second.stale)
+            {
+                // A full book: nothing missed while disconnected survives it.
+                bookIt->second.stale = false;
+                emitHeartbeatsLocked(&bookIt->first);
+            }
+            publishLocked(bookIt->first, bookIt->second, trace);
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "[backend] UZX parse error: " << ex.what() << std::endl;
+        }
+    }
+
+    void MarketFeed::setExchangeClockOffsetMs(double offsetMs)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clockOffsetUs_ = static_cast<std::int64_t>(std::llround(offsetMs * 1000.0));
+    }
+
+    std::size_t MarketFeed::streamCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return streams_.size();
+    }
+
+    std::size_t MarketFeed::symbolCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return books_.size();
+    }
+
+    WarmCacheStats MarketFeed::warmCacheStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return warmCacheStatsLocked();
+    }
+
+    WarmCacheStats MarketFeed::warmCacheStatsLocked() const
+    {
+        WarmCacheStats stats = warmStats_;
+        for (const auto& [symbol, entry] : books_)
+        {
+            if (entry.warm)
+            {
+                ++stats.symbols;
+                stats.bytes += sizeof(SymbolBook) + entry.book.levelCount() * kBytesPerLevel;
+            }
+        }
+        return stats;
+    }
+
+    void MarketFeed::subscribeLocked(int id, StreamSettings settings, const char* ackCmd)
+    {
+        std::string previous;
+        auto existing = streams_.find(id);
+        if (existing != streams_.end())
+        {
+            previous = existing->second.settings.symbol;
+        }
+
+        const std::string symbol = settings.symbol;
+        Stream& stream = streams_[id];
+        stream.settings = std::move(settings);
+        stream.lastEmit = {};
+        stream.pendingAck = ackCmd ? ackCmd : "";
+
+        // Claim a warm book before the previous symbol turns warm and trims the cache.
+        const auto resident = books_.find(symbol);
+        const bool warm = resident != books_.end() && resident->second.warm;
+        if (warm)
+        {
+            resident->second.warm = false;
+        }
+        if (!previous.empty() && previous != symbol)
+        {
+            releaseSymbolLocked(previous);
+        }
+
+        if (resident == books_.end())
+        {
+            // Make room among the warm books before taking a new channel.
+            trimWarmLocked(1);
+            if (venue_ == Venue::Mexc && books_.size() >= kMexcMaxSymbols)
+            {
+                // Every channel carries a shown symbol. The exchange would drop this
+                // subscription without a word, so refuse it where the column can see.
+                std::cerr << "[backend] refusing " << symbol << ": " << books_.size()
+                          << " symbols already fill the MEXC per-connection channel limit" << std::endl;
+                streams_.erase(id);
+                if (ackCmd)
+                {
+                    emitAckLocked(id, ackCmd, false, symbol, nullptr, "channel-limit");
+                }
+                return;
+            }
+        }
+        auto [bookIt, inserted] = books_.try_emplace(symbol);
+        SymbolBook& entry = bookIt->second;
+        if (ackCmd)
+        {
+            // Only GUI subscribes count; the command-line stream is not a switch.
+            const char* source = " loading";
+            if (entry.ready)
+            {
+                ++warmStats_.hits;
+                source = warm ? " from warm book" : " shared";
+            }
+            else
+            {
+                ++warmStats_.misses;
+            }
+            std::cerr << "[backend] " << symbol << source << " (warm cache hits " << warmStats_.hits
+                      << ", misses " << warmStats_.misses << ")" << std::endl;
+        }
+        if (inserted)
+        {
+            if (send_)
+            {
+                send_(subscriptionMessage(true, symbol));
+            }
+            loadAsync(symbol);
+            return;
+        }
+
+        if (entry.ready)
+        {
+            // Another stream or the warm cache keeps this book current: answer from memory.
+            emitLadderLocked(id, stream, entry);
+            if (!stream.pendingAck.empty())
+            {
+                emitAckLocked(id, stream.pendingAck, true, symbol, "hit");
+                stream.pendingAck.clear();
+            }
+        }
+    }
+
+    void MarketFeed::unsubscribeLocked(int id)
+    {
+        auto it = streams_.find(id);
+        if (it == streams_.end())
+        {
+            return;
+        }
+        const std::string symbol = it->second.settings.symbol;
+        streams_.erase(it);
+        releaseSymbolLocked(symbol);
+    }
+
+    void MarketFeed::releaseSymbolLocked(const std::string& symbol)
+    {
+        for (const auto& [id, stream] : streams_)
+        {
+            if (stream.settings.symbol == symbol)
+            {
+                return;
+            }
+        }
+        auto it = books_.find(symbol);
+        if (it == books_.end())
+        {
+            return;
+        }
+        if (warmSymbols_ == 0 || !it->second.ready)
+        {
+            dropSymbolLocked(symbol);
+            return;
+        }
+        // Stay subscribed: the deltas keep the book current for a column coming back.
+        it->second.warm = true;
+        it->second.warmSince = ++warmClock_;
+        trimWarmLocked(0);
+    }
+
+    void MarketFeed::dropSymbolLocked(const std::string& symbol)
+    {
+        // `symbol` may be the map key itself: unsubscribe before erasing.
+        if (send_)
+        {
+            send_(subscriptionMessage(false, symbol));
+        }
+        books_.erase(symbol);
+    }
+
+    void MarketFeed::trimWarmLocked(std::size_t reserve)
+    {
+        for (;;)
+        {
+            const WarmCacheStats stats = warmCacheStatsLocked();
+            const bool overChannels = venue_ == Venue::Mexc && books_.size() + reserve > kMexcMaxSymbols;
+            if (stats.symbols <= warmSymbols_ && stats.bytes <= warmBytes_ && !overChannels)
+            {
+                return;
+            }
+            auto oldest = books_.end();
+            for (auto it = books_.begin(); it != books_.end(); ++it)
+            {
+                if (it->second.warm && (oldest == books_.end() || it->second.warmSince < oldest->second.warmSince))
+                {
+                    oldest = it;
+                }
+            }
+            if (oldest == books_.end())
+            {
+                return;
+            }
+            ++warmStats_.evictions;
+            std::cerr << "[backend] evicting warm book " << oldest->first << " (" << stats.symbols << " warm, "
+                      << stats.bytes / 1024 << " KiB)" << std::endl;
+            dropSymbolLocked(oldest->first);
+        }
+    }
+
+    void MarketFeed::loadAsync(const std::string& symbol)
+    {
+        const std::uint64_t loadId = ++loadCounter_;
+        SymbolBook& entry = books_[symbol];
+        entry.loadId = loadId;
+        entry.pending.clear();
+        auto load = [self = shared_from_this(), symbol, loadId]() {
+            OrderBook fresh;
+            const bool ok = self->load_(symbol, fresh);
+            self->finishLoad(symbol, loadId, std::move(fresh), ok);
+        };
+        if (spawnLoad_)
+        {
+            spawnLoad_(symbol, std::move(load));
+            return;
+        }
+        // REST can take hundreds of milliseconds; keep frames for other symbols flowing.
+        std::thread(std::move(load)).detach();
+    }
+
+    void MarketFeed::finishLoad(const std::string& symbol, std::uint64_t loadId, OrderBook&& book, bool ok)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto bookIt = books_.find(symbol);
+        if (bookIt == books_.end() || bookIt->second.loadId != loadId)
+        {
+            // Every stream switched away while we were loading.
+            return;
+        }
+        SymbolBook& entry = bookIt->second;
+        entry.loadId = 0;
+        std::deque<PendingFrame> pending = std::move(entry.pending);
+        entry.pending.clear();
+
+        if (!ok && entry.ready)
+        {
+            // A reload after a reconnect: keep showing the stale book, heartbeat() retries.
+            std::cerr << "[backend] failed to reload " << symbol << ", keeping the stale book" << std::endl;
+            return;
+        }
+        if (!ok)
+        {
+            std::cerr << "[backend] failed to load " << symbol << std::endl;
+            for (auto it = streams_.begin(); it != streams_.end();)
+            {
+                if (it->second.settings.symbol != symbol)
+                {
+                    ++it;
+                    continue;
+                }
+                emitAckLocked(it->first,
+                              it->second.pendingAck.empty() ? "subscribe" : it->second.pendingAck,
+                              false,
+                              symbol);
+                it = streams_.erase(it);
+            }
+            releaseSymbolLocked(symbol);
+            return;
+        }
+
+        const bool reloaded = entry.ready;
+        entry.book = std::move(book);
+        entry.ready = true;
+        // Loaded while disconnected: stays stale for the reload on attachSocket().
+        if (send_)
+        {
+            entry.stale = false;
+        }
+
+        // Bring the snapshot up to date with the pushes that arrived while it loaded,
+        // skipping those it already covers.
+        bool gap = false;
+        std::size_t replayed = 0;
+        for (const PendingFrame& frame : pending)
+        {
+            if (entry.book.tickSize() <= 0.0)
+            {
+                break;
+            }
+            FrameTrace trace;
+            DepthResult result = DepthResult::Ignored;
+            try
+            {
+                result = applyDepthLocked(symbol, entry, frame.data.data(), frame.data.size(), frame.receivedUs,
+                                          trace);
+            }
+            catch (const std::exception& ex)
+            {
+                std::cerr << "[backend] decode/apply error: " << ex.what() << std::endl;
+            }
+            if (result == DepthResult::Gap)
+            {
+                gap = true;
+                break;
+            }
+            if (result == DepthResult::Applied)
+            {
+                ++replayed;
+                trace.appliedUs = traceClock_();
+                entry.lastTrace = trace;
+            }
+        }
+        if (replayed > 0)
+        {
+            std::cerr << "[backend] " << symbol << ": replayed " << replayed << " of " << pending.size()
+                      << " buffered updates past lastUpdateId" << std::endl;
+        }
+        if (gap)
+        {
+            entry.stale = true;
+        }
+        if (reloaded)
+        {
+            std::cerr << "[backend] reloaded " << symbol << (entry.stale ? " (still disconnected)" : "")
+                      << std::endl;
+            emitHeartbeatsLocked(&symbol);
+        }
+        for (auto& [id, stream] : streams_)
+        {
+            if (stream.settings.symbol != symbol)
+            {
+                continue;
+            }
+            emitLadderLocked(id, stream, entry);
+            if (!stream.pendingAck.empty())
+            {
+                emitAckLocked(id, stream.pendingAck, true, symbol, "miss");
+                stream.pendingAck.clear();
+            }
+        }
+        if (gap)
+        {
+            std::cerr << "[backend] " << symbol << ": snapshot does not meet the buffered updates, reloading"
+                      << std::endl;
+            loadAsync(symbol);
+        }
+    }
+
+    void MarketFeed::publishLocked(const std::string& symbol, SymbolBook& entry, FrameTrace& trace)
+    {
+        trace.appliedUs = traceClock_();
+        entry.lastTrace = trace;
+        std::size_t ladders = 0;
+        for (auto& [id, stream] : streams_)
+        {
+            if (stream.settings.symbol == symbol)
+            {
+                const auto seq = stream.seq;
+                emitIfDueLocked(id, stream, entry, trace);
+                ladders += stream.seq != seq ? 1 : 0;
+            }
+        }
+        if (observer_)
+        {
+            observer_(trace, ladders, traceClock_());
+        }
+    }
+
+    void MarketFeed::emitLadderLocked(int id, Stream& stream, const SymbolBook& entry, const FrameTrace* trace)
+    {
+        const OrderBook& book = entry.book;
+        if (book.tickSize() <= 0.0)
+        {
+            return;
+        }
+        stream.lastEmit = clock_();
+        stream.dirty = false;
+        ++stream.seq;
+
+        // A hidden column gets a top-of-book heartbeat (ping, watchdog) and no rows;
+        // the full ladder goes out as soon as it reports itself visible again.
+        const bool topOfBook = stream.reported && !stream.visible;
+        const StreamSettings& settings = stream.settings;
+        std::vector<Level> levels;
+        if (!topOfBook)
+        {
+            levels = book.ladder(settings.levelsPerSide);
+        }
+        const double tickSize = book.tickSize();
+        double bestBid = book.bestBid();
+        double bestAsk = book.bestAsk();
+        const auto compression = static_cast<OrderBook::Tick>(std::max<std::size_t>(1, settings.compression));
+        if (compression > 1)
+        {
+            levels = compressLadder(levels, tickSize, compression);
+            bestBid = bucketPrice(bestBid, tickSize, compression);
+            bestAsk = bucketPrice(bestAsk, tickSize, compression);
+        }
+
+        json out;
+        out["type"] = "ladder";
+        out["stream"] = id;
+        out["seq"] = stream.seq;
+        out["symbol"] = settings.symbol;
+        out["timestamp"] = wallClockMs();
+        out["bestBid"] = bestBid;
+        out["bestAsk"] = bestAsk;
+        out["tickSize"] = tickSize;
+        out["compression"] = compression;
+        if (entry.stale)
+        {
+            out["stale"] = true;
+        }
+        if (topOfBook)
+        {
+            out["topOfBook"] = true;
+            out_ << out.dump() << std::endl;
+            return;
+        }
+
+        json rows = json::array();
+        for (const auto& lvl : levels)
+        {
+            rows.push_back({{"price", lvl.price}, {"bid", lvl.bidQuantity}, {"ask", lvl.askQuantity}});
+        }
+        out["rows"] = std::move(rows);
+        if (trace && trace->receivedUs > 0)
+        {
+            // Stamped last so "emitted" includes building the rows above.
+            out["trace"] = {{"exch", trace->exchangeUs},
+                            {"recv", trace->receivedUs},
+                            {"decoded", trace->decodedUs},
+                            {"applied", trace->appliedUs},
+                            {"emitted", traceClock_()}};
+        }
+        out_ << out.dump() << std::endl;
+    }
+
+    void MarketFeed::emitIfDueLocked(int id, Stream& stream, const SymbolBook& entry, const FrameTrace& trace)
+    {
+        stream.dirty = true;
+        const auto sinceLast = clock_() - stream.lastEmit;
+        if (sinceLast < emitIntervalOf(stream))
+        {
+            return;
+        }
+        // At most one ladder in flight: while the consumer has not painted the last
+        // one, the book keeps updating here and only its newest state goes out.
+        const bool pending = stream.reported && stream.visible && stream.seq > stream.renderedSeq;
+        if (pending && sinceLast < kPendingTimeout)
+        {
+            return;
+        }
+        emitLadderLocked(id, stream, entry, &trace);
+    }
+
+    void MarketFeed::emitHeartbeatsLocked(const std::string* symbol)
+    {
+        for (const auto& [id, stream] : streams_)
+        {
+            if (symbol && stream.settings.symbol != *symbol)
+            {
+                continue;
+            }
+            const auto bookIt = books_.find(stream.settings.symbol);
+            json beat;
+            beat["type"] = "heartbeat";
+            beat["stream"] = id;
+            beat["symbol"] = stream.settings.symbol;
+            beat["timestamp"] = wallClockMs();
+            beat["connected"] = static_cast<bool>(send_);
+            beat["stale"] = bookIt != books_.end() && bookIt->second.stale;
+            out_ << beat.dump() << std::endl;
+        }
+    }
+
+    void MarketFeed::onConsumerReportLocked(int id, Stream& stream, const Command& cmd)
+    {
+        const bool becameVisible = cmd.visible && !stream.visible;
+        stream.reported = true;
+        stream.visible = cmd.visible;
+        // Never let a report run ahead of what was actually sent.
+        const auto seq = static_cast<std::uint64_t>(cmd.value);
+        stream.renderedSeq = std::max(stream.renderedSeq, std::min(seq, stream.seq));
+        if (cmd.paintMs > 0.0)
+        {
+            stream.paintMs = stream.paintMs > 0.0 ? stream.paintMs * 0.8 + cmd.paintMs * 0.2 : cmd.paintMs;
+        }
+
+        const auto bookIt = books_.find(stream.settings.symbol);
+        if (bookIt == books_.end() || !bookIt->second.ready)
+        {
+            return;
+        }
+        if (becameVisible)
+        {
+            emitLadderLocked(id, stream, bookIt->second);
+        }
+        else if (stream.dirty)
+        {
+            // The consumer caught up; send what accumulated while it was busy.
+            emitIfDueLocked(id, stream, bookIt->second, bookIt->second.lastTrace);
+        }
+    }
+
+    std::chrono::milliseconds MarketFeed::emitIntervalOf(const Stream& stream)
+    {
+        const auto base = stream.settings.throttle;
+        if (!stream.reported)
+        {
+            return base;
+        }
+        if (!stream.visible)
+        {
+            return std::max(base, kHiddenInterval);
+        }
+        const auto paintBudget =
+            std::chrono::milliseconds(static_cast<std::int64_t>(std::ceil(stream.paintMs * kPaintBudgetFactor)));
+        return std::clamp(paintBudget, base, std::max(base, kMaxInterval));
+    }
+
+    void MarketFeed::emitAckLocked(int id, const std::string& cmd, bool ok, const std::string& symbol,
+                                   const char* cache, const char* error)
+    {
+        json ack;
+        ack["type"] = "ack";
+        ack["stream"] = id;
+        ack["cmd"] = cmd;
+        ack["ok"] = ok;
+        ack["symbol"] = symbol;
+        if (cache)
+        {
+            ack["cache"] = cache;
+        }
+        if (error)
+        {
+            ack["error"] = error;
+        }
+        out_ << ack.dump() << std::endl;
+    }
+
+    std::string MarketFeed::subscriptionMessage(bool subscribe, const std::string& symbol) const
+    {
+        if (venue_ == Venue::Mexc)
+        {
+            // Aggre deals channel also requires an interval suffix (10ms/100ms); without it
+            // the server replies with "Blocked" and sends no trades.
+            json sub = {{"method", subscribe ? "SUBSCRIPTION" : "UNSUBSCRIPTION"},
+                        {"params",
+                         json::array({"spot@public.aggre.depth.v3.api.pb@100ms@" + symbol,
+                                      "spot@public.aggre.deals.v3.api.pb@100ms@" + symbol})}};
+            return sub.dump();
+        }
+
+        const bool isSwap = venue_ == Venue::UzxSwap;
+        const std::string channel = isSwap ? "swap.orderBook" : "spot.orderBook";
+        const std::string biz = isSwap ? "swap" : "spot";
+        json sub = {{"event", subscribe ? "sub" : "unsub"},
+                    {"params", {{"biz", biz}, {"type", channel}, {"symbol", symbol}, {"interval", "0"}}},
+                    {"zip", false}};
+        return sub.dump();
+    }
+
+    std::size_t MarketFeed::levelsHintLocked(const std::string& symbol) const
+    {
+        std::size_t hint = 0;
+        for (const auto& [id, stream] : streams_)
+        {
+            if (stream.settings.symbol == symbol)
+            {
+                hint = std::max(hint, stream.settings.levelsPerSide);
+            }
+        }
+        return hint;
+    }
+} // namespace dom
@@ -0,0 +1,412 @@
+#include "MexcProto.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    // --- минимальный парсер protobuf под нужные сообщения ---
+
+    struct ProtoReader
+    {
+        const std::uint8_t* data{};
+        std::size_t size{};
+        std::size_t pos{};
+
+        ProtoReader() = default;
+        ProtoReader(const void* ptr, std::size_t len)
+            : data(static_cast<const std::uint8_t*>(ptr))
+            , size(len)
+            , pos(0)
+        {
+        }
+
+        bool eof() const { return pos >= size; }
+
+        bool readVarint(std::uint64_t& out)
+        {
+            out = 0;
+            int shift = 0;
+            while (pos < size && shift < 64)
+            {
+                std::uint8_t b = data[pos++];
+                out |= (std::uint64_t(b & 0x7F) << shift);
+                if ((b & 0x80) == 0)
+                {
+                    return true;
+                }
+                shift += 7;
+            }
+            return false;
+        }
+
+        bool readBytes(std::size_t n, std::string& out)
+        {
+            if (pos + n > size)
+            {
+                return false;
+            }
+            out.assign(reinterpret_cast<const char*>(data + pos), n);
+            pos += n;
+            return true;
+        }
+
+        bool readLengthDelimited(std::string& out)
+        {
+            std::uint64_t len = 0;
+            if (!readVarint(len))
+            {
+                return false;
+            }
+            return readBytes(static_cast<std::size_t>(len), out);
+        }
+
+        bool skipField(std::uint64_t key)
+        {
+            const auto wireType = key & 0x7;
+            switch (wireType)
+            {
+            case 0: // varint
+            {
+                std::uint64_t dummy;
+                return readVarint(dummy);
+            }
+            case 1: // 64-bit
+                if (pos + 8 > size) return false;
+                pos += 8;
+                return true;
+            case 2: // length-delimited
+            {
+                std::uint64_t len = 0;
+                if (!readVarint(len) || pos + len > size)
+                {
+                    return false;
+                }
+                pos += static_cast<std::size_t>(len);
+                return true;
+            }
+            case 5: // 32-bit
+                if (pos + 4 > size) return false;
+                pos += 4;
+                return true;
+            default:
+                return false;
+            }
+        }
+    };
+
+    void parseDepthItem(const std::string& buf,
+                        double tickSize,
+                        std::vector<std::pair<dom::OrderBook::Tick, double>>& out)
+    {
+        ProtoReader r(buf.data(), buf.size());
+        std::string priceStr;
+        std::string qtyStr;
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            const auto field = key >> 3;
+            if ((key & 0x7) != 2)
+            {
+                if (!r.skipField(key)) break;
+                continue;
+            }
+
+            std::string value;
+            if (!r.readLengthDelimited(value)) break;
+
+            if (field == 1)
+            {
+                priceStr = value;
+            }
+            else if (field == 2)
+            {
+                qtyStr = value;
+            }
+        }
+
+        if (!priceStr.empty() && tickSize > 0.0)
+        {
+            double price = std::stod(priceStr);
+            double qty = qtyStr.empty() ? 0.0 : std::stod(qtyStr);
+            auto tick = static_cast<dom::OrderBook::Tick>(std::llround(price / tickSize));
+            out.emplace_back(tick, qty);
+        }
+    }
+
+    void parseAggreDepth(const std::string& buf,
+                         double tickSize,
+                         std::vector<std::pair<dom::OrderBook::Tick, double>>& asks,
+                         std::vector<std::pair<dom::OrderBook::Tick, double>>& bids,
+                         dom::DepthVersions& versions)
+    {
+        ProtoReader r(buf.data(), buf.size());
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            const auto field = key >> 3;
+            if ((key & 0x7) != 2)
+            {
+                if (!r.skipField(key)) break;
+                continue;
+            }
+
+            std::string msg;
+            if (!r.readLengthDelimited(msg)) break;
+
+            if (field == 1) // asks
+            {
+                parseDepthItem(msg, tickSize, asks);
+            }
+            else if (field == 2) // bids
+            {
+                parseDepthItem(msg, tickSize, bids);
+            }
+            else if (field == 4)
+            {
+                versions.from = std::strtoull(msg.c_str(), nullptr, 10);
+            }
+            else if (field == 5)
+            {
+                versions.to = std::strtoull(msg.c_str(), nullptr, 10);
+            }
+        }
+    }
+
+
+    void parseAggreDealItem(const std::string& buf,
+                            std::vector<dom::PublicAggreDeal>& out)
+    {
+        ProtoReader r(buf.data(), buf.size());
+        std::string priceStr;
+        std::string qtyStr;
+        int tradeType = 0;
+        std::int64_t time = 0;
+
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            const auto field = key >> 3;
+            const auto wire = key & 0x7;
+
+            if (wire == 2)
+            {
+                std::string value;
+                if (!r.readLengthDelimited(value)) break;
+                if (field == 1)
+                {
+                    priceStr = value;
+                }
+                else if (field == 2)
+                {
+                    qtyStr = value;
+                }
+            }
+            else if (wire == 0)
+            {
+                std::uint64_t v = 0;
+                if (!r.readVarint(v)) break;
+                if (field == 3)
+                {
+                    tradeType = static_cast<int>(v);
+                }
+                else if (field == 4)
+                {
+                    time = static_cast<std::int64_t>(v);
+                }
+            }
+            else
+            {
+                if (!r.skipField(key)) break;
+            }
+        }
+
+        if (!priceStr.empty())
+        {
+            double price = std::stod(priceStr);
+            double qty = qtyStr.empty() ? 0.0 : std::stod(qtyStr);
+            if (qty <= 0.0) return;
+
+            dom::PublicAggreDeal d;
+            d.price = price;
+            d.quantity = qty;
+            d.time = time;
+            // tradeType: 1/2 — точное значение зависит от биржи; считаем 1=buy,2=sell
+            d.buy = (tradeType != 2);
+            out.push_back(d);
+        }
+    }
+
+    void parseAggreDeals(const std::string& buf,
+                         std::vector<dom::PublicAggreDeal>& out)
+    {
+        ProtoReader r(buf.data(), buf.size());
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            const auto field = key >> 3;
+            if ((key & 0x7) != 2)
+            {
+                if (!r.skipField(key)) break;
+                continue;
+            }
+
+            std::string msg;
+            if (!r.readLengthDelimited(msg)) break;
+
+            if (field == 1) // repeated deals
+            {
+                parseAggreDealItem(msg, out);
+            }
+            // field 2 = eventType (string) — игнорируем
+        }
+    }
+} // namespace
+
+namespace dom
+{
+    std::string_view peekChannel(const void* data, std::size_t len)
+    {
+        ProtoReader r(data, len);
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            if (key == ((1u << 3) | 2u))
+            {
+                std::uint64_t n = 0;
+                if (!r.readVarint(n) || r.pos + n > r.size) break;
+                return {reinterpret_cast<const char*>(r.data + r.pos), static_cast<std::size_t>(n)};
+            }
+            if (!r.skipField(key)) break;
+        }
+        return {};
+    }
+
+    std::int64_t peekSendTime(const void* data, std::size_t len)
+    {
+        ProtoReader r(data, len);
+        std::uint64_t createTime = 0;
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            const auto field = key >> 3;
+            if ((key & 0x7) == 0 && (field == 5 || field == 6))
+            {
+                std::uint64_t value = 0;
+                if (!r.readVarint(value)) break;
+                if (field == 6)
+                {
+                    return static_cast<std::int64_t>(value);
+                }
+                createTime = value;
+                continue;
+            }
+            if (!r.skipField(key)) break;
+        }
+        return static_cast<std::int64_t>(createTime);
+    }
+
+    std::string_view symbolFromChannel(std::string_view channel)
+    {
+        const auto at = channel.rfind('@');
+        return at == std::string_view::npos ? channel : channel.substr(at + 1);
+    }
+
+    bool parsePushWrapper(const void* data,
+                          std::size_t len,
+                          std::string& channelOut,
+                          double tickSize,
+                          std::vector<std::pair<dom::OrderBook::Tick, double>>& asks,
+                          std::vector<std::pair<dom::OrderBook::Tick, double>>& bids,
+                          DepthVersions& versions)
+    {
+        ProtoReader r(data, len);
+        std::string depthBody;
+
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            const auto field = key >> 3;
+
+            if ((key & 0x7) != 2)
+            {
+                if (!r.skipField(key)) break;
+                continue;
+            }
+
+            std::string value;
+            if (!r.readLengthDelimited(value)) break;
+
+            if (field == 1)
+            {
+                channelOut = value;
+            }
+            else if (field == 313)
+            {
+                depthBody = std::move(value);
+            }
+        }
+
+        if (depthBody.empty())
+        {
+            return false;
+        }
+
+        asks.clear();
+        bids.clear();
+        versions = {};
+        parseAggreDepth(depthBody, tickSize, asks, bids, versions);
+        return true;
+    }
+
+    bool parseDealsFromWrapper(const void* data,
+                               std::size_t len,
+                               std::string& channelOut,
+                               std::vector<PublicAggreDeal>& deals)
+    {
+        ProtoReader r(data, len);
+        std::string dealsBody;
+
+        while (!r.eof())
+        {
+            std::uint64_t key = 0;
+            if (!r.readVarint(key)) break;
+            const auto field = key >> 3;
+
+            if ((key & 0x7) != 2)
+            {
+                if (!r.skipField(key)) break;
+                continue;
+            }
+
+            std::string value;
+            if (!r.readLengthDelimited(value)) break;
+
+            if (field == 1)
+            {
+                channelOut = value;
+            }
+            else if (field == 314)
+            {
+                dealsBody = std::move(value);
+            }
+        }
+
+        if (dealsBody.empty())
+        {
+            return false;
+        }
+
+        deals.clear();
+        parseAggreDeals(dealsBody, deals);
+        return !deals.empty();
+    }
+} // namespace dom
@@ -12,6 +12,7 @@ namespace dom
         bids_.clear();
         asks_.clear();
         // tickSize_ is configured separately via setTickSize()
+        version_ = 0;
         centerTick_ = 0;
         hasCenter_ = false;
     }
@@ -129,6 +130,21 @@ namespace dom
         return tickSize_;
     }
 
+    void OrderBook::setVersion(std::uint64_t version)
+    {
+        version_ = version;
+    }
+
+    std::uint64_t OrderBook::version() const
+    {
+        return version_;
+    }
+
+    std::size_t OrderBook::levelCount() const
+    {
+        return bids_.size() + asks_.size();
+    }
+
     std::vector<Level> OrderBook::ladder(std::size_t levelsPerSide) const
     {
         std::vector<Level> result;
@@ -0,0 +1,51 @@
+#include "Transport.hpp"
+
+#include <stdexcept>
+
+namespace dom
+{
+    Endpoint parseEndpoint(const std::string& url)
+    {
+        const auto schemeEnd = url.find("://");
+        if (schemeEnd == std::string::npos)
+        {
+            throw std::runtime_error("endpoint needs a scheme: " + url);
+        }
+        const std::string scheme = url.substr(0, schemeEnd);
+        Endpoint ep;
+        if (scheme == "wss" || scheme == "https")
+        {
+            ep.secure = true;
+            ep.port = 443;
+        }
+        else if (scheme == "ws" || scheme == "http")
+        {
+            ep.secure = false;
+            ep.port = 80;
+        }
+        else
+        {
+            throw std::runtime_error("unsupported endpoint scheme: " + scheme);
+        }
+
+        std::string rest = url.substr(schemeEnd + 3);
+        const auto slash = rest.find('/');
+        if (slash != std::string::npos)
+        {
+            ep.path = rest.substr(slash);
+            rest.resize(slash);
+        }
+        const auto colon = rest.rfind(':');
+        if (colon != std::string::npos)
+        {
+            ep.port = static_cast<std::uint16_t>(std::stoul(rest.substr(colon + 1)));
+            rest.resize(colon);
+        }
+        if (rest.empty())
+        {
+            throw std::runtime_error("endpoint has no host: " + url);
+        }
+        ep.host = rest;
+        return ep;
+    }
+} // namespace dom
@@ -0,0 +1,323 @@
+#include "WebSocketCodec.hpp"
+
+#include <array>
+#include <random>
+
+namespace dom::ws
+{
+    namespace
+    {
+        constexpr std::string_view kGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+        std::mt19937& rng()
+        {
+            // Masking keys only need to be unpredictable to intermediaries, not secret.
+            thread_local std::mt19937 engine{std::random_device{}()};
+            return engine;
+        }
+
+        std::uint32_t rotl(std::uint32_t x, int n)
+        {
+            return (x << n) | (x >> (32 - n));
+        }
+
+        // Only used for the handshake accept value, so a plain byte-at-a-time SHA-1 does.
+        std::array<unsigned char, 20> sha1(std::string_view data)
+        {
+            std::uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+            std::string msg(data);
+            const std::uint64_t bitLen = static_cast<std::uint64_t>(data.size()) * 8;
+            msg.push_back(static_cast<char>(0x80));
+            while (msg.size() % 64 != 56)
+            {
+                msg.push_back('\0');
+            }
+            for (int i = 7; i >= 0; --i)
+            {
+                msg.push_back(static_cast<char>((bitLen >> (i * 8)) & 0xFF));
+            }
+
+            for (std::size_t chunk = 0; chunk < msg.size(); chunk += 64)
+            {
+                std::uint32_t w[80];
+                for (int i = 0; i < 16; ++i)
+                {
+                    const auto* p = reinterpret_cast<const unsigned char*>(msg.data() + chunk + i * 4);
+                    w[i] = (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) |
+                           std::uint32_t(p[3]);
+                }
+                for (int i = 16; i < 80; ++i)
+                {
+                    w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+                }
+
+                std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                for (int i = 0; i < 80; ++i)
+                {
+                    std::uint32_t f = 0;
+                    std::uint32_t k = 0;
+                    if (i < 20)
+                    {
+                        f = (b & c) | (~b & d);
+                        k = 0x5A827999;
+                    }
+                    else if (i < 40)
+                    {
+                        f = b ^ c ^ d;
+                        k = 0x6ED9EBA1;
+                    }
+                    else if (i < 60)
+                    {
+                        f = (b & c) | (b & d) | (c & d);
+                        k = 0x8F1BBCDC;
+                    }
+                    else
+                    {
+                        f = b ^ c ^ d;
+                        k = 0xCA62C1D6;
+                    }
+                    const std::uint32_t t = rotl(a, 5) + f + e + k + w[i];
+                    e = d;
+                    d = c;
+                    c = rotl(b, 30);
+                    b = a;
+                    a = t;
+                }
+                h[0] += a;
+                h[1] += b;
+                h[2] += c;
+                h[3] += d;
+                h[4] += e;
+            }
+
+            std::array<unsigned char, 20> out{};
+            for (int i = 0; i < 20; ++i)
+            {
+                out[i] = static_cast<unsigned char>((h[i / 4] >> (24 - 8 * (i % 4))) & 0xFF);
+            }
+            return out;
+        }
+
+        std::string base64(const unsigned char* data, std::size_t len)
+        {
+            static constexpr char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string out;
+            out.reserve((len + 2) / 3 * 4);
+            for (std::size_t i = 0; i < len; i += 3)
+            {
+                const std::uint32_t n = (std::uint32_t(data[i]) << 16) |
+                                        (i + 1 < len ? std::uint32_t(data[i + 1]) << 8 : 0) |
+                                        (i + 2 < len ? std::uint32_t(data[i + 2]) : 0);
+                out.push_back(table[(n >> 18) & 63]);
+                out.push_back(table[(n >> 12) & 63]);
+                out.push_back(i + 1 < len ? table[(n >> 6) & 63] : '=');
+                out.push_back(i + 2 < len ? table[n & 63] : '=');
+            }
+            return out;
+        }
+
+        bool isControl(Opcode op)
+        {
+            return (static_cast<std::uint8_t>(op) & 0x8) != 0;
+        }
+    } // namespace
+
+    std::string makeClientKey()
+    {
+        unsigned char bytes[16];
+        for (auto& b : bytes)
+        {
+            b = static_cast<unsigned char>(rng()() & 0xFF);
+        }
+        return base64(bytes, sizeof(bytes));
+    }
+
+    std::string acceptFor(std::string_view clientKey)
+    {
+        std::string text(clientKey);
+        text += kGuid;
+        const auto digest = sha1(text);
+        return base64(digest.data(), digest.size());
+    }
+
+    void appendClientFrame(std::string& out, Opcode opcode, std::string_view payload)
+    {
+        out.push_back(static_cast<char>(0x80 | static_cast<std::uint8_t>(opcode)));
+        const std::uint64_t len = payload.size();
+        if (len < 126)
+        {
+            out.push_back(static_cast<char>(0x80 | len));
+        }
+        else if (len <= 0xFFFF)
+        {
+            out.push_back(static_cast<char>(0x80 | 126));
+            out.push_back(static_cast<char>((len >> 8) & 0xFF));
+            out.push_back(static_cast<char>(len & 0xFF));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0x80 | 127));
+            for (int i = 7; i >= 0; --i)
+            {
+                out.push_back(static_cast<char>((len >> (i * 8)) & 0xFF));
+            }
+        }
+
+        const std::uint32_t key = rng()();
+        const unsigned char mask[4] = {static_cast<unsigned char>(key >> 24),
+                                       static_cast<unsigned char>(key >> 16),
+                                       static_cast<unsigned char>(key >> 8),
+                                       static_cast<unsigned char>(key)};
+        out.append(reinterpret_cast<const char*>(mask), 4);
+        const std::size_t start = out.size();
+        out.append(payload.data(), payload.size());
+        for (std::size_t i = 0; i < payload.size(); ++i)
+        {
+            out[start + i] = static_cast<char>(out[start + i] ^ mask[i & 3]);
+        }
+    }
+
+    FrameParser::FrameParser(std::size_t maxMessage)
+        : maxMessage_(maxMessage)
+    {
+    }
+
+    void FrameParser::feed(const char* data, std::size_t len, std::int64_t receivedUs)
+    {
+        if (offset_ == buffer_.size())
+        {
+            buffer_.clear();
+            offset_ = 0;
+            headUs_ = receivedUs;
+        }
+        else if (offset_ > 64 * 1024 && offset_ * 2 > buffer_.size())
+        {
+            buffer_.erase(0, offset_);
+            offset_ = 0;
+        }
+        buffer_.append(data, len);
+        lastFeedUs_ = receivedUs;
+    }
+
+    FrameParser::Status FrameParser::next(Message& out)
+    {
+        for (;;)
+        {
+            const std::size_t avail = buffer_.size() - offset_;
+            if (avail < 2)
+            {
+                return Status::NeedMore;
+            }
+            const auto* p = reinterpret_cast<const unsigned char*>(buffer_.data() + offset_);
+            const bool fin = (p[0] & 0x80) != 0;
+            const auto opcode = static_cast<Opcode>(p[0] & 0x0F);
+            const bool masked = (p[1] & 0x80) != 0;
+            std::uint64_t len = p[1] & 0x7F;
+            std::size_t header = 2;
+            if (len == 126)
+            {
+                if (avail < 4)
+                {
+                    return Status::NeedMore;
+                }
+                len = (std::uint64_t(p[2]) << 8) | p[3];
+                header = 4;
+            }
+            else if (len == 127)
+            {
+                if (avail < 10)
+                {
+                    return Status::NeedMore;
+                }
+                len = 0;
+                for (int i = 0; i < 8; ++i)
+                {
+                    len = (len << 8) | p[2 + i];
+                }
+                header = 10;
+            }
+            if ((p[0] & 0x70) != 0)
+            {
+                error_ = "reserved bits set (no extensions were negotiated)";
+                return Status::Error;
+            }
+            if (masked)
+            {
+                error_ = "server frame is masked";
+                return Status::Error;
+            }
+            if (isControl(opcode) && (!fin || len > 125))
+            {
+                error_ = "fragmented or oversized control frame";
+                return Status::Error;
+            }
+            if (len > maxMessage_ || fragments_.size() + len > maxMessage_)
+            {
+                error_ = "message larger than " + std::to_string(maxMessage_) + " bytes";
+                return Status::Error;
+            }
+            if (avail < header + len)
+            {
+                return Status::NeedMore;
+            }
+
+            const std::string_view payload(buffer_.data() + offset_ + header, static_cast<std::size_t>(len));
+            const std::int64_t frameUs = headUs_;
+            offset_ += header + static_cast<std::size_t>(len);
+            // Whatever follows came in with the latest read at the earliest.
+            headUs_ = lastFeedUs_;
+
+            if (isControl(opcode))
+            {
+                out.opcode = opcode;
+                out.payload.assign(payload);
+                out.receivedUs = frameUs;
+                return Status::Message;
+            }
+
+            if (opcode == Opcode::Continuation)
+            {
+                if (!inFragment_)
+                {
+                    error_ = "continuation frame without a message";
+                    return Status::Error;
+                }
+                fragments_.append(payload);
+                if (!fin)
+                {
+                    continue;
+                }
+                out.opcode = fragmentOpcode_;
+                out.payload.swap(fragments_);
+                out.receivedUs = fragmentUs_;
+                fragments_.clear();
+                inFragment_ = false;
+                return Status::Message;
+            }
+
+            if (opcode != Opcode::Text && opcode != Opcode::Binary)
+            {
+                error_ = "unknown opcode " + std::to_string(static_cast<int>(opcode));
+                return Status::Error;
+            }
+            if (inFragment_)
+            {
+                error_ = "new message before the fragmented one finished";
+                return Status::Error;
+            }
+            if (!fin)
+            {
+                inFragment_ = true;
+                fragmentOpcode_ = opcode;
+                fragmentUs_ = frameUs;
+                fragments_.assign(payload);
+                continue;
+            }
+            out.opcode = opcode;
+            out.payload.assign(payload);
+            out.receivedUs = frameUs;
+            return Status::Message;
+        }
+    }
+} // namespace dom::ws
@@ -0,0 +1,383 @@
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <winhttp.h>
+
+#include "MarketFeed.hpp"
+#include "Transport.hpp"
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dom
+{
+    namespace
+    {
+        // Larger messages are dropped rather than buffered without bound.
+        constexpr std::size_t kMaxMessage = 16 * 1024 * 1024;
+
+        std::string winhttpError(const char* where)
+        {
+            DWORD error = GetLastError();
+            LPWSTR buffer = nullptr;
+            DWORD len =
+                FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM |
+                                   FORMAT_MESSAGE_IGNORE_INSERTS,
+                               nullptr,
+                               error,
+                               0,
+                               reinterpret_cast<LPWSTR>(&buffer),
+                               0,
+                               nullptr);
+            std::string msg = where;
+            msg += ": ";
+            if (len && buffer)
+            {
+                int outLen = WideCharToMultiByte(CP_UTF8, 0, buffer, len, nullptr, 0, nullptr, nullptr);
+                std::string utf8(outLen, '\0');
+                WideCharToMultiByte(CP_UTF8, 0, buffer, len, utf8.data(), outLen, nullptr, nullptr);
+                msg += utf8;
+                LocalFree(buffer);
+            }
+            else
+            {
+                msg += "unknown error";
+            }
+            return msg;
+        }
+
+        struct WinHttpHandle
+        {
+            WinHttpHandle() = default;
+            explicit WinHttpHandle(HINTERNET h) : handle(h) {}
+            ~WinHttpHandle() { reset(); }
+
+            WinHttpHandle(const WinHttpHandle&) = delete;
+            WinHttpHandle& operator=(const WinHttpHandle&) = delete;
+
+            WinHttpHandle(WinHttpHandle&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+            WinHttpHandle& operator=(WinHttpHandle&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    handle = other.handle;
+                    other.handle = nullptr;
+                }
+                return *this;
+            }
+
+            void reset(HINTERNET h = nullptr)
+            {
+                if (handle)
+                {
+                    WinHttpCloseHandle(handle);
+                }
+                handle = h;
+            }
+
+            [[nodiscard]] bool valid() const { return handle != nullptr; }
+            [[nodiscard]] HINTERNET get() const { return handle; }
+
+        private:
+            HINTERNET handle{nullptr};
+        };
+
+        std::wstring toWide(const std::string& s)
+        {
+            if (s.empty())
+            {
+                return {};
+            }
+            int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
+            std::wstring out(len - 1, L'\0');
+            MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, out.data(), len);
+            return out;
+        }
+
+        // Session, connection and an opened request for GET server/path.
+        struct WinHttpRequest
+        {
+            WinHttpHandle session;
+            WinHttpHandle connection;
+            WinHttpHandle request;
+        };
+
+        std::optional<WinHttpRequest> openRequest(const Endpoint& server, const std::string& pathAndQuery)
+        {
+            WinHttpRequest r;
+            r.session.reset(WinHttpOpen(L"ShahTerminal/1.0", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, nullptr, nullptr, 0));
+            if (!r.session.valid())
+            {
+                std::cerr << "[backend] " << winhttpError("WinHttpOpen") << std::endl;
+                return std::nullopt;
+            }
+
+            r.connection.reset(WinHttpConnect(r.session.get(), toWide(server.host).c_str(), server.port, 0));
+            if (!r.connection.valid())
+            {
+                std::cerr << "[backend] " << winhttpError("WinHttpConnect") << std::endl;
+                return std::nullopt;
+            }
+
+            r.request.reset(WinHttpOpenRequest(r.connection.get(),
+                                               L"GET",
+                                               toWide(pathAndQuery.empty() ? "/" : pathAndQuery).c_str(),
+                                               nullptr,
+                                               WINHTTP_NO_REFERER,
+                                               WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                               server.secure ? WINHTTP_FLAG_SECURE : 0));
+            if (!r.request.valid())
+            {
+                std::cerr << "[backend] " << winhttpError("WinHttpOpenRequest") << std::endl;
+                return std::nullopt;
+            }
+            return r;
+        }
+
+        bool sendAndReceive(HINTERNET request)
+        {
+            if (!WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0, WINHTTP_NO_REQUEST_DATA, 0, 0, 0))
+            {
+                std::cerr << "[backend] " << winhttpError("WinHttpSendRequest") << std::endl;
+                return false;
+            }
+            if (!WinHttpReceiveResponse(request, nullptr))
+            {
+                std::cerr << "[backend] " << winhttpError("WinHttpReceiveResponse") << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        class WinHttpWebSocket final : public WebSocket
+        {
+        public:
+            WinHttpWebSocket(WinHttpRequest handles, HINTERNET socket)
+                : handles_(std::move(handles))
+                , socket_(socket)
+            {
+            }
+
+            ~WinHttpWebSocket() override { WinHttpCloseHandle(socket_); }
+
+            bool sendText(std::string_view text) override
+            {
+                std::lock_guard<std::mutex> lock(sendMutex_);
+                if (closing_)
+                {
+                    return false;
+                }
+                return WinHttpWebSocketSend(socket_,
+                                            WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
+                                            const_cast<char*>(text.data()),
+                                            static_cast<DWORD>(text.size())) == S_OK;
+            }
+
+            void close() override
+            {
+                std::lock_guard<std::mutex> lock(sendMutex_);
+                if (!closing_)
+                {
+                    closing_ = true;
+                    // The blocked receive sees the close handshake and returns.
+                    WinHttpWebSocketShutdown(socket_, WINHTTP_WEB_SOCKET_SUCCESS_CLOSE_STATUS, nullptr, 0);
+                }
+            }
+
+            // Blocks in WinHttpWebSocketReceive until the socket ends; returns why.
+            std::string receiveLoop(const WebSocketHandler& handler)
+            {
+                std::vector<unsigned char> buffer(256 * 1024);
+                std::string message;
+                std::int64_t firstFragmentUs = 0;
+                bool dropping = false;
+
+                for (;;)
+                {
+                    DWORD received = 0;
+                    WINHTTP_WEB_SOCKET_BUFFER_TYPE type;
+                    HRESULT hr = WinHttpWebSocketReceive(
+                        socket_, buffer.data(), static_cast<DWORD>(buffer.size()), &received, &type);
+                    const std::int64_t receivedUs = wallClockUs();
+                    if (FAILED(hr))
+                    {
+                        return "receive failed: " + std::to_string(static_cast<unsigned long>(hr));
+                    }
+                    if (type == WINHTTP_WEB_SOCKET_CLOSE_BUFFER_TYPE)
+                    {
+                        return "closed by server";
+                    }
+
+                    // WinHTTP keeps message boundaries; a message larger than the buffer
+                    // or sent in pieces arrives as fragments followed by the final part.
+                    const bool text = type == WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE ||
+                                      type == WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE;
+                    const bool fragment = type == WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE ||
+                                          type == WINHTTP_WEB_SOCKET_BINARY_FRAGMENT_BUFFER_TYPE;
+                    if (message.empty() && !dropping)
+                    {
+                        firstFragmentUs = receivedUs;
+                    }
+                    if (!dropping)
+                    {
+                        message.append(reinterpret_cast<const char*>(buffer.data()), received);
+                        if (message.size() > kMaxMessage)
+                        {
+                            std::cerr << "[backend] ws message over " << kMaxMessage << " bytes, dropping" << std::endl;
+                            message.clear();
+                            dropping = true;
+                        }
+                    }
+                    if (fragment)
+                    {
+                        continue;
+                    }
+                    if (!dropping && !message.empty() && handler.onMessage)
+                    {
+                        handler.onMessage(text ? MessageType::Text : MessageType::Binary, message, firstFragmentUs);
+                    }
+                    message.clear();
+                    dropping = false;
+                }
+            }
+
+        private:
+            WinHttpRequest handles_;
+            HINTERNET socket_;
+            std::mutex sendMutex_;
+            bool closing_{false};
+        };
+
+        class WinHttpTransport final : public Transport
+        {
+        public:
+            ~WinHttpTransport() override
+            {
+                stop();
+                for (auto& t : threads_)
+                {
+                    if (t.joinable())
+                    {
+                        t.join();
+                    }
+                }
+            }
+
+            std::optional<std::string> httpGet(const Endpoint& server, const std::string& pathAndQuery) override
+            {
+                auto r = openRequest(server, pathAndQuery);
+                if (!r || !sendAndReceive(r->request.get()))
+                {
+                    return std::nullopt;
+                }
+
+                std::string buffer;
+                for (;;)
+                {
+                    DWORD bytesAvailable = 0;
+                    if (!WinHttpQueryDataAvailable(r->request.get(), &bytesAvailable))
+                    {
+                        std::cerr << "[backend] " << winhttpError("WinHttpQueryDataAvailable") << std::endl;
+                        return std::nullopt;
+                    }
+                    if (bytesAvailable == 0)
+                    {
+                        break;
+                    }
+
+                    std::string chunk(bytesAvailable, '\0');
+                    DWORD bytesRead = 0;
+                    if (!WinHttpReadData(r->request.get(), chunk.data(), bytesAvailable, &bytesRead))
+                    {
+                        std::cerr << "[backend] " << winhttpError("WinHttpReadData") << std::endl;
+                        return std::nullopt;
+                    }
+                    chunk.resize(bytesRead);
+                    buffer += chunk;
+                }
+                return buffer;
+            }
+
+            std::shared_ptr<WebSocket> connect(const Endpoint& server, WebSocketHandler handler) override
+            {
+                auto r = openRequest(server, server.path);
+                if (!r)
+                {
+                    return nullptr;
+                }
+                if (!WinHttpSetOption(r->request.get(), WINHTTP_OPTION_UPGRADE_TO_WEB_SOCKET, nullptr, 0))
+                {
+                    std::cerr << "[backend] " << winhttpError("WinHttpSetOption") << std::endl;
+                    return nullptr;
+                }
+                if (!sendAndReceive(r->request.get()))
+                {
+                    return nullptr;
+                }
+                HINTERNET rawSocket = WinHttpWebSocketCompleteUpgrade(r->request.get(), 0);
+                if (!rawSocket)
+                {
+                    std::cerr << "[backend] " << winhttpError("WinHttpWebSocketCompleteUpgrade") << std::endl;
+                    return nullptr;
+                }
+                r->request.reset();
+
+                auto socket = std::make_shared<WinHttpWebSocket>(std::move(*r), rawSocket);
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    sockets_.push_back(socket);
+                    ++active_;
+                }
+                // WinHTTP receives block, so every socket gets its own thread.
+                threads_.emplace_back([this, socket, handler = std::move(handler)]() {
+                    if (handler.onOpen)
+                    {
+                        handler.onOpen(*socket);
+                    }
+                    const std::string reason = socket->receiveLoop(handler);
+                    if (handler.onClose)
+                    {
+                        handler.onClose(reason);
+                    }
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --active_;
+                    cv_.notify_all();
+                });
+                return socket;
+            }
+
+            void run() override
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return active_ == 0 || stopped_; });
+            }
+
+            void stop() override
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopped_ = true;
+                for (auto& socket : sockets_)
+                {
+                    socket->close();
+                }
+                cv_.notify_all();
+            }
+
+        private:
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            std::vector<std::shared_ptr<WinHttpWebSocket>> sockets_;
+            std::vector<std::thread> threads_;
+            int active_{0};
+            bool stopped_{false};
+        };
+    } // namespace
+
+    std::unique_ptr<Transport> makeTransport()
+    {
+        return std::make_unique<WinHttpTransport>();
+    }
+} // namespace dom
@@ -1,19 +1,25 @@
-#ifdef _WIN32
-#    define WIN32_LEAN_AND_MEAN
-#    include <windows.h>
-#    include <winhttp.h>
-#else
-#    error "This backend is implemented for Windows (WinHTTP) only."
-#endif
-
+#include "Bench.hpp"
+#include "CommandChannel.hpp"
+#include "FrameLog.hpp"
+#include "MarketFeed.hpp"
 #include "OrderBook.hpp"
+#include "Transport.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <random>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -27,16 +33,52 @@ namespace
     using namespace std::chrono_literals;
     using json = nlohmann::json;
 
+    using dom::Endpoint;
+    using dom::parseEndpoint;
+
     struct Config
     {
         std::string symbol{"BIOUSDT"};
-        std::string endpoint{"wss://wbs-api.mexc.com/ws"};
+        std::string endpoint;     // WebSocket URL; empty: the exchange's own
+        std::string restEndpoint; // REST base URL; empty: the exchange's own
         std::string exchange{"mexc"};
         std::size_t ladderLevelsPerSide{120};
         std::chrono::milliseconds throttle{50};
         std::size_t snapshotDepth{500};
+        std::size_t compression{1};
+        // No startup stream: every symbol arrives via "subscribe" on stdin.
+        bool multiplex{false};
+        // Books kept current after their last stream left (MarketFeed::setWarmCache).
+        std::size_t warmSymbols{6};
+        std::size_t warmCacheMb{16};
+        std::string capturePath;
+        std::string replayPath;
+        double replaySpeed{1.0}; // 0: as fast as possible
+        // Headless throughput run over --replay's capture or a synthetic session.
+        bool bench{false};
+        std::size_t benchFrames{200000};
+        std::size_t benchSymbols{1};
     };
 
+    double parseSpeed(const std::string& text)
+    {
+        if (text == "max")
+        {
+            return 0.0;
+        }
+        std::string number = text;
+        if (!number.empty() && (number.back() == 'x' || number.back() == 'X'))
+        {
+            number.pop_back();
+        }
+        const double speed = std::stod(number);
+        if (speed <= 0.0)
+        {
+            throw std::runtime_error("--speed must be positive or \"max\"");
+        }
+        return speed;
+    }
+
     Config parseArgs(int argc, char** argv)
     {
         Config cfg;
@@ -60,6 +102,10 @@ namespace
             {
                 cfg.endpoint = value("--endpoint");
             }
+            else if (arg == "--rest-endpoint")
+            {
+                cfg.restEndpoint = value("--rest-endpoint");
+            }
             else if (arg == "--exchange")
             {
                 cfg.exchange = value("--exchange");
@@ -76,6 +122,46 @@ namespace
             {
                 cfg.snapshotDepth = std::stoul(value("--snapshot-depth"));
             }
+            else if (arg == "--compression")
+            {
+                cfg.compression = std::stoul(value("--compression"));
+            }
+            else if (arg == "--multiplex")
+            {
+                cfg.multiplex = true;
+            }
+            else if (arg == "--warm-symbols")
+            {
+                cfg.warmSymbols = std::stoul(value("--warm-symbols"));
+            }
+            else if (arg == "--warm-cache-mb")
+            {
+                cfg.warmCacheMb = std::stoul(value("--warm-cache-mb"));
+            }
+            else if (arg == "--capture")
+            {
+                cfg.capturePath = value("--capture");
+            }
+            else if (arg == "--replay")
+            {
+                cfg.replayPath = value("--replay");
+            }
+            else if (arg == "--speed")
+            {
+                cfg.replaySpeed = parseSpeed(value("--speed"));
+            }
+            else if (arg == "--bench")
+            {
+                cfg.bench = true;
+            }
+            else if (arg == "--bench-frames")
+            {
+                cfg.benchFrames = std::stoul(value("--bench-frames"));
+            }
+            else if (arg == "--bench-symbols")
+            {
+                cfg.benchSymbols = std::max<std::size_t>(1, std::stoul(value("--bench-symbols")));
+            }
         }
 
         if (cfg.ladderLevelsPerSide == 0)
@@ -87,174 +173,108 @@ namespace
         {
             cfg.snapshotDepth = 50;
         }
-
-        return cfg;
-    }
-
-    std::string winhttpError(const char* where)
-    {
-        DWORD error = GetLastError();
-        LPWSTR buffer = nullptr;
-        DWORD len =
-            FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM |
-                               FORMAT_MESSAGE_IGNORE_INSERTS,
-                           nullptr,
-                           error,
-                           0,
-                           reinterpret_cast<LPWSTR>(&buffer),
-                           0,
-                           nullptr);
-        std::string msg = where;
-        msg += ": ";
-        if (len && buffer)
+        // Fail on a bad URL now rather than when the first request goes out.
+        if (!cfg.endpoint.empty())
         {
-            int outLen = WideCharToMultiByte(CP_UTF8, 0, buffer, len, nullptr, 0, nullptr, nullptr);
-            std::string utf8(outLen, '\0');
-            WideCharToMultiByte(CP_UTF8, 0, buffer, len, utf8.data(), outLen, nullptr, nullptr);
-            msg += utf8;
-            LocalFree(buffer);
+            parseEndpoint(cfg.endpoint);
         }
-        else
+        if (!cfg.restEndpoint.empty())
         {
-            msg += "unknown error";
-        }
-        return msg;
-    }
-
-    struct WinHttpHandle
-    {
-        WinHttpHandle() = default;
-        explicit WinHttpHandle(HINTERNET h) : handle(h) {}
-        ~WinHttpHandle() { reset(); }
-
-        WinHttpHandle(const WinHttpHandle&) = delete;
-        WinHttpHandle& operator=(const WinHttpHandle&) = delete;
-
-        WinHttpHandle(WinHttpHandle&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
-        WinHttpHandle& operator=(WinHttpHandle&& other) noexcept
-        {
-            if (this != &other)
-            {
-                reset();
-                handle = other.handle;
-                other.handle = nullptr;
-            }
-            return *this;
+            parseEndpoint(cfg.restEndpoint);
         }
+        cfg.compression = std::max<std::size_t>(1, cfg.compression);
 
-        void reset(HINTERNET h = nullptr)
-        {
-            if (handle)
-            {
-                WinHttpCloseHandle(handle);
-            }
-            handle = h;
-        }
-
-        [[nodiscard]] bool valid() const { return handle != nullptr; }
-        [[nodiscard]] HINTERNET get() const { return handle; }
-
-    private:
-        HINTERNET handle{nullptr};
-    };
+        return cfg;
+    }
 
-    std::wstring toWide(const std::string& s)
+    Endpoint restEndpointOf(const Config& cfg)
     {
-        if (s.empty())
+        if (!cfg.restEndpoint.empty())
         {
-            return {};
+            return parseEndpoint(cfg.restEndpoint);
         }
-        int len = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
-        std::wstring out(len - 1, L'\0');
-        MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, out.data(), len);
-        return out;
+        return parseEndpoint(cfg.exchange == "mexc" ? "https://api.mexc.com" : "https://api-v2.uzx.com");
     }
 
-    std::optional<std::string> httpGet(const std::string& host,
-                                       const std::string& pathAndQuery,
-                                       bool secure)
+    // --capture / --replay state, set up in main() before any network access.
+    std::unique_ptr<dom::FrameLogWriter> captureLog;
+    bool replaying = false;
+    // Recorded REST bodies by "host/path?query", in the order they were fetched.
+    std::map<std::string, std::deque<std::string>> replayRest;
+    // Recorded time of the record being replayed; the feed's clock during --replay.
+    std::int64_t replayNowUs = 0;
+    // Instrument loads the feed started, run when the capture says they finished.
+    std::map<std::string, std::deque<std::function<void()>>> replayLoads;
+
+    // REST and WebSocket access for live sessions; unset during --replay.
+    std::unique_ptr<dom::Transport> transport;
+
+    // Set once stdin closes: the GUI is gone, or let go of us without a kill.
+    std::atomic<bool> shutdownRequested{false};
+    std::mutex shutdownMutex;
+    std::condition_variable shutdownCv;
+
+    void requestShutdown()
     {
-        WinHttpHandle session(
-            WinHttpOpen(L"ShahTerminal/1.0", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, nullptr, nullptr, 0));
-        if (!session.valid())
         {
-            std::cerr << "[backend] " << winhttpError("WinHttpOpen") << std::endl;
-            return std::nullopt;
+            std::lock_guard<std::mutex> lock(shutdownMutex);
+            shutdownRequested = true;
         }
-
-        WinHttpHandle connection(
-            WinHttpConnect(session.get(), toWide(host).c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0));
-        if (!connection.valid())
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpConnect") << std::endl;
-            return std::nullopt;
-        }
-
-        WinHttpHandle request(WinHttpOpenRequest(connection.get(),
-                                                 L"GET",
-                                                 toWide(pathAndQuery).c_str(),
-                                                 nullptr,
-                                                 WINHTTP_NO_REFERER,
-                                                 WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                                 secure ? WINHTTP_FLAG_SECURE : 0));
-        if (!request.valid())
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpOpenRequest") << std::endl;
-            return std::nullopt;
-        }
-
-        if (!WinHttpSendRequest(request.get(),
-                                WINHTTP_NO_ADDITIONAL_HEADERS,
-                                0,
-                                WINHTTP_NO_REQUEST_DATA,
-                                0,
-                                0,
-                                0))
+        shutdownCv.notify_all();
+        if (transport)
         {
-            std::cerr << "[backend] " << winhttpError("WinHttpSendRequest") << std::endl;
-            return std::nullopt;
-        }
-
-        if (!WinHttpReceiveResponse(request.get(), nullptr))
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpReceiveResponse") << std::endl;
-            return std::nullopt;
+            transport->stop();
         }
+    }
 
-        std::string buffer;
-        for (;;)
+    std::optional<std::string> httpGet(const Endpoint& server, const std::string& pathAndQuery)
+    {
+        const std::string key = server.host + pathAndQuery;
+        if (replaying)
         {
-            DWORD bytesAvailable = 0;
-            if (!WinHttpQueryDataAvailable(request.get(), &bytesAvailable))
+            auto it = replayRest.find(key);
+            if (it == replayRest.end() || it->second.empty())
             {
-                std::cerr << "[backend] " << winhttpError("WinHttpQueryDataAvailable") << std::endl;
+                std::cerr << "[backend] replay: no recorded response for " << key << std::endl;
                 return std::nullopt;
             }
-            if (bytesAvailable == 0)
-            {
-                break;
-            }
-
-            std::string chunk(bytesAvailable, '\0');
-            DWORD bytesRead = 0;
-            if (!WinHttpReadData(request.get(), chunk.data(), bytesAvailable, &bytesRead))
+            std::string body = it->second.front();
+            // The last recorded body keeps answering repeats (e.g. a reloaded symbol).
+            if (it->second.size() > 1)
             {
-                std::cerr << "[backend] " << winhttpError("WinHttpReadData") << std::endl;
-                return std::nullopt;
+                it->second.pop_front();
             }
-            chunk.resize(bytesRead);
-            buffer += chunk;
+            return body;
         }
-
-        return buffer;
+        auto body = transport->httpGet(server, pathAndQuery);
+        if (body && captureLog)
+        {
+            captureLog->append(dom::RecordKind::Rest, dom::wallClockUs(), key, *body);
+        }
+        return body;
     }
 
+    // Tick sizes already fetched by this process, by symbol. "prefetch" commands
+    // fill it ahead of a subscribe, so a new column only waits for the depth snapshot.
+    std::mutex tickSizeMutex;
+    std::map<std::string, double> tickSizeCache;
+
     bool fetchExchangeInfo(const Config& cfg, double& tickSizeOut)
     {
+        {
+            std::lock_guard<std::mutex> lock(tickSizeMutex);
+            const auto cached = tickSizeCache.find(cfg.symbol);
+            if (cached != tickSizeCache.end())
+            {
+                tickSizeOut = cached->second;
+                return true;
+            }
+        }
+
         std::ostringstream path;
         path << "/api/v3/exchangeInfo?symbol=" << cfg.symbol;
 
-        auto body = httpGet("api.mexc.com", path.str(), true);
+        auto body = httpGet(restEndpointOf(cfg), path.str());
         if (!body)
         {
             std::cerr << "[backend] failed to fetch exchangeInfo" << std::endl;
@@ -299,7 +319,13 @@ namespace
         tickSizeOut = std::pow(10.0, -quotePrecision);
         std::cerr << "[backend] exchangeInfo: quotePrecision=" << quotePrecision
                   << " tickSize=" << tickSizeOut << std::endl;
-        return tickSizeOut > 0.0;
+        if (tickSizeOut <= 0.0)
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(tickSizeMutex);
+        tickSizeCache[cfg.symbol] = tickSizeOut;
+        return true;
     }
 
     bool fetchSnapshot(const Config& cfg, dom::OrderBook& book)
@@ -314,7 +340,7 @@ namespace
         std::ostringstream path;
         path << "/api/v3/depth?symbol=" << cfg.symbol << "&limit=" << cfg.snapshotDepth;
 
-        auto body = httpGet("api.mexc.com", path.str(), true);
+        auto body = httpGet(restEndpointOf(cfg), path.str());
         if (!body)
         {
             return false;
@@ -351,597 +377,236 @@ namespace
         parseSide(j["bids"], bids);
         parseSide(j["asks"], asks);
         book.loadSnapshot(bids, asks);
+        book.setVersion(j.value("lastUpdateId", std::uint64_t{0}));
 
-        std::cerr << "[backend] snapshot loaded: bids=" << bids.size() << " asks=" << asks.size() << std::endl;
+        std::cerr << "[backend] snapshot loaded: bids=" << bids.size() << " asks=" << asks.size()
+                  << " lastUpdateId=" << book.version() << std::endl;
         return true;
     }
 
-    // --- минимальный парсер protobuf под нужные сообщения ---
-
-    struct ProtoReader
+    bool loadMexcInstrument(const Config& cfg, dom::OrderBook& book)
     {
-        const std::uint8_t* data{};
-        std::size_t size{};
-        std::size_t pos{};
-
-        ProtoReader() = default;
-        ProtoReader(const void* ptr, std::size_t len)
-            : data(static_cast<const std::uint8_t*>(ptr))
-            , size(len)
-            , pos(0)
+        double tickSize = 0.0;
+        if (!fetchExchangeInfo(cfg, tickSize))
         {
-        }
-
-        bool eof() const { return pos >= size; }
-
-        bool readVarint(std::uint64_t& out)
-        {
-            out = 0;
-            int shift = 0;
-            while (pos < size && shift < 64)
-            {
-                std::uint8_t b = data[pos++];
-                out |= (std::uint64_t(b & 0x7F) << shift);
-                if ((b & 0x80) == 0)
-                {
-                    return true;
-                }
-                shift += 7;
-            }
             return false;
         }
+        book.setTickSize(tickSize);
 
-        bool readBytes(std::size_t n, std::string& out)
+        if (!fetchSnapshot(cfg, book))
         {
-            if (pos + n > size)
-            {
-                return false;
-            }
-            out.assign(reinterpret_cast<const char*>(data + pos), n);
-            pos += n;
-            return true;
+            std::cerr << "[backend] snapshot failed, continuing with empty book" << std::endl;
         }
+        return true;
+    }
 
-        bool readLengthDelimited(std::string& out)
-        {
-            std::uint64_t len = 0;
-            if (!readVarint(len))
+    // Exchange clock minus local clock from /api/v3/time. Of a few round trips the
+    // fastest is kept and its server time is assumed to sit at the midpoint, so the
+    // estimate is good to about half that round trip.
+    std::optional<double> estimateMexcClockOffsetMs(const Endpoint& server)
+    {
+        constexpr int kSamples = 5;
+        std::optional<double> best;
+        std::int64_t bestRttUs = 0;
+        for (int i = 0; i < kSamples; ++i)
+        {
+            const std::int64_t t0 = dom::wallClockUs();
+            auto body = httpGet(server, "/api/v3/time");
+            const std::int64_t t1 = dom::wallClockUs();
+            if (!body)
             {
-                return false;
+                continue;
             }
-            return readBytes(static_cast<std::size_t>(len), out);
-        }
-
-        bool skipField(std::uint64_t key)
-        {
-            const auto wireType = key & 0x7;
-            switch (wireType)
-            {
-            case 0: // varint
+            std::int64_t serverTimeMs = 0;
+            try
             {
-                std::uint64_t dummy;
-                return readVarint(dummy);
+                serverTimeMs = json::parse(*body).value("serverTime", std::int64_t(0));
             }
-            case 1: // 64-bit
-                if (pos + 8 > size) return false;
-                pos += 8;
-                return true;
-            case 2: // length-delimited
+            catch (const std::exception&)
             {
-                std::uint64_t len = 0;
-                if (!readVarint(len) || pos + len > size)
-                {
-                    return false;
-                }
-                pos += static_cast<std::size_t>(len);
-                return true;
-            }
-            case 5: // 32-bit
-                if (pos + 4 > size) return false;
-                pos += 4;
-                return true;
-            default:
-                return false;
             }
-        }
-    };
-
-    void parseDepthItem(const std::string& buf,
-                        double tickSize,
-                        std::vector<std::pair<dom::OrderBook::Tick, double>>& out)
-    {
-        ProtoReader r(buf.data(), buf.size());
-        std::string priceStr;
-        std::string qtyStr;
-        while (!r.eof())
-        {
-            std::uint64_t key = 0;
-            if (!r.readVarint(key)) break;
-            const auto field = key >> 3;
-            if ((key & 0x7) != 2)
+            if (serverTimeMs <= 0)
             {
-                if (!r.skipField(key)) break;
                 continue;
             }
-
-            std::string value;
-            if (!r.readLengthDelimited(value)) break;
-
-            if (field == 1)
+            const std::int64_t rttUs = t1 - t0;
+            if (!best || rttUs < bestRttUs)
             {
-                priceStr = value;
-            }
-            else if (field == 2)
-            {
-                qtyStr = value;
+                bestRttUs = rttUs;
+                best = static_cast<double>(serverTimeMs) - static_cast<double>(t0 + t1) / 2000.0;
             }
         }
-
-        if (!priceStr.empty() && tickSize > 0.0)
+        if (best)
         {
-            double price = std::stod(priceStr);
-            double qty = qtyStr.empty() ? 0.0 : std::stod(qtyStr);
-            auto tick = static_cast<dom::OrderBook::Tick>(std::llround(price / tickSize));
-            out.emplace_back(tick, qty);
+            std::cerr << "[backend] MEXC clock offset " << *best << " ms (rtt " << bestRttUs / 1000 << " ms)"
+                      << std::endl;
         }
+        return best;
     }
 
-    void parseAggreDepth(const std::string& buf,
-                         double tickSize,
-                         std::vector<std::pair<dom::OrderBook::Tick, double>>& asks,
-                         std::vector<std::pair<dom::OrderBook::Tick, double>>& bids)
+    void startClockOffsetTracker(std::shared_ptr<dom::MarketFeed> feed, Endpoint server)
     {
-        ProtoReader r(buf.data(), buf.size());
-        while (!r.eof())
-        {
-            std::uint64_t key = 0;
-            if (!r.readVarint(key)) break;
-            const auto field = key >> 3;
-            if ((key & 0x7) != 2)
+        // Local clocks drift by milliseconds per hour; re-measure now and then.
+        std::thread([feed = std::move(feed), server = std::move(server)]() {
+            for (;;)
             {
-                if (!r.skipField(key)) break;
-                continue;
+                if (const auto offset = estimateMexcClockOffsetMs(server))
+                {
+                    feed->setExchangeClockOffsetMs(*offset);
+                }
+                std::this_thread::sleep_for(std::chrono::minutes(10));
             }
+        }).detach();
+    }
 
-            std::string msg;
-            if (!r.readLengthDelimited(msg)) break;
-
-            if (field == 1) // asks
-            {
-                parseDepthItem(msg, tickSize, asks);
-            }
-            else if (field == 2) // bids
-            {
-                parseDepthItem(msg, tickSize, bids);
-            }
-            // fromVersion / toVersion мы игнорируем
+    Endpoint wsEndpointOf(const Config& cfg)
+    {
+        if (!cfg.endpoint.empty())
+        {
+            return parseEndpoint(cfg.endpoint);
         }
+        return parseEndpoint(cfg.exchange == "mexc" ? "wss://wbs-api.mexc.com/ws" : "wss://stream.uzx.com/notification/ws");
     }
 
-    struct PublicAggreDeal
+    // Reconnect backoff: doubles per failed attempt, and each wait is drawn from the
+    // upper half of the current step so a fleet of backends does not retry in step.
+    constexpr auto kReconnectMin = 250ms;
+    constexpr auto kReconnectMax = 30s;
+    // A connection that lasted this long resets the backoff.
+    constexpr auto kStableConnection = 30s;
+    constexpr auto kHeartbeatInterval = 1s;
+    // No onOpen this long after connect(), or no frame this long on an open socket
+    // (MarketFeed pings MEXC every 10 s, UZX pings us): close it and reconnect.
+    constexpr auto kConnectTimeout = 10s;
+    constexpr auto kStallTimeout = 25s;
+
+    // The socket runFeedSocket() has open, shared with its heartbeat thread.
+    struct FeedSocketState
     {
-        double price{};
-        double quantity{};
-        bool buy{};
-        std::int64_t time{};
+        std::mutex mutex;
+        std::shared_ptr<dom::WebSocket> socket;
+        std::chrono::steady_clock::time_point startedAt{};
+        bool open{false};
     };
 
-    void parseAggreDealItem(const std::string& buf,
-                            std::vector<PublicAggreDeal>& out)
+    void startFeedHeartbeat(dom::MarketFeed& feed, std::shared_ptr<FeedSocketState> state)
     {
-        ProtoReader r(buf.data(), buf.size());
-        std::string priceStr;
-        std::string qtyStr;
-        int tradeType = 0;
-        std::int64_t time = 0;
-
-        while (!r.eof())
-        {
-            std::uint64_t key = 0;
-            if (!r.readVarint(key)) break;
-            const auto field = key >> 3;
-            const auto wire = key & 0x7;
-
-            if (wire == 2)
+        std::thread([&feed, state = std::move(state)]() {
+            for (;;)
             {
-                std::string value;
-                if (!r.readLengthDelimited(value)) break;
-                if (field == 1)
-                {
-                    priceStr = value;
-                }
-                else if (field == 2)
+                std::this_thread::sleep_for(kHeartbeatInterval);
+                feed.heartbeat();
+                if (captureLog)
                 {
-                    qtyStr = value;
+                    captureLog->flushIfDue(dom::wallClockUs());
                 }
-            }
-            else if (wire == 0)
-            {
-                std::uint64_t v = 0;
-                if (!r.readVarint(v)) break;
-                if (field == 3)
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->socket)
                 {
-                    tradeType = static_cast<int>(v);
+                    continue;
                 }
-                else if (field == 4)
+                const bool connectStuck =
+                    !state->open && std::chrono::steady_clock::now() - state->startedAt > kConnectTimeout;
+                if (connectStuck || feed.socketIdle() > kStallTimeout)
                 {
-                    time = static_cast<std::int64_t>(v);
+                    std::cerr << "[backend] ws " << (connectStuck ? "connect timed out" : "stalled")
+                              << ", reconnecting" << std::endl;
+                    state->socket->close();
                 }
             }
-            else
-            {
-                if (!r.skipField(key)) break;
-            }
-        }
-
-        if (!priceStr.empty())
-        {
-            double price = std::stod(priceStr);
-            double qty = qtyStr.empty() ? 0.0 : std::stod(qtyStr);
-            if (qty <= 0.0) return;
-
-            PublicAggreDeal d;
-            d.price = price;
-            d.quantity = qty;
-            d.time = time;
-            // tradeType: 1/2 — точное значение зависит от биржи; считаем 1=buy,2=sell
-            d.buy = (tradeType != 2);
-            out.push_back(d);
-        }
+        }).detach();
     }
 
-    void parseAggreDeals(const std::string& buf,
-                         std::vector<PublicAggreDeal>& out)
+    // Streams the venue socket into the feed. Whenever it closes or fails to open,
+    // the feed keeps its books (marked stale) and the socket is reopened after a
+    // jittered backoff; attachSocket() then resubscribes and reloads them. Returns
+    // once requestShutdown() was called.
+    void runFeedSocket(dom::MarketFeed& feed, const Endpoint& server, const char* venueName)
     {
-        ProtoReader r(buf.data(), buf.size());
-        while (!r.eof())
-        {
-            std::uint64_t key = 0;
-            if (!r.readVarint(key)) break;
-            const auto field = key >> 3;
-            if ((key & 0x7) != 2)
-            {
-                if (!r.skipField(key)) break;
-                continue;
-            }
-
-            std::string msg;
-            if (!r.readLengthDelimited(msg)) break;
-
-            if (field == 1) // repeated deals
-            {
-                parseAggreDealItem(msg, out);
-            }
-            // field 2 = eventType (string) — игнорируем
-        }
-    }
-
-    bool parsePushWrapper(const void* data,
-                          std::size_t len,
-                          std::string& channelOut,
-                          double tickSize,
-                          std::vector<std::pair<dom::OrderBook::Tick, double>>& asks,
-                          std::vector<std::pair<dom::OrderBook::Tick, double>>& bids)
-    {
-        ProtoReader r(data, len);
-        std::string depthBody;
-
-        while (!r.eof())
-        {
-            std::uint64_t key = 0;
-            if (!r.readVarint(key)) break;
-            const auto field = key >> 3;
-
-            if ((key & 0x7) != 2)
-            {
-                if (!r.skipField(key)) break;
-                continue;
-            }
-
-            std::string value;
-            if (!r.readLengthDelimited(value)) break;
-
-            if (field == 1)
-            {
-                channelOut = value;
-            }
-            else if (field == 313)
-            {
-                depthBody = std::move(value);
-            }
-        }
+        auto state = std::make_shared<FeedSocketState>();
+        startFeedHeartbeat(feed, state);
 
-        if (depthBody.empty())
+        std::mt19937 rng(std::random_device{}());
+        std::chrono::milliseconds backoff = kReconnectMin;
+        while (!shutdownRequested)
         {
-            return false;
-        }
-
-        asks.clear();
-        bids.clear();
-        parseAggreDepth(depthBody, tickSize, asks, bids);
-        return true;
-    }
-
-    bool parseDealsFromWrapper(const void* data,
-                               std::size_t len,
-                               std::string& channelOut,
-                               std::vector<PublicAggreDeal>& deals)
-    {
-        ProtoReader r(data, len);
-        std::string dealsBody;
-
-        while (!r.eof())
-        {
-            std::uint64_t key = 0;
-            if (!r.readVarint(key)) break;
-            const auto field = key >> 3;
-
-            if ((key & 0x7) != 2)
+            const auto startedAt = std::chrono::steady_clock::now();
             {
-                if (!r.skipField(key)) break;
-                continue;
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->startedAt = startedAt;
+                state->open = false;
             }
 
-            std::string value;
-            if (!r.readLengthDelimited(value)) break;
-
-            if (field == 1)
-            {
-                channelOut = value;
-            }
-            else if (field == 314)
-            {
-                dealsBody = std::move(value);
-            }
-        }
-
-        if (dealsBody.empty())
-        {
-            return false;
-        }
-
-        deals.clear();
-        parseAggreDeals(dealsBody, deals);
-        return !deals.empty();
-    }
-
-    void emitLadder(const Config& config,
-                    const dom::OrderBook& book,
-                    double bestBid,
-                    double bestAsk,
-                    std::int64_t ts)
-    {
-        auto levels = book.ladder(config.ladderLevelsPerSide);
-        json out;
-        out["type"] = "ladder";
-        out["symbol"] = config.symbol;
-        out["timestamp"] = ts;
-        out["bestBid"] = bestBid;
-        out["bestAsk"] = bestAsk;
-        out["tickSize"] = book.tickSize();
-
-        json rows = json::array();
-        for (const auto& lvl : levels)
-        {
-            rows.push_back({{"price", lvl.price}, {"bid", lvl.bidQuantity}, {"ask", lvl.askQuantity}});
-        }
-        out["rows"] = std::move(rows);
-        std::cout << out.dump() << std::endl;
-    }
-
-    bool runWebSocket(const Config& config, dom::OrderBook& book)
-    {
-        WinHttpHandle session(
-            WinHttpOpen(L"ShahTerminal/1.0", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, nullptr, nullptr, 0));
-        if (!session.valid())
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpOpen") << std::endl;
-            return false;
-        }
-
-        const std::wstring host = L"wbs-api.mexc.com";
-        const std::wstring path = L"/ws";
-
-        WinHttpHandle connection(
-            WinHttpConnect(session.get(), host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0));
-        if (!connection.valid())
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpConnect") << std::endl;
-            return false;
-        }
-
-        WinHttpHandle request(WinHttpOpenRequest(connection.get(),
-                                                 L"GET",
-                                                 path.c_str(),
-                                                 nullptr,
-                                                 WINHTTP_NO_REFERER,
-                                                 WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                                 WINHTTP_FLAG_SECURE));
-        if (!request.valid())
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpOpenRequest") << std::endl;
-            return false;
-        }
-
-        if (!WinHttpSetOption(request.get(), WINHTTP_OPTION_UPGRADE_TO_WEB_SOCKET, nullptr, 0))
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpSetOption") << std::endl;
-            return false;
-        }
-
-        if (!WinHttpSendRequest(request.get(),
-                                WINHTTP_NO_ADDITIONAL_HEADERS,
-                                0,
-                                WINHTTP_NO_REQUEST_DATA,
-                                0,
-                                0,
-                                0))
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpSendRequest") << std::endl;
-            return false;
-        }
-
-        if (!WinHttpReceiveResponse(request.get(), nullptr))
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpReceiveResponse") << std::endl;
-            return false;
-        }
-
-        HINTERNET rawSocket = WinHttpWebSocketCompleteUpgrade(request.get(), 0);
-        if (!rawSocket)
-        {
-            std::cerr << "[backend] " << winhttpError("WinHttpWebSocketCompleteUpgrade") << std::endl;
-            return false;
-        }
-        WinHttpCloseHandle(request.get());
-
-        std::cerr << "[backend] connected to Mexc ws" << std::endl;
-
-        // Подписка на aggre.depth и aggre.deals
-        std::ostringstream depthChannel;
-        depthChannel << "spot@public.aggre.depth.v3.api.pb@100ms@" << config.symbol;
-        // Aggre deals channel also requires an interval suffix (10ms/100ms); without it
-        // the server replies with "Blocked" and sends no trades.
-        std::ostringstream dealsChannel;
-        dealsChannel << "spot@public.aggre.deals.v3.api.pb@100ms@" << config.symbol;
-        json sub = {{"method", "SUBSCRIPTION"},
-                    {"params", json::array({depthChannel.str(), dealsChannel.str()})}};
-        const std::string subStr = sub.dump();
-
-        if (WinHttpWebSocketSend(rawSocket,
-                                 WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
-                                 (void*) subStr.data(),
-                                 static_cast<DWORD>(subStr.size())) != S_OK)
-        {
-            std::cerr << "[backend] failed to send SUBSCRIPTION" << std::endl;
-            WinHttpCloseHandle(rawSocket);
-            return false;
-        }
-
-        std::cerr << "[backend] sent " << subStr << std::endl;
-
-        std::vector<unsigned char> buffer(64 * 1024);
-        auto lastEmit = std::chrono::steady_clock::now();
-
-        for (;;)
-        {
-            DWORD received = 0;
-            WINHTTP_WEB_SOCKET_BUFFER_TYPE type;
-            HRESULT hr =
-                WinHttpWebSocketReceive(rawSocket, buffer.data(), static_cast<DWORD>(buffer.size()), &received, &type);
-            if (FAILED(hr))
-            {
-                std::cerr << "[backend] WebSocket receive failed: " << std::hex << hr << std::dec << std::endl;
-                break;
-            }
+            dom::WebSocketHandler handler;
+            handler.onOpen = [&feed, venueName, state](dom::WebSocket& socket) {
+                std::cerr << "[backend] connected to " << venueName << " ws" << std::endl;
+                feed.attachSocket([&socket](const std::string& text) { return socket.sendText(text); });
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->open = true;
+            };
+            handler.onMessage = [&feed](dom::MessageType type, std::string_view payload, std::int64_t receivedUs) {
+                const bool text = type == dom::MessageType::Text;
+                if (captureLog)
+                {
+                    captureLog->append(text ? dom::RecordKind::Text : dom::RecordKind::Binary, receivedUs, {}, payload);
+                }
+                if (text)
+                {
+                    feed.onTextFrame(payload, receivedUs);
+                }
+                else
+                {
+                    feed.onBinaryFrame(payload.data(), payload.size(), receivedUs);
+                }
+            };
+            handler.onClose = [&feed, venueName](const std::string& reason) {
+                std::cerr << "[backend] " << venueName << " ws: " << reason << std::endl;
+                feed.detachSocket();
+            };
 
-            if (type == WINHTTP_WEB_SOCKET_CLOSE_BUFFER_TYPE)
+            auto socket = transport->connect(server, std::move(handler));
+            bool opened = false;
+            if (socket)
             {
-                std::cerr << "[backend] ws closed by server" << std::endl;
-                break;
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->socket = socket;
+                }
+                transport->run();
+                std::lock_guard<std::mutex> lock(state->mutex);
+                opened = state->open;
+                state->socket.reset();
             }
-
-            if (received == 0)
+            socket.reset();
+            if (shutdownRequested)
             {
-                continue;
+                return;
             }
 
-            if (type == WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE ||
-                type == WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE)
+            if (opened && std::chrono::steady_clock::now() - startedAt >= kStableConnection)
             {
-                std::string text(reinterpret_cast<char*>(buffer.data()), received);
-                // PING / служебные сообщения
-                try
-                {
-                    auto j = json::parse(text);
-                    const auto methodIt = j.find("method");
-                    if (methodIt != j.end() && methodIt->is_string() && *methodIt == "PING")
-                    {
-                        const std::string pong = R"({"method":"PONG"})";
-                        WinHttpWebSocketSend(rawSocket,
-                                             WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
-                                             (void*) pong.data(),
-                                             static_cast<DWORD>(pong.size()));
-                    }
-                    else
-                    {
-                        std::cerr << "[backend] control: " << text << std::endl;
-                    }
-                }
-                catch (...)
-                {
-                    std::cerr << "[backend] text frame: " << text << std::endl;
-                }
-                continue;
+                backoff = kReconnectMin;
             }
-
-            if (type == WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE ||
-                type == WINHTTP_WEB_SOCKET_BINARY_FRAGMENT_BUFFER_TYPE)
+            std::uniform_int_distribution<std::int64_t> jitter(backoff.count() / 2, backoff.count());
+            const std::chrono::milliseconds wait(jitter(rng));
+            std::cerr << "[backend] reconnecting to " << venueName << " in " << wait.count() << " ms" << std::endl;
             {
-                try
-                {
-                    const double tickSize = book.tickSize();
-                    if (tickSize <= 0.0)
-                    {
-                        continue;
-                    }
-
-                    std::string channelName;
-                    std::vector<std::pair<dom::OrderBook::Tick, double>> asks;
-                    std::vector<std::pair<dom::OrderBook::Tick, double>> bids;
-                    std::vector<PublicAggreDeal> deals;
-
-                    // Try trades first
-                    if (parseDealsFromWrapper(buffer.data(), received, channelName, deals))
-                    {
-                        for (const auto& d : deals)
-                        {
-                            json t;
-                            t["type"] = "trade";
-                            t["symbol"] = config.symbol;
-                            t["price"] = d.price;
-                            t["qty"] = d.quantity;
-                            t["side"] = d.buy ? "buy" : "sell";
-                            t["timestamp"] = d.time;
-                            std::cout << t.dump() << std::endl;
-                        }
-                        continue;
-                    }
-
-                    // Depth updates
-                    if (parsePushWrapper(buffer.data(), received, channelName, tickSize, asks, bids))
-                    {
-                        book.applyDelta(bids, asks, config.ladderLevelsPerSide);
-
-                        const auto now = std::chrono::steady_clock::now();
-                        if (now - lastEmit >= config.throttle)
-                        {
-                            lastEmit = now;
-                            const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                                   std::chrono::system_clock::now().time_since_epoch())
-                                                   .count();
-                            emitLadder(config, book, book.bestBid(), book.bestAsk(), nowMs);
-                        }
-                    }
-                }
-                catch (const std::exception& ex)
+                std::unique_lock<std::mutex> lock(shutdownMutex);
+                if (shutdownCv.wait_for(lock, wait, [] { return shutdownRequested.load(); }))
                 {
-                    std::cerr << "[backend] decode/apply error: " << ex.what() << std::endl;
+                    return;
                 }
             }
+            backoff = std::min<std::chrono::milliseconds>(backoff * 2, kReconnectMax);
         }
-
-        WinHttpCloseHandle(rawSocket);
-        return true;
     }
 } // namespace
 
 bool fetchUzxSnapshot(const Config& config, dom::OrderBook& book, double& tickSizeOut, bool isSwap)
 {
-    const std::string host = "api-v2.uzx.com";
     std::ostringstream path;
     path << "/notification/" << (isSwap ? "swap" : "spot") << "/" << config.symbol << "/orderbook";
-    auto body = httpGet(host, path.str(), true);
+    auto body = httpGet(restEndpointOf(config), path.str());
     if (!body)
     {
         std::cerr << "[backend] uzx snapshot failed\n";
@@ -1018,280 +683,365 @@ bool fetchUzxSnapshot(const Config& config, dom::OrderBook& book, double& tickSi
     return true;
 }
 
-bool runUzxWebSocket(const Config& config, dom::OrderBook& book, double tickSize, bool isSwap)
-{
-    const std::wstring host = L"stream.uzx.com";
-    const std::wstring path = L"/notification/ws";
 
-    WinHttpHandle session(
-        WinHttpOpen(L"ShahTerminal/1.0", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, nullptr, nullptr, 0));
-    if (!session.valid())
+
+// Takes in a REST body or the session header (the first Meta record) of a capture;
+// other records are left for dispatchReplayRecord.
+void applyArchiveRecord(const dom::Record& rec, Config& cfg, bool& haveMeta)
+{
+    if (rec.kind == dom::RecordKind::Rest)
     {
-        std::cerr << "[backend] " << winhttpError("WinHttpOpen") << std::endl;
-        return false;
+        replayRest[rec.key].push_back(rec.payload);
     }
-
-    WinHttpHandle connection(
-        WinHttpConnect(session.get(), host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0));
-    if (!connection.valid())
+    else if (rec.kind == dom::RecordKind::Meta && !haveMeta)
     {
-        std::cerr << "[backend] " << winhttpError("WinHttpConnect") << std::endl;
-        return false;
+        const json meta = json::parse(rec.payload);
+        cfg.exchange = meta.value("exchange", cfg.exchange);
+        cfg.symbol = meta.value("symbol", cfg.symbol);
+        cfg.multiplex = meta.value("multiplex", cfg.multiplex);
+        cfg.ladderLevelsPerSide = meta.value("levels", cfg.ladderLevelsPerSide);
+        cfg.compression = meta.value("compression", cfg.compression);
+        cfg.throttle = std::chrono::milliseconds(meta.value("throttleMs", std::int64_t(cfg.throttle.count())));
+        cfg.snapshotDepth = meta.value("snapshotDepth", cfg.snapshotDepth);
+        // REST bodies are keyed by host, so a capture taken against a mock replays as one.
+        cfg.restEndpoint = meta.value("restEndpoint", std::string());
+        replayNowUs = rec.timeUs;
+        haveMeta = true;
     }
+}
 
-    WinHttpHandle request(WinHttpOpenRequest(connection.get(),
-                                             L"GET",
-                                             path.c_str(),
-                                             nullptr,
-                                             WINHTTP_NO_REFERER,
-                                             WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                             WINHTTP_FLAG_SECURE));
-    if (!request.valid())
+// Reads the Meta record and every REST body of a capture up front, so the same
+// instrument loads as in the live run answer from the file.
+void loadReplayArchive(dom::FrameLogReader& log, Config& cfg)
+{
+    dom::Record rec;
+    bool haveMeta = false;
+    while (log.next(rec))
     {
-        std::cerr << "[backend] " << winhttpError("WinHttpOpenRequest") << std::endl;
-        return false;
+        applyArchiveRecord(rec, cfg, haveMeta);
     }
-
-    if (!WinHttpSetOption(request.get(), WINHTTP_OPTION_UPGRADE_TO_WEB_SOCKET, nullptr, 0))
+    if (!haveMeta)
     {
-        std::cerr << "[backend] " << winhttpError("WinHttpSetOption") << std::endl;
-        return false;
+        throw std::runtime_error("capture has no session header");
     }
+    log.rewind();
+}
 
-    if (!WinHttpSendRequest(request.get(),
-                            WINHTTP_NO_ADDITIONAL_HEADERS,
-                            0,
-                            WINHTTP_NO_REQUEST_DATA,
-                            0,
-                            0,
-                            0))
+// Passes one capture record to the feed the way it happened live. True for a
+// WebSocket frame.
+bool dispatchReplayRecord(dom::MarketFeed& feed, const dom::Record& rec, std::int64_t receivedUs)
+{
+    switch (rec.kind)
+    {
+    case dom::RecordKind::Text:
+        feed.onTextFrame(rec.payload, receivedUs);
+        return true;
+    case dom::RecordKind::Binary:
+        feed.onBinaryFrame(rec.payload.data(), rec.payload.size(), receivedUs);
+        return true;
+    case dom::RecordKind::Command:
     {
-        std::cerr << "[backend] " << winhttpError("WinHttpSendRequest") << std::endl;
+        dom::Command cmd;
+        std::string error;
+        if (dom::parseCommand(rec.payload, cmd, error))
+        {
+            feed.handleCommand(cmd);
+        }
         return false;
     }
-
-    if (!WinHttpReceiveResponse(request.get(), nullptr))
+    case dom::RecordKind::Loaded:
     {
-        std::cerr << "[backend] " << winhttpError("WinHttpReceiveResponse") << std::endl;
+        // The live load finished here; frames before this point were dropped
+        // by the feed then and are dropped now.
+        auto it = replayLoads.find(rec.key);
+        if (it != replayLoads.end() && !it->second.empty())
+        {
+            auto load = std::move(it->second.front());
+            it->second.pop_front();
+            load();
+        }
         return false;
     }
-
-    HINTERNET rawSocket = WinHttpWebSocketCompleteUpgrade(request.get(), 0);
-    if (!rawSocket)
-    {
-        std::cerr << "[backend] " << winhttpError("WinHttpWebSocketCompleteUpgrade") << std::endl;
+    default:
+        // Meta and REST bodies were taken in by applyArchiveRecord.
         return false;
     }
-    WinHttpCloseHandle(request.get());
-
-    const std::string channel = isSwap ? "swap.orderBook" : "spot.orderBook";
-    const std::string biz = isSwap ? "swap" : "spot";
-    json sub = {{"event", "sub"},
-                {"params",
-                 {{"biz", biz}, {"type", channel}, {"symbol", config.symbol}, {"interval", "0"}}},
-                {"zip", false}};
-    const std::string subStr = sub.dump();
-    WinHttpWebSocketSend(rawSocket,
-                         WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
-                         (void*) subStr.data(),
-                         static_cast<DWORD>(subStr.size()));
-
-    std::vector<unsigned char> buffer(256 * 1024);
-    auto lastEmit = std::chrono::steady_clock::now();
-
-    auto detectTick = [](std::string_view priceStr) -> double {
-        auto pos = priceStr.find('.');
-        if (pos == std::string_view::npos)
-        {
-            return 1.0;
-        }
-        const int decimals = static_cast<int>(priceStr.size() - pos - 1);
-        if (decimals <= 0 || decimals > 12) return 0.0;
-        return std::pow(10.0, -decimals);
-    };
-
-    auto parseSide = [&](const json& side, double& dynamicTickSize) {
-        std::vector<std::pair<dom::OrderBook::Tick, double>> out;
-        if (!side.is_array()) return out;
-        for (const auto& lvl : side)
-        {
-            if (!lvl.is_array() || lvl.size() < 2) continue;
-            const std::string priceStr = lvl[0].get<std::string>();
-            const std::string qtyStr = lvl[1].get<std::string>();
-            const double price = std::atof(priceStr.c_str());
-            const double qty = std::atof(qtyStr.c_str());
-            if (price <= 0.0 || qty <= 0.0) continue;
-            if (dynamicTickSize <= 0.0)
-            {
-                double detected = detectTick(priceStr);
-                if (detected > 0.0)
-                {
-                    dynamicTickSize = detected;
-                    book.setTickSize(dynamicTickSize);
-                }
-            }
-            if (dynamicTickSize <= 0.0) continue;
-            const auto tick = static_cast<dom::OrderBook::Tick>(std::llround(price / dynamicTickSize));
-            out.emplace_back(tick, qty);
-        }
-        return out;
-    };
+}
 
-    std::string fragmentBuffer;
+// Feeds a capture through the same decode/apply/emit path as the socket loops.
+// The feed runs on the recorded clock, so which ladders go out does not depend
+// on --speed or on how fast this machine is.
+void runReplay(dom::MarketFeed& feed, dom::FrameLogReader& log, double speed)
+{
+    feed.attachSocket([](const std::string&) { return true; });
 
-    for (;;)
+    const auto start = std::chrono::steady_clock::now();
+    std::int64_t firstUs = -1;
+    std::size_t frames = 0;
+    dom::Record rec;
+    while (log.next(rec))
     {
-        DWORD received = 0;
-        WINHTTP_WEB_SOCKET_BUFFER_TYPE type;
-        HRESULT hr =
-            WinHttpWebSocketReceive(rawSocket, buffer.data(), static_cast<DWORD>(buffer.size()), &received, &type);
-        if (FAILED(hr))
+        if (firstUs < 0)
+        {
+            firstUs = rec.timeUs;
+        }
+        if (speed > 0.0)
         {
-            std::cerr << "[backend] UZX ws receive failed: " << std::hex << hr << std::dec << std::endl;
-            break;
+            const auto offset = static_cast<std::int64_t>(static_cast<double>(rec.timeUs - firstUs) / speed);
+            std::this_thread::sleep_until(start + std::chrono::microseconds(offset));
         }
-        if (type == WINHTTP_WEB_SOCKET_CLOSE_BUFFER_TYPE)
+        replayNowUs = rec.timeUs;
+        if (dispatchReplayRecord(feed, rec, dom::wallClockUs()))
         {
-            std::cerr << "[backend] UZX ws closed by server\n";
-            break;
+            ++frames;
         }
-        if (received == 0) continue;
-        if (type != WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE &&
-            type != WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE)
+    }
+    feed.detachSocket();
+
+    const auto elapsedMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "[backend] replay done: " << frames << " frames in " << elapsedMs << " ms" << std::endl;
+}
+
+// --bench: replays `records` as fast as possible on the recorded clock, timing every
+// frame. The feed writes into `sink`; the report goes to stderr and stdout.
+void runBench(dom::MarketFeed& feed, const std::vector<dom::Record>& records, const dom::NullSink& sink)
+{
+    std::size_t frames = 0;
+    for (const auto& rec : records)
+    {
+        frames += rec.kind == dom::RecordKind::Text || rec.kind == dom::RecordKind::Binary ? 1 : 0;
+    }
+    dom::BenchStats stats(frames);
+    std::uint64_t updates = 0;
+
+    feed.attachSocket([](const std::string&) { return true; });
+    feed.setTraceClock(dom::steadyNs);
+    feed.setUpdateObserver([&stats, &updates](const dom::FrameTrace& trace, std::size_t ladders, std::int64_t doneAt) {
+        stats.onUpdate(trace, ladders, doneAt);
+        ++updates;
+    });
+
+    std::cerr << "[backend] bench: " << frames << " frames" << std::endl;
+    const std::uint64_t bytesBefore = sink.bytes();
+    const std::int64_t start = dom::steadyNs();
+    for (const auto& rec : records)
+    {
+        replayNowUs = rec.timeUs;
+        const std::uint64_t allocations = dom::threadAllocations();
+        const std::uint64_t updatesBefore = updates;
+        const std::int64_t frameStart = dom::steadyNs();
+        if (dispatchReplayRecord(feed, rec, frameStart))
         {
-            continue;
+            // Frames that updated a book count as depth, the rest (trades, pings) as deals.
+            const std::int64_t frameNs = dom::steadyNs() - frameStart;
+            stats.onFrame(updates != updatesBefore, frameNs, dom::threadAllocations() - allocations);
         }
+    }
+    const std::int64_t elapsed = dom::steadyNs() - start;
+    feed.setUpdateObserver(nullptr);
+    feed.detachSocket();
 
-        // Accumulate only when the server actually fragments the frame. WinHTTP already
-        // preserves message boundaries, so we only stitch together continuation fragments.
-        const std::string_view chunk(reinterpret_cast<char*>(buffer.data()), received);
-        const bool isFragment = (type == WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE);
-        if (isFragment)
+    stats.report(std::cerr, std::cout, elapsed, sink.bytes() - bytesBefore, feed.symbolCount());
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        Config cfg = parseArgs(argc, argv);
+
+        std::unique_ptr<dom::FrameLogReader> replayLog;
+        std::vector<dom::Record> benchRecords;
+        if (cfg.bench)
         {
-            fragmentBuffer.append(chunk.data(), chunk.size());
-            if (fragmentBuffer.size() > 4 * 1024 * 1024)
+            if (!cfg.capturePath.empty())
+            {
+                throw std::runtime_error("--capture and --bench are mutually exclusive");
+            }
+            if (!cfg.replayPath.empty())
+            {
+                dom::FrameLogReader log(cfg.replayPath);
+                dom::Record rec;
+                while (log.next(rec))
+                {
+                    benchRecords.push_back(std::move(rec));
+                }
+            }
+            else
+            {
+                dom::SyntheticSessionOptions options;
+                options.frames = cfg.benchFrames;
+                options.symbols = cfg.benchSymbols;
+                options.levelsPerSide = cfg.ladderLevelsPerSide;
+                options.compression = cfg.compression;
+                options.snapshotDepth = cfg.snapshotDepth;
+                options.throttleMs = cfg.throttle.count();
+                benchRecords = dom::syntheticMexcSession(options);
+                // The session is a MEXC one against the default REST host.
+                const std::string host = restEndpointOf(Config{}).host;
+                for (auto& rec : benchRecords)
+                {
+                    if (rec.kind == dom::RecordKind::Rest)
+                    {
+                        rec.key = host + rec.key;
+                    }
+                }
+            }
+            bool haveMeta = false;
+            for (const auto& rec : benchRecords)
+            {
+                applyArchiveRecord(rec, cfg, haveMeta);
+            }
+            if (!haveMeta)
             {
-                std::cerr << "[backend] UZX ws fragment buffer too large, dropping\n";
-                fragmentBuffer.clear();
+                throw std::runtime_error("capture has no session header");
             }
-            continue;
+            replaying = true;
         }
-
-        std::string message;
-        if (!fragmentBuffer.empty())
+        else if (!cfg.replayPath.empty())
         {
-            fragmentBuffer.append(chunk.data(), chunk.size());
-            message.swap(fragmentBuffer);
+            if (!cfg.capturePath.empty())
+            {
+                throw std::runtime_error("--capture and --replay are mutually exclusive");
+            }
+            replayLog = std::make_unique<dom::FrameLogReader>(cfg.replayPath);
+            loadReplayArchive(*replayLog, cfg);
+            replaying = true;
         }
-        else
+        else if (!cfg.capturePath.empty())
         {
-            message.assign(chunk);
+            captureLog = std::make_unique<dom::FrameLogWriter>(cfg.capturePath);
+            const json meta = {{"exchange", cfg.exchange},
+                               {"symbol", cfg.symbol},
+                               {"multiplex", cfg.multiplex},
+                               {"levels", cfg.ladderLevelsPerSide},
+                               {"compression", cfg.compression},
+                               {"throttleMs", cfg.throttle.count()},
+                               {"snapshotDepth", cfg.snapshotDepth},
+                               {"restEndpoint", cfg.restEndpoint}};
+            captureLog->append(dom::RecordKind::Meta, dom::wallClockUs(), {}, meta.dump());
+            std::cerr << "[backend] capturing to " << cfg.capturePath << std::endl;
         }
 
-        if (message.empty())
+        if (!replaying)
         {
-            continue;
+            transport = dom::makeTransport();
         }
 
-        auto processJson = [&](const std::string& text) {
-            auto j = json::parse(text);
-            if (j.contains("ping"))
-            {
-                json pong = {{"pong", j["ping"]}};
-                const std::string pongStr = pong.dump();
-                WinHttpWebSocketSend(rawSocket,
-                                     WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
-                                     (void*) pongStr.data(),
-                                     static_cast<DWORD>(pongStr.size()));
-                return;
-            }
-            const auto dataIt = j.find("data");
-            if (dataIt == j.end() || !dataIt->is_object())
+        const bool isMexc = cfg.exchange == "mexc";
+        const bool isSwap = cfg.exchange == "uzxswap";
+
+        // Blocking REST load for one symbol; also used by the feed for later subscriptions.
+        auto loadInstrument = [cfg, isMexc, isSwap](const std::string& symbol, dom::OrderBook& book) {
+            Config next = cfg;
+            next.symbol = symbol;
+            bool ok = false;
+            if (isMexc)
             {
-                return;
+                ok = loadMexcInstrument(next, book);
             }
-            const json& data = *dataIt;
-            const auto bids = parseSide(data["bids"], tickSize);
-            const auto asks = parseSide(data["asks"], tickSize);
-            if (book.tickSize() <= 0.0 && tickSize > 0.0)
+            else
             {
-                book.setTickSize(tickSize);
+                double tickSize = 0.0;
+                ok = fetchUzxSnapshot(next, book, tickSize, isSwap);
             }
-            book.loadSnapshot(bids, asks);
-            const auto now = std::chrono::steady_clock::now();
-            if (now - lastEmit >= config.throttle)
+            if (captureLog)
             {
-                lastEmit = now;
-                const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                       std::chrono::system_clock::now().time_since_epoch())
-                                       .count();
-                emitLadder(config, book, book.bestBid(), book.bestAsk(), nowMs);
+                captureLog->append(dom::RecordKind::Loaded, dom::wallClockUs(), symbol, ok ? "1" : "0");
             }
+            return ok;
         };
 
-        try
-        {
-            processJson(message);
-        }
-        catch (const std::exception& ex)
+        const dom::Venue venue = isMexc ? dom::Venue::Mexc : (isSwap ? dom::Venue::UzxSwap : dom::Venue::UzxSpot);
+        dom::NullSink benchSink;
+        auto feed = std::make_shared<dom::MarketFeed>(
+            venue, cfg.bench ? static_cast<std::ostream&>(benchSink) : std::cout, loadInstrument);
+        feed->setWarmCache(cfg.warmSymbols, cfg.warmCacheMb << 20);
+        if (replaying)
         {
-            std::cerr << "[backend] UZX parse error: " << ex.what() << std::endl;
+            feed->setClock([] { return std::chrono::steady_clock::time_point(std::chrono::microseconds(replayNowUs)); });
+            feed->setLoadSpawner([](const std::string& symbol, std::function<void()> load) {
+                replayLoads[symbol].push_back(std::move(load));
+            });
         }
-    }
-
-    WinHttpCloseHandle(rawSocket);
-    return true;
-}
-
-int main(int argc, char** argv)
-{
-    try
-    {
-        const auto cfg = parseArgs(argc, argv);
-        dom::OrderBook book;
 
-        if (cfg.exchange == "mexc")
+        if (cfg.multiplex)
         {
-            std::cerr << "[backend] starting MEXC WS depth for " << cfg.symbol << std::endl;
-            double tickSize = 0.0;
-            if (!fetchExchangeInfo(cfg, tickSize))
+            std::cerr << "[backend] starting " << cfg.exchange << " multiplexed feed" << std::endl;
+            // UZX has no metadata step: its tick size comes with the snapshot.
+            if (isMexc && !replaying && !cfg.bench)
             {
-                std::cerr << "[backend] failed to determine tick size, exiting" << std::endl;
-                return 1;
+                feed->setPrefetcher([cfg](const std::string& symbol) {
+                    Config next = cfg;
+                    next.symbol = symbol;
+                    double tickSize = 0.0;
+                    fetchExchangeInfo(next, tickSize);
+                });
             }
-            book.setTickSize(tickSize);
-
-            if (!fetchSnapshot(cfg, book))
-            {
-                std::cerr << "[backend] snapshot failed, continuing with empty book" << std::endl;
-            }
-            runWebSocket(cfg, book);
         }
         else
         {
-            const bool isSwap = cfg.exchange == "uzxswap";
-            std::cerr << "[backend] starting UZX " << (isSwap ? "swap" : "spot") << " depth for " << cfg.symbol
-                      << std::endl;
-            double tickSize = 0.0;
-            const bool snapshotOk = fetchUzxSnapshot(cfg, book, tickSize, isSwap);
-            if (!snapshotOk)
+            std::cerr << "[backend] starting " << cfg.exchange << " depth for " << cfg.symbol << std::endl;
+            dom::OrderBook book;
+            if (!loadInstrument(cfg.symbol, book))
             {
+                if (isMexc)
+                {
+                    std::cerr << "[backend] failed to determine tick size, exiting" << std::endl;
+                    return 1;
+                }
+                // UZX pushes full books; the tick size is detected from the first one.
                 std::cerr << "[backend] uzx snapshot failed, continuing" << std::endl;
             }
-            if (tickSize > 0.0)
-            {
-                book.setTickSize(tickSize);
-            }
-            if (snapshotOk && book.tickSize() > 0.0 && book.bestBid() > 0.0 && book.bestAsk() > 0.0)
-            {
-                const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                       std::chrono::system_clock::now().time_since_epoch())
-                                       .count();
-                emitLadder(cfg, book, book.bestBid(), book.bestAsk(), nowMs);
-            }
-            runUzxWebSocket(cfg, book, tickSize > 0.0 ? tickSize : book.tickSize(), isSwap);
+
+            dom::StreamSettings settings;
+            settings.symbol = cfg.symbol;
+            settings.levelsPerSide = cfg.ladderLevelsPerSide;
+            settings.compression = cfg.compression;
+            settings.throttle = cfg.throttle;
+            feed->addStream(0, std::move(settings), std::move(book));
+        }
+
+        if (cfg.bench)
+        {
+            runBench(*feed, benchRecords, benchSink);
+            return 0;
+        }
+        if (replaying)
+        {
+            // Commands come from the capture; stdin is not read.
+            runReplay(*feed, *replayLog, cfg.replaySpeed);
+            return 0;
+        }
+
+        dom::startCommandReader(
+            std::cin,
+            [feed](const dom::Command& cmd) { feed->handleCommand(cmd); },
+            [](std::string_view line) {
+                if (captureLog)
+                {
+                    captureLog->append(dom::RecordKind::Command, dom::wallClockUs(), {}, line);
+                }
+            },
+            [] {
+                std::cerr << "[backend] stdin closed, shutting down" << std::endl;
+                requestShutdown();
+            });
+        if (isMexc)
+        {
+            startClockOffsetTracker(feed, restEndpointOf(cfg));
+        }
+        // Runs until stdin closes (or the GUI kills the process).
+        runFeedSocket(*feed, wsEndpointOf(cfg), isMexc ? "MEXC" : "UZX");
+        if (captureLog)
+        {
+            captureLog->flush();
         }
-        return 0;
+        std::cout.flush();
+        // Detached threads (heartbeat, REST loads) still hold the feed: leave without
+        // running destructors under them.
+        std::_Exit(0);
     }
     catch (const std::exception& ex)
     {
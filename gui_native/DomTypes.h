@@ -2,6 +2,9 @@
 
 #include <QColor>
 #include <QMetaType>
+#include <QtGlobal>
+
+#include <cmath>
 
 struct VolumeHighlightRule {
     double threshold = 0.0; // notional in USDT
@@ -10,3 +13,63 @@ struct VolumeHighlightRule {
 
 Q_DECLARE_METATYPE(VolumeHighlightRule)
 Q_DECLARE_METATYPE(QVector<VolumeHighlightRule>)
+
+// A ladder as integer ticks: row i, counted from the top, holds the `step` ticks
+// starting at tick topTick - i * step (step is the compression factor, and
+// topTick is a multiple of it). Price -> row is one division, exact, no search.
+struct LadderWindow {
+    double tickSize = 0.0;
+    qint64 topTick = 0;
+    int step = 0;
+    int rows = 0;
+
+    bool isValid() const { return tickSize > 0.0 && step > 0 && rows > 0; }
+    qint64 tickForPrice(double price) const { return std::llround(price / tickSize); }
+    double priceForRow(int row) const { return static_cast<double>(topTick - qint64(row) * step) * tickSize; }
+
+    // First tick of the `step`-tick bucket holding `tick`, i.e. the price a row
+    // holding it is labelled with, inside the window or not. Floor division, so
+    // negative ticks bucket the same way.
+    qint64 bucketTick(qint64 tick) const
+    {
+        const qint64 bucket = tick >= 0 ? tick / step : -((-tick + step - 1) / step);
+        return bucket * step;
+    }
+
+    // Row holding `tick`, or -1 outside the window (or without one).
+    int rowForTick(qint64 tick) const
+    {
+        if (!isValid()) {
+            return -1;
+        }
+        const qint64 row = (topTick - bucketTick(tick)) / step;
+        return row >= 0 && row < rows ? static_cast<int>(row) : -1;
+    }
+    int rowForPrice(double price) const { return isValid() ? rowForTick(tickForPrice(price)) : -1; }
+
+    // Window of `rows` rows priced `topPrice` down to `bottomPrice`; invalid
+    // unless those are exactly `step` ticks apart row to row.
+    static LadderWindow fromRange(double topPrice, double bottomPrice, int rows, double tickSize, int step)
+    {
+        LadderWindow window;
+        if (tickSize <= 0.0 || step <= 0 || rows <= 0) {
+            return window;
+        }
+        const qint64 top = std::llround(topPrice / tickSize);
+        const qint64 bottom = std::llround(bottomPrice / tickSize);
+        if (top % step != 0 || top - bottom != qint64(rows - 1) * step) {
+            return window;
+        }
+        window.tickSize = tickSize;
+        window.topTick = top;
+        window.step = step;
+        window.rows = rows;
+        return window;
+    }
+
+    bool operator==(const LadderWindow &o) const
+    {
+        return tickSize == o.tickSize && topTick == o.topTick && step == o.step && rows == o.rows;
+    }
+    bool operator!=(const LadderWindow &o) const { return !(*this == o); }
+};
@@ -1,16 +1,20 @@
 #include "DomWidget.h"
 
-#include <QAbstractScrollArea>
+#include <QCursor>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFont>
 #include <QFontMetrics>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPolygon>
+#include <QResizeEvent>
 #include <QScrollBar>
+#include <QSignalBlocker>
+#include <QTransform>
+#include <QWheelEvent>
 #include <algorithm>
-#include <limits>
 #include <cmath>
 #include <utility>
 
@@ -70,6 +74,35 @@ QString formatQty(double v)
     return QString::number(av, 'f', 1);
 }
 
+// Key of the text formatQty() gives for `v`: the unit it picks and the value
+// rounded to the digits it shows. Equal keys mean equal labels.
+qint64 qtyLabelKey(double v)
+{
+    const double av = std::abs(v);
+    qint64 unit = 0;
+    double shown = av * 10.0;
+    if (av >= 10000000.0) {
+        unit = 5;
+        shown = av / 1000000.0;
+    } else if (av >= 1000000.0) {
+        unit = 4;
+        shown = av / 100000.0;
+    } else if (av >= 10000.0) {
+        unit = 3;
+        shown = av / 1000.0;
+    } else if (av >= 1000.0) {
+        unit = 2;
+        shown = av / 100.0;
+    } else if (av >= 100.0) {
+        unit = 1;
+        shown = av;
+    }
+    return (unit << 56) | static_cast<qint64>(std::llround(std::min(shown, 1.0e15)));
+}
+
+// Cached labels beyond this are dropped wholesale; a ladder shows far fewer.
+constexpr int kMaxCachedLabels = 4096;
+
 QString formatValueShort(double v)
 {
     const double av = std::abs(v);
@@ -112,17 +145,22 @@ bool percentFromReference(double price, double bestBid, double bestAsk, double &
     return false;
 }
 
-double priceTolerance(double tick)
+// Row of the snapshot's best bid/ask, -1 when there is none or it is off the window.
+int bestRow(const DomSnapshot &snapshot, double best)
 {
-    if (tick > 0.0) {
-        return std::max(1e-8, tick * 0.25);
-    }
-    return 1e-8;
+    return best > 0.0 ? snapshot.window.rowForPrice(best) : -1;
+}
+
+const DomSnapshotPtr &emptySnapshot()
+{
+    static const DomSnapshotPtr empty = DomSnapshotPtr::create();
+    return empty;
 }
 } // namespace
 
 DomWidget::DomWidget(QWidget *parent)
     : QWidget(parent)
+    , m_snapshot(emptySnapshot())
 {
     setAutoFillBackground(false);
     setMouseTracking(true);
@@ -133,43 +171,19 @@ DomWidget::DomWidget(QWidget *parent)
     setFont(f);
 }
 
-void DomWidget::updateSnapshot(const DomSnapshot &snapshot)
+void DomWidget::updateSnapshot(const DomSnapshotPtr &snapshot)
 {
-    m_snapshot = snapshot;
-    const int rows = m_snapshot.levels.size();
-    const int rowHeight = m_rowHeight;
-    const int totalHeight = std::max(rows * rowHeight + m_infoAreaHeight, minimumSizeHint().height());
-    setMinimumHeight(totalHeight);
-    setMaximumHeight(totalHeight);
-    updateGeometry();
+    const DomSnapshotPtr previous = std::exchange(m_snapshot, snapshot ? snapshot : emptySnapshot());
+    const int previousTopRow = m_topRow;
+    const int rows = m_snapshot->levels.size();
 
-    if (m_hasInitialCenter && !m_snapshot.levels.isEmpty()) {
-        QWidget *w = parentWidget();
-        QAbstractScrollArea *area = nullptr;
-        while (w && !area) {
-            area = qobject_cast<QAbstractScrollArea *>(w);
-            w = w->parentWidget();
-        }
-        if (area) {
-            QScrollBar *sb = area->verticalScrollBar();
-            if (sb) {
-                int bestRow = 0;
-                double bestDist = std::numeric_limits<double>::max();
-                for (int i = 0; i < m_snapshot.levels.size(); ++i) {
-                    double d = std::abs(m_snapshot.levels[i].price - m_initialCenterPrice);
-                    if (d < bestDist) {
-                        bestDist = d;
-                        bestRow = i;
-                    }
-                }
-                const int centerPixel = bestRow * rowHeight + rowHeight / 2;
-                const int viewportHeight = area->viewport()->height();
-                int value = centerPixel - viewportHeight / 2;
-                value = std::max(sb->minimum(), std::min(sb->maximum(), value));
-                sb->setValue(value);
-            }
-        }
+    bool recentered = false;
+    if (m_hasInitialCenter && !m_snapshot->levels.isEmpty()) {
+        centerOnPrice(m_initialCenterPrice);
         m_hasInitialCenter = false;
+        recentered = true;
+    } else {
+        syncViewport();
     }
 
     if (m_hoverRow >= rows) {
@@ -180,15 +194,93 @@ void DomWidget::updateSnapshot(const DomSnapshot &snapshot)
         updateHoverInfo(m_hoverRow);
     }
 
-    update(); // schedule repaint
+    if (recentered || m_topRow != previousTopRow) {
+        update();
+    } else {
+        // Usually a few levels changed; repaint just those rows.
+        const QRegion dirty = changedRegion(*previous);
+        if (dirty.isEmpty()) {
+            // Nothing visible changed, so no paint will follow; the frame still counts
+            // as shown for the backend's one-in-flight pacing.
+            emit frameRendered(0.0);
+        } else {
+            update(dirty);
+        }
+    }
+}
+
+QRegion DomWidget::changedRegion(const DomSnapshot &previous) const
+{
+    const int rows = m_snapshot->levels.size();
+    if (rows == 0 || previous.window != m_snapshot->window || !m_snapshot->window.isValid()) {
+        return rect(); // the price window moved
+    }
+    const int bidBefore = bestRow(previous, previous.bestBid);
+    const int askBefore = bestRow(previous, previous.bestAsk);
+    const int bidAfter = bestRow(*m_snapshot, m_snapshot->bestBid);
+    const int askAfter = bestRow(*m_snapshot, m_snapshot->bestAsk);
+
+    // Rows down to the bottom edge, including the one partly under the info area.
+    const int lastRow = std::min(rows - 1, m_topRow + height() / m_rowHeight);
+    QRegion dirty;
+    int runStart = -1;
+    for (int i = m_topRow; i <= lastRow + 1; ++i) {
+        bool changed = false;
+        if (i <= lastRow) {
+            const DomLevel &before = previous.levels[i];
+            const DomLevel &after = m_snapshot->levels[i];
+            changed = before.bidQty != after.bidQty || before.askQty != after.askQty ||
+                      (i == bidBefore) != (i == bidAfter) || (i == askBefore) != (i == askAfter);
+        }
+        if (changed && runStart < 0) {
+            runStart = i;
+        } else if (!changed && runStart >= 0) {
+            dirty += QRect(0, (runStart - m_topRow) * m_rowHeight, width(), (i - runStart) * m_rowHeight);
+            runStart = -1;
+        }
+    }
+    if (previous.bestBid != m_snapshot->bestBid || previous.bestAsk != m_snapshot->bestAsk) {
+        // The info line shows unrealized PnL against the best price.
+        dirty += QRect(0, height() - m_infoAreaHeight, width(), m_infoAreaHeight);
+    }
+    return dirty;
 }
 
 void DomWidget::setStyle(const DomStyle &style)
 {
     m_style = style;
+    m_chromeLayer = QPixmap();
     update();
 }
 
+void DomWidget::ensureChromeLayer(int priceLeft)
+{
+    const qreal dpr = devicePixelRatioF();
+    if (!m_chromeLayer.isNull() && m_chromePriceLeft == priceLeft && m_chromeLayer.devicePixelRatio() == dpr) {
+        return;
+    }
+    m_chromeLayer = QPixmap(size() * dpr);
+    m_chromeLayer.setDevicePixelRatio(dpr);
+    m_chromeLayer.fill(m_style.background);
+    m_chromePriceLeft = priceLeft;
+
+    QPainter p(&m_chromeLayer);
+    p.setRenderHint(QPainter::Antialiasing, false);
+    p.setPen(m_style.grid);
+    const int w = width();
+    const int h = height();
+    // Price column borders.
+    if (priceLeft > 0) {
+        p.drawLine(QPoint(priceLeft, 0), QPoint(priceLeft, h));
+    }
+    p.drawLine(QPoint(w - 1, 0), QPoint(w - 1, h));
+    // Row separators at each row top (matches PrintsWidget grid spacing); rows
+    // always start at multiples of the row height, whatever the scroll position.
+    for (int y = 0; y < h; y += m_rowHeight) {
+        p.drawLine(QPoint(0, y), QPoint(w, y));
+    }
+}
+
 void DomWidget::setRowHeight(int h)
 {
     int clamped = std::clamp(h, 10, 40);
@@ -196,11 +288,9 @@ void DomWidget::setRowHeight(int h)
         return;
     }
     m_rowHeight = clamped;
-    if (!m_snapshot.levels.isEmpty()) {
-        updateSnapshot(m_snapshot);
-    } else {
-        update();
-    }
+    m_chromeLayer = QPixmap();
+    syncViewport();
+    update();
 }
 
 void DomWidget::setInitialCenterPrice(double price)
@@ -209,132 +299,205 @@ void DomWidget::setInitialCenterPrice(double price)
     m_hasInitialCenter = true;
 }
 
-void DomWidget::centerToSpread()
+void DomWidget::setScrollBar(QScrollBar *bar)
 {
-    if (m_snapshot.levels.isEmpty()) {
-        return;
+    if (m_scrollBar) {
+        disconnect(m_scrollBar, nullptr, this, nullptr);
     }
-
-    double bestBid = 0.0;
-    double bestAsk = 0.0;
-    bool hasBid = false;
-    bool hasAsk = false;
-
-    for (const auto &lvl : m_snapshot.levels) {
-        if (lvl.bidQty > 0.0) {
-            if (!hasBid || lvl.price > bestBid) {
-                bestBid = lvl.price;
-                hasBid = true;
-            }
-        }
-        if (lvl.askQty > 0.0) {
-            if (!hasAsk || lvl.price < bestAsk) {
-                bestAsk = lvl.price;
-                hasAsk = true;
-            }
-        }
+    m_scrollBar = bar;
+    if (m_scrollBar) {
+        connect(m_scrollBar, &QScrollBar::valueChanged, this, &DomWidget::scrollToRow);
+        connect(m_scrollBar, &QObject::destroyed, this, [this]() { m_scrollBar = nullptr; });
     }
+    syncViewport();
+}
 
-    double centerPrice = 0.0;
-    if (hasBid && hasAsk) {
-        centerPrice = (bestBid + bestAsk) * 0.5;
-    } else if (hasBid) {
-        centerPrice = bestBid;
-    } else if (hasAsk) {
-        centerPrice = bestAsk;
-    } else {
-        return;
+void DomWidget::scrollByRows(int rows)
+{
+    scrollToRow(m_topRow + rows);
+}
+
+void DomWidget::centerToSpread()
+{
+    const double centerPrice = spreadCenterPrice();
+    if (centerPrice > 0.0) {
+        centerOnPrice(centerPrice);
     }
+}
 
-    QWidget *w = parentWidget();
-    QAbstractScrollArea *area = nullptr;
-    while (w && !area) {
-        area = qobject_cast<QAbstractScrollArea *>(w);
-        w = w->parentWidget();
+double DomWidget::spreadCenterPrice() const
+{
+    const double bestBid = m_snapshot->bestBid;
+    const double bestAsk = m_snapshot->bestAsk;
+    if (bestBid > 0.0 && bestAsk > 0.0) {
+        return (bestBid + bestAsk) * 0.5;
     }
-    if (!area) {
-        return;
+    if (bestBid > 0.0) {
+        return bestBid;
     }
+    return bestAsk > 0.0 ? bestAsk : 0.0;
+}
+
+int DomWidget::visibleRowCount() const
+{
+    return std::max(1, (height() - m_infoAreaHeight) / m_rowHeight);
+}
 
-    QScrollBar *sb = area->verticalScrollBar();
-    if (!sb) {
+void DomWidget::centerOnPrice(double price)
+{
+    int row = rowForPrice(price);
+    if (row < 0 && !m_snapshot->window.isValid()) {
+        // Rows are not evenly spaced: take the nearest level by scanning.
+        double bestDistance = 0.0;
+        for (int i = 0; i < m_snapshot->levels.size(); ++i) {
+            const double distance = std::abs(m_snapshot->levels[i].price - price);
+            if (row < 0 || distance < bestDistance) {
+                row = i;
+                bestDistance = distance;
+            }
+        }
+    }
+    if (row < 0) {
         return;
     }
+    scrollToRow(row - visibleRowCount() / 2);
+}
 
-    const int rows = m_snapshot.levels.size();
+void DomWidget::scrollToRow(int row)
+{
+    const int rows = m_snapshot->levels.size();
     if (rows <= 0) {
         return;
     }
+    const int top = std::clamp(row, 0, std::max(0, rows - visibleRowCount()));
+    m_topPrice = m_snapshot->levels[top].price;
+    m_hasTopPrice = true;
+    syncViewport();
+}
 
-    int bestRow = 0;
-    double bestDist = std::numeric_limits<double>::max();
-    for (int i = 0; i < rows; ++i) {
-        double d = std::abs(m_snapshot.levels[i].price - centerPrice);
-        if (d < bestDist) {
-            bestDist = d;
-            bestRow = i;
+void DomWidget::syncViewport()
+{
+    const int rows = m_snapshot->levels.size();
+    const int visible = visibleRowCount();
+    const int maxTop = std::max(0, rows - visible);
+    int top = 0;
+    if (rows > 0) {
+        const int anchorRow = m_hasTopPrice ? rowForPrice(m_topPrice) : -1;
+        if (anchorRow >= 0) {
+            top = std::min(anchorRow, maxTop);
+        } else if (m_hasTopPrice) {
+            // The anchor does not resolve in this frame. Stay on the same row rather
+            // than jump to the spread on every such frame; only the initial frame and
+            // explicit requests (setInitialCenterPrice, centerToSpread) recenter.
+            top = std::clamp(m_topRow, 0, maxTop);
+            if (m_snapshot->window.isValid()) {
+                // The window slid past the anchor: re-anchor on what is shown. An
+                // invalid window keeps the old anchor for when a valid one returns.
+                m_topPrice = m_snapshot->levels[top].price;
+            }
+        } else {
+            // No anchor yet: start from the spread.
+            const double center = spreadCenterPrice();
+            int centerRow = center > 0.0 ? rowForPrice(center) : -1;
+            if (centerRow < 0) {
+                centerRow = rows / 2;
+            }
+            top = std::clamp(centerRow - visible / 2, 0, maxTop);
+            m_topPrice = m_snapshot->levels[top].price;
+            m_hasTopPrice = true;
         }
     }
 
-    const int centerPixel = bestRow * m_rowHeight + m_rowHeight / 2;
-    const int viewportHeight = area->viewport()->height();
-    int value = centerPixel - viewportHeight / 2;
-    value = std::max(sb->minimum(), std::min(sb->maximum(), value));
-    sb->setValue(value);
+    if (m_scrollBar) {
+        const QSignalBlocker blocker(m_scrollBar);
+        m_scrollBar->setRange(0, maxTop);
+        m_scrollBar->setPageStep(visible);
+        m_scrollBar->setSingleStep(1);
+        m_scrollBar->setValue(top);
+    }
+    if (top != m_topRow) {
+        m_topRow = top;
+        if (m_hoverRow >= 0) {
+            // The row under a still cursor changes when the view scrolls.
+            const QPoint pos = mapFromGlobal(QCursor::pos());
+            const int row = rect().contains(pos) && pos.y() < height() - m_infoAreaHeight
+                                ? m_topRow + pos.y() / m_rowHeight
+                                : -1;
+            if (row != m_hoverRow && row < rows) {
+                m_hoverRow = row;
+                updateHoverInfo(row);
+            }
+        }
+        emit viewportChanged(m_topRow);
+        update();
+    }
 }
 
 void DomWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
 
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+
     QPainter p(this);
     p.setRenderHint(QPainter::Antialiasing, false);
 
-    // Background
-    p.fillRect(rect(), m_style.background);
-
-    if (m_snapshot.levels.isEmpty()) {
+    if (m_snapshot->levels.isEmpty()) {
+        p.fillRect(rect(), m_style.background);
+        // Still a shown frame: without the report the backend holds the stream's next
+        // ladders, the ones a (re)loading book is about to send, for its full timeout.
+        emit frameRendered(0.0);
         return;
     }
 
     const int w = width();
     const QRect clipRect = event->rect();
-    const int rows = m_snapshot.levels.size();
+    const int rows = m_snapshot->levels.size();
     if (rows <= 0) {
         return;
     }
 
     const double rowHeight = static_cast<double>(m_rowHeight);
-    const double bestPriceTolerance = priceTolerance(m_snapshot.tickSize);
+    const int bestBidRow = bestRow(*m_snapshot, m_snapshot->bestBid);
+    const int bestAskRow = bestRow(*m_snapshot, m_snapshot->bestAsk);
     QFontMetrics fm(font());
+    QFont boldFont = font();
+    boldFont.setBold(true);
+    QFontMetrics boldFm(boldFont);
 
-    const int firstRow = std::max(0, static_cast<int>(clipRect.top() / rowHeight));
-    const int lastRow = std::min(rows - 1, static_cast<int>(clipRect.bottom() / rowHeight));
+    // Only the rows inside the viewport exist on screen; row i sits at (i - m_topRow) * rowHeight.
+    const int firstRow = std::min(rows - 1, m_topRow + std::max(0, static_cast<int>(clipRect.top() / rowHeight)));
+    const int lastRow = std::min(rows - 1, m_topRow + static_cast<int>(clipRect.bottom() / rowHeight));
 
     // Подбираем ширину колонки по реально отображаемым ценам.
+    // All of the viewport counts, not just the clip, so partial repaints line up.
+    const int lastVisibleRow = std::min(rows - 1, m_topRow + height() / m_rowHeight);
     int maxPriceWidth = 0;
-    for (int i = firstRow; i <= lastRow; ++i) {
-        const QString text = formatPriceForDisplay(m_snapshot.levels[i].price, m_snapshot.tickSize);
-        maxPriceWidth = std::max(maxPriceWidth, fm.horizontalAdvance(text));
+    for (int i = m_topRow; i <= lastVisibleRow; ++i) {
+        maxPriceWidth = std::max(maxPriceWidth, priceLabel(m_snapshot->levels[i].price, fm).width);
     }
     // Резерв под сжатый формат малых цен "(3)12345".
-    const QString tinySample = QStringLiteral("(5)12345");
-    maxPriceWidth = std::max(maxPriceWidth, fm.horizontalAdvance(tinySample));
+    if (m_tinyPriceWidth < 0) {
+        m_tinyPriceWidth = fm.horizontalAdvance(QStringLiteral("(5)12345"));
+    }
+    maxPriceWidth = std::max(maxPriceWidth, m_tinyPriceWidth);
     const int priceColWidth = std::clamp(maxPriceWidth + 8, 52, std::max(60, w / 3));
     const int priceRight = w - 1;
     const int priceLeft = std::max(0, priceRight - priceColWidth);
 
-    // Grid vertical lines for price column borders.
-    p.setPen(m_style.grid);
-    if (priceLeft > 0) {
-        p.drawLine(QPoint(priceLeft, 0), QPoint(priceLeft, height()));
-    }
-    p.drawLine(QPoint(priceRight, 0), QPoint(priceRight, height()));
+    // Background, column borders and row separators come from a cached layer;
+    // everything below only draws liquidity, text and highlights on top of it.
+    ensureChromeLayer(priceLeft);
+    const qreal dpr = m_chromeLayer.devicePixelRatio();
+    p.drawPixmap(QRectF(clipRect),
+                 m_chromeLayer,
+                 QRectF(QPointF(clipRect.topLeft()) * dpr, QSizeF(clipRect.size()) * dpr));
 
     for (int i = firstRow; i <= lastRow; ++i) {
-        const DomLevel &lvl = m_snapshot.levels[i];
+        const DomLevel &lvl = m_snapshot->levels[i];
 
-        const int y = static_cast<int>(i * rowHeight);
+        const int y = static_cast<int>((i - m_topRow) * rowHeight);
         const int rowIntHeight = std::max(1, static_cast<int>(rowHeight));
         const QRect rowRect(0, y, w, rowIntHeight);
         const QRect bookRect(0, y, std::max(0, priceLeft + 1), rowIntHeight);
@@ -345,8 +508,8 @@ void DomWidget::paintEvent(QPaintEvent *event)
         const double askQty = lvl.askQty;
         const bool hasBid = bidQty > 0.0;
         const bool hasAsk = askQty > 0.0;
-        const bool isBestBidRow = m_snapshot.bestBid > 0.0 && std::abs(lvl.price - m_snapshot.bestBid) <= bestPriceTolerance;
-        const bool isBestAskRow = m_snapshot.bestAsk > 0.0 && std::abs(lvl.price - m_snapshot.bestAsk) <= bestPriceTolerance;
+        const bool isBestBidRow = i == bestBidRow;
+        const bool isBestAskRow = i == bestAskRow;
 
         QColor rowColor = m_style.background;
         if (hasBid || hasAsk) {
@@ -375,9 +538,7 @@ void DomWidget::paintEvent(QPaintEvent *event)
         }
         const double notional = dominantQty * std::abs(lvl.price);
         if (notional > 0.0 && bookRect.width() > 8) {
-            const QString qtyText = formatQty(notional);
-            QFont boldFont = p.font();
-            boldFont.setBold(true);
+            const TextLabel &qtyText = qtyLabel(notional, boldFont, boldFm);
             p.setFont(boldFont);
             QColor qtyColor = volumeIsBid ? m_style.bid : m_style.ask;
             qtyColor.setAlpha(220);
@@ -423,21 +584,21 @@ void DomWidget::paintEvent(QPaintEvent *event)
                 p.setPen(qtyColor);
             }
 
-            p.drawText(qtyRect, Qt::AlignLeft | Qt::AlignVCenter, qtyText);
+            if (qtyText.width <= qtyRect.width()) {
+                p.drawStaticText(qtyRect.left(), y + (rowIntHeight - boldFm.height()) / 2, qtyText.text);
+            } else {
+                // Too wide for the column: let drawText clip it as before.
+                p.drawText(qtyRect, Qt::AlignLeft | Qt::AlignVCenter, qtyText.text.text());
+            }
             p.setFont(font());
         }
 
         // Price text with leading-zero compaction.
-        const QString text = formatPriceForDisplay(lvl.price, m_snapshot.tickSize);
+        const TextLabel &priceText = priceLabel(lvl.price, fm);
         p.setPen(m_style.text);
-        int textWidth = fm.horizontalAdvance(text);
-        int textX = priceRight - textWidth - 2;
-        int textY = y + fm.ascent() + (static_cast<int>(rowHeight) - fm.height()) / 2;
-        p.drawText(textX, textY, text);
-
-        // Grid line aligned to row top (matches PrintsWidget grid spacing)
-        p.setPen(m_style.grid);
-        p.drawLine(QPoint(0, y), QPoint(w, y));
+        int textX = priceRight - priceText.width - 2;
+        int textTop = y + (static_cast<int>(rowHeight) - fm.height()) / 2;
+        p.drawStaticText(textX, textTop, priceText.text);
 
         if (i == m_hoverRow) {
             QColor hoverFill(40, 110, 220, 60);
@@ -451,7 +612,7 @@ void DomWidget::paintEvent(QPaintEvent *event)
     const bool hasPosition = m_position.hasPosition && m_position.quantity > 0.0 && m_position.averagePrice > 0.0;
     double bestReferencePrice = 0.0;
     if (hasPosition) {
-        bestReferencePrice = (m_position.side == OrderSide::Buy) ? m_snapshot.bestBid : m_snapshot.bestAsk;
+        bestReferencePrice = (m_position.side == OrderSide::Buy) ? m_snapshot->bestBid : m_snapshot->bestAsk;
     }
     if (hasPosition && bestReferencePrice > 0.0) {
         const int rowIdx = rowForPrice(bestReferencePrice);
@@ -459,7 +620,7 @@ void DomWidget::paintEvent(QPaintEvent *event)
             const double pnl = (m_position.side == OrderSide::Buy)
                                    ? (bestReferencePrice - m_position.averagePrice) * m_position.quantity
                                    : (m_position.averagePrice - bestReferencePrice) * m_position.quantity;
-            const QRect pnlRect(0, rowIdx * m_rowHeight, priceLeft + 1, m_rowHeight);
+            const QRect pnlRect(0, (rowIdx - m_topRow) * m_rowHeight, priceLeft + 1, m_rowHeight);
             QColor pnlColor = pnl >= 0.0 ? QColor("#4caf50") : QColor("#e53935");
             QFont pnlFont = p.font();
             pnlFont.setBold(true);
@@ -520,18 +681,44 @@ void DomWidget::paintEvent(QPaintEvent *event)
     }
     p.setPen(Qt::white);
     p.drawText(infoRect.adjusted(8, 0, -8, 0), Qt::AlignLeft | Qt::AlignVCenter, infoText);
+
+    const qint64 paintNs = paintTimer.nsecsElapsed();
+    qint64 repainted = 0;
+    for (const QRect &r : event->region()) {
+        repainted += static_cast<qint64>(r.width()) * r.height();
+    }
+    const qint64 area = static_cast<qint64>(w) * height();
+    RepaintStats &stats = repainted < area ? m_partialRepaints : m_fullRepaints;
+    stats.paintUs.record(paintNs / 1000);
+    stats.areaShare += area > 0 ? static_cast<double>(repainted) / static_cast<double>(area) : 1.0;
+
+    emit frameRendered(static_cast<double>(paintNs) / 1.0e6);
+}
+
+QString DomWidget::repaintReport() const
+{
+    auto line = [](const char *kind, const RepaintStats &stats) {
+        const quint64 n = stats.paintUs.count();
+        auto ms = [](qint64 us) { return QString::number(static_cast<double>(us) / 1000.0, 'f', 2); };
+        return QStringLiteral("  %1 repaints %2, avg %3% of the widget, paint p50 / p99 / max %4 / %5 / %6 ms")
+            .arg(QString::fromLatin1(kind), -7)
+            .arg(n)
+            .arg(QString::number(n > 0 ? stats.areaShare * 100.0 / static_cast<double>(n) : 0.0, 'f', 1))
+            .arg(ms(stats.paintUs.percentileUs(0.50)), ms(stats.paintUs.percentileUs(0.99)), ms(stats.paintUs.maxUs()));
+    };
+    return line("full", m_fullRepaints) + QLatin1Char('\n') + line("partial", m_partialRepaints);
 }
 
 void DomWidget::mousePressEvent(QMouseEvent *event)
 {
-    if (!m_snapshot.levels.isEmpty()) {
-        const int rows = m_snapshot.levels.size();
+    if (!m_snapshot->levels.isEmpty()) {
+        const int rows = m_snapshot->levels.size();
         const int y = event->pos().y();
-        const int ladderHeight = rows * m_rowHeight;
-        if (y >= 0 && y < ladderHeight) {
-            int row = y / m_rowHeight;
+        const int ladderHeight = std::min(rows - m_topRow, visibleRowCount() + 1) * m_rowHeight;
+        if (y >= 0 && y < ladderHeight && y < height() - m_infoAreaHeight) {
+            int row = m_topRow + y / m_rowHeight;
             row = std::clamp(row, 0, rows - 1);
-            const DomLevel &lvl = m_snapshot.levels[row];
+            const DomLevel &lvl = m_snapshot->levels[row];
             emit rowClicked(event->button(), row, lvl.price, lvl.bidQty, lvl.askQty);
         }
     }
@@ -550,13 +737,13 @@ QSize DomWidget::minimumSizeHint() const
 
 void DomWidget::mouseMoveEvent(QMouseEvent *event)
 {
-    if (!m_snapshot.levels.isEmpty()) {
-        const int rows = m_snapshot.levels.size();
+    if (!m_snapshot->levels.isEmpty()) {
+        const int rows = m_snapshot->levels.size();
         const int y = event->pos().y();
-        const int ladderHeight = rows * m_rowHeight;
+        const int ladderHeight = std::min(rows - m_topRow, visibleRowCount() + 1) * m_rowHeight;
         int row = -1;
-        if (y >= 0 && y < ladderHeight) {
-            row = std::clamp(y / m_rowHeight, 0, rows - 1);
+        if (y >= 0 && y < ladderHeight && y < height() - m_infoAreaHeight) {
+            row = std::clamp(m_topRow + y / m_rowHeight, 0, rows - 1);
         }
 
         if (row != m_hoverRow) {
@@ -564,7 +751,7 @@ void DomWidget::mouseMoveEvent(QMouseEvent *event)
             updateHoverInfo(row);
             update();
             if (row >= 0) {
-                const DomLevel &lvl = m_snapshot.levels[row];
+                const DomLevel &lvl = m_snapshot->levels[row];
                 emit rowHovered(row, lvl.price, lvl.bidQty, lvl.askQty);
             } else {
                 emit rowHovered(-1, 0.0, 0.0, 0.0);
@@ -586,20 +773,105 @@ void DomWidget::leaveEvent(QEvent *event)
     QWidget::leaveEvent(event);
 }
 
+void DomWidget::wheelEvent(QWheelEvent *event)
+{
+    // Three rows per notch, like a scroll area; high-resolution wheels add up.
+    m_wheelRemainder += event->angleDelta().y();
+    const int notches = m_wheelRemainder / 120;
+    m_wheelRemainder -= notches * 120;
+    if (notches != 0) {
+        scrollByRows(-notches * 3);
+    }
+    event->accept();
+}
+
+void DomWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_chromeLayer = QPixmap();
+    // Centering done before the first real layout saw a one-row viewport; redo it.
+    const int rowsShownBefore = (event->oldSize().height() - m_infoAreaHeight) / m_rowHeight;
+    if (rowsShownBefore < 1 && !m_snapshot->levels.isEmpty()) {
+        centerToSpread();
+    }
+    syncViewport();
+}
+
+void DomWidget::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange) {
+        clearLabelCaches();
+    }
+    QWidget::changeEvent(event);
+}
+
+const DomWidget::TextLabel &DomWidget::priceLabel(double price, const QFontMetrics &fm)
+{
+    if (m_snapshot->tickSize != m_labelTickSize) {
+        m_priceLabels.clear();
+        m_labelTickSize = m_snapshot->tickSize;
+    }
+    // Labels follow precisionForTick(tickSize), so one per tick index is enough.
+    const double step = m_labelTickSize > 0.0 ? m_labelTickSize : 1e-5;
+    const qint64 key = static_cast<qint64>(std::llround(price / step));
+    auto it = m_priceLabels.constFind(key);
+    if (it != m_priceLabels.constEnd()) {
+        return it.value();
+    }
+    if (m_priceLabels.size() >= kMaxCachedLabels) {
+        m_priceLabels.clear();
+    }
+    const QString text = formatPriceForDisplay(price, m_snapshot->tickSize);
+    TextLabel label;
+    label.text.setText(text);
+    label.text.setTextFormat(Qt::PlainText);
+    label.text.setPerformanceHint(QStaticText::AggressiveCaching);
+    label.text.prepare(QTransform(), font());
+    label.width = fm.horizontalAdvance(text);
+    return m_priceLabels.insert(key, label).value();
+}
+
+const DomWidget::TextLabel &DomWidget::qtyLabel(double notional, const QFont &boldFont, const QFontMetrics &boldFm)
+{
+    const qint64 key = qtyLabelKey(notional);
+    auto it = m_qtyLabels.constFind(key);
+    if (it != m_qtyLabels.constEnd()) {
+        return it.value();
+    }
+    if (m_qtyLabels.size() >= kMaxCachedLabels) {
+        m_qtyLabels.clear();
+    }
+    const QString text = formatQty(notional);
+    TextLabel label;
+    label.text.setText(text);
+    label.text.setTextFormat(Qt::PlainText);
+    label.text.setPerformanceHint(QStaticText::AggressiveCaching);
+    label.text.prepare(QTransform(), boldFont);
+    label.width = boldFm.horizontalAdvance(text);
+    return m_qtyLabels.insert(key, label).value();
+}
+
+void DomWidget::clearLabelCaches()
+{
+    m_priceLabels.clear();
+    m_qtyLabels.clear();
+    m_tinyPriceWidth = -1;
+}
+
 void DomWidget::updateHoverInfo(int row)
 {
-    if (row < 0 || row >= m_snapshot.levels.size()) {
+    if (row < 0 || row >= m_snapshot->levels.size()) {
         m_hoverInfoText.clear();
         emit hoverInfoChanged(-1, 0.0, QString());
         return;
     }
 
-    const DomLevel &lvl = m_snapshot.levels[row];
+    const DomLevel &lvl = m_snapshot->levels[row];
     const double notional = std::max(lvl.bidQty, lvl.askQty) * std::abs(lvl.price);
     const double cumulative = cumulativeNotionalForRow(row);
     double pct = 0.0;
     QString percentText;
-    if (percentFromReference(lvl.price, m_snapshot.bestBid, m_snapshot.bestAsk, pct)) {
+    if (percentFromReference(lvl.price, m_snapshot->bestBid, m_snapshot->bestAsk, pct)) {
         percentText = QString::number(pct, 'f', std::abs(pct) >= 0.1 ? 2 : 3) + QLatin1String("%");
     } else {
         percentText = QStringLiteral("-");
@@ -618,42 +890,28 @@ void DomWidget::updateHoverInfo(int row)
 
 double DomWidget::cumulativeNotionalForRow(int row) const
 {
-    if (row < 0 || row >= m_snapshot.levels.size()) {
-        return 0.0;
-    }
-    if (m_snapshot.bestBid <= 0.0 && m_snapshot.bestAsk <= 0.0) {
+    if (row < 0 || row >= m_snapshot->levels.size()) {
         return 0.0;
     }
 
-    const DomLevel &target = m_snapshot.levels[row];
-    const double tol = priceTolerance(m_snapshot.tickSize);
-    const double targetPrice = target.price;
+    // Rows run from the highest price down: bids sit at and below the best bid
+    // row, asks at and above the best ask row.
+    const int bidRow = bestRow(*m_snapshot, m_snapshot->bestBid);
+    const int askRow = bestRow(*m_snapshot, m_snapshot->bestAsk);
     double total = 0.0;
 
-    if (m_snapshot.bestBid > 0.0 && targetPrice <= m_snapshot.bestBid + tol) {
-        const double lower = std::min(targetPrice, m_snapshot.bestBid);
-        const double upper = std::max(targetPrice, m_snapshot.bestBid);
-        for (const DomLevel &lvl : m_snapshot.levels) {
-            if (lvl.bidQty <= 0.0) {
-                continue;
-            }
-            if (lvl.price >= lower - tol && lvl.price <= upper + tol) {
-                total += lvl.bidQty * std::abs(lvl.price);
-            }
+    if (bidRow >= 0 && row >= bidRow) {
+        for (int i = bidRow; i <= row; ++i) {
+            const DomLevel &lvl = m_snapshot->levels[i];
+            total += lvl.bidQty * std::abs(lvl.price);
         }
         return total;
     }
 
-    if (m_snapshot.bestAsk > 0.0 && targetPrice >= m_snapshot.bestAsk - tol) {
-        const double lower = std::min(targetPrice, m_snapshot.bestAsk);
-        const double upper = std::max(targetPrice, m_snapshot.bestAsk);
-        for (const DomLevel &lvl : m_snapshot.levels) {
-            if (lvl.askQty <= 0.0) {
-                continue;
-            }
-            if (lvl.price >= lower - tol && lvl.price <= upper + tol) {
-                total += lvl.askQty * std::abs(lvl.price);
-            }
+    if (askRow >= 0 && row <= askRow) {
+        for (int i = row; i <= askRow; ++i) {
+            const DomLevel &lvl = m_snapshot->levels[i];
+            total += lvl.askQty * std::abs(lvl.price);
         }
         return total;
     }
@@ -684,17 +942,5 @@ void DomWidget::setLocalOrders(const QVector<LocalOrderMarker> &orders)
 
 int DomWidget::rowForPrice(double price) const
 {
-    if (m_snapshot.levels.isEmpty()) {
-        return -1;
-    }
-    int closest = 0;
-    double bestDist = std::numeric_limits<double>::max();
-    for (int i = 0; i < m_snapshot.levels.size(); ++i) {
-        const double dist = std::abs(m_snapshot.levels[i].price - price);
-        if (dist < bestDist) {
-            bestDist = dist;
-            closest = i;
-        }
-    }
-    return closest;
+    return m_snapshot->window.rowForPrice(price);
 }
@@ -1,13 +1,23 @@
 #pragma once
 
 #include <QWidget>
+#include <QHash>
+#include <QPixmap>
+#include <QRegion>
+#include <QSharedPointer>
+#include <QStaticText>
 #include <QVector>
 #include <QString>
 #include "DomTypes.h"
+#include "FeedLatency.h"
 #include "TradeTypes.h"
 
 class QMouseEvent;
 class QEvent;
+class QFontMetrics;
+class QResizeEvent;
+class QScrollBar;
+class QWheelEvent;
 
 struct DomLevel {
     double price = 0.0;
@@ -20,8 +30,13 @@ struct DomSnapshot {
     double bestBid = 0.0;
     double bestAsk = 0.0;
     double tickSize = 0.0;
+    LadderWindow window; // levels[i] is window row i; invalid if the rows are not contiguous
 };
 
+// The decoder builds one snapshot per frame and never touches it again; the DOM
+// and the client share it by reference instead of copying the levels.
+using DomSnapshotPtr = QSharedPointer<const DomSnapshot>;
+
 struct DomStyle {
     QColor background = QColor("#202020");
     QColor text = QColor("#f0f0f0");
@@ -45,31 +60,58 @@ public:
 
     explicit DomWidget(QWidget *parent = nullptr);
 
-    void updateSnapshot(const DomSnapshot &snapshot);
+    void updateSnapshot(const DomSnapshotPtr &snapshot);
     void setStyle(const DomStyle &style);
     void setInitialCenterPrice(double price);
     void centerToSpread();
+    // The widget is only as tall as its viewport and scrolls itself: `bar` mirrors
+    // and drives the row at the top. Scrolling keeps that row's price, not a pixel
+    // offset, so new snapshots that shift the window leave the view where it was.
+    void setScrollBar(QScrollBar *bar);
+    void scrollByRows(int rows);
+    int topRow() const { return m_topRow; }
     int rowHeight() const { return m_rowHeight; }
     void setRowHeight(int h);
     void setVolumeHighlightRules(const QVector<VolumeHighlightRule> &rules);
     void setTradePosition(const TradePosition &position);
     void setLocalOrders(const QVector<LocalOrderMarker> &orders);
+    // Paints so far split into full and partial repaints: count, share of the widget
+    // area repainted and paint time. One line per kind, for the latency dump.
+    QString repaintReport() const;
 
 signals:
     void rowClicked(Qt::MouseButton button, int row, double price, double bidQty, double askQty);
     void rowHovered(int row, double price, double bidQty, double askQty);
     void hoverInfoChanged(int row, double price, const QString &text);
+    // Emitted after every paint that drew a ladder; feeds the backend's adaptive throttle.
+    void frameRendered(double paintMs);
+    // The first visible ladder row changed (scroll, zoom, resize or a shifted window).
+    void viewportChanged(int topRow);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void leaveEvent(QEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
     QSize sizeHint() const override;
     QSize minimumSizeHint() const override;
 
 private:
-    DomSnapshot m_snapshot;
+    // Pre-laid-out text plus its advance in the font it was prepared for.
+    struct TextLabel {
+        QStaticText text;
+        int width = 0;
+    };
+
+    struct RepaintStats {
+        LatencyHistogram paintUs;
+        double areaShare = 0.0; // sum over paints of repainted area / widget area
+    };
+
+    DomSnapshotPtr m_snapshot; // never null; an empty snapshot before the first frame
     DomStyle m_style;
     QVector<VolumeHighlightRule> m_volumeRules;
     int m_hoverRow = -1;
@@ -77,11 +119,38 @@ private:
     double m_initialCenterPrice = 0.0;
     bool m_hasInitialCenter = false;
     int m_rowHeight = 12;
+    QScrollBar *m_scrollBar = nullptr;
+    double m_topPrice = 0.0; // price of the top visible row, the scroll anchor
+    bool m_hasTopPrice = false;
+    int m_topRow = 0;        // m_topPrice resolved against the current snapshot
+    int m_wheelRemainder = 0;
     TradePosition m_position;
     int m_infoAreaHeight = 26;
     QVector<LocalOrderMarker> m_localOrders;
+    // Price labels by tick index for m_labelTickSize, volume labels by display
+    // bucket (bold). Both are dropped when the font changes and are bounded.
+    QHash<qint64, TextLabel> m_priceLabels;
+    QHash<qint64, TextLabel> m_qtyLabels;
+    double m_labelTickSize = 0.0;
+    int m_tinyPriceWidth = -1;
+    // Background, price column borders and row separators at the current size,
+    // row height, style and DPR; paintEvent blits it under the ladder. Null when stale.
+    QPixmap m_chromeLayer;
+    int m_chromePriceLeft = -1;
+    RepaintStats m_fullRepaints;
+    RepaintStats m_partialRepaints;
 
+    const TextLabel &priceLabel(double price, const QFontMetrics &fm);
+    const TextLabel &qtyLabel(double notional, const QFont &boldFont, const QFontMetrics &boldFm);
+    void clearLabelCaches();
+    void ensureChromeLayer(int priceLeft);
+    int visibleRowCount() const;
+    double spreadCenterPrice() const;
+    void centerOnPrice(double price);
+    void scrollToRow(int row);
+    void syncViewport();
+    QRegion changedRegion(const DomSnapshot &previous) const;
     void updateHoverInfo(int row);
     double cumulativeNotionalForRow(int row) const;
-    int rowForPrice(double price) const;
+    int rowForPrice(double price) const; // -1 outside the snapshot window
 };
@@ -0,0 +1,139 @@
+#include "FeedLatency.h"
+
+#include <QStringList>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+qint64 wallClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void LatencyHistogram::record(qint64 us)
+{
+    if (us < 0) {
+        ++m_negative;
+        us = 0;
+    }
+    ++m_counts[bucketOf(us)];
+    ++m_count;
+    m_max = std::max(m_max, us);
+}
+
+void LatencyHistogram::clear()
+{
+    m_counts.fill(0);
+    m_count = 0;
+    m_negative = 0;
+    m_max = 0;
+}
+
+qint64 LatencyHistogram::percentileUs(double p) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<quint64>(std::ceil(std::clamp(p, 0.0, 1.0) * static_cast<double>(m_count)));
+    quint64 seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += m_counts[i];
+        if (seen >= std::max<quint64>(1, rank)) {
+            return std::min(bucketUpperUs(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+int LatencyHistogram::bucketOf(qint64 us)
+{
+    if (us < kSubBuckets) {
+        return static_cast<int>(us);
+    }
+    const int octave = 63 - qCountLeadingZeroBits(static_cast<quint64>(us));
+    if (octave >= kOctaves) {
+        return kBuckets - 1;
+    }
+    // The two bits below the leading one pick the quarter of the octave.
+    const int sub = static_cast<int>((us >> (octave - 2)) & (kSubBuckets - 1));
+    return kSubBuckets + (octave - 2) * kSubBuckets + sub;
+}
+
+qint64 LatencyHistogram::bucketUpperUs(int bucket)
+{
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    const int octave = (bucket - kSubBuckets) / kSubBuckets + 2;
+    const int sub = (bucket - kSubBuckets) % kSubBuckets;
+    const qint64 width = qint64(1) << (octave - 2);
+    return (kSubBuckets + sub) * width + width - 1;
+}
+
+void FeedLatency::record(const FeedTrace &trace, qint64 paintedUs)
+{
+    if (trace.receivedUs <= 0) {
+        return;
+    }
+    auto add = [this](Stage stage, qint64 from, qint64 to) {
+        if (from > 0 && to > 0) {
+            m_stages[stage].record(to - from);
+        }
+    };
+    add(Network, trace.exchangeUs, trace.receivedUs);
+    add(Decode, trace.receivedUs, trace.decodedUs);
+    add(Apply, trace.decodedUs, trace.appliedUs);
+    add(Hold, trace.appliedUs, trace.emittedUs);
+    add(Pipe, trace.emittedUs, trace.guiReceivedUs);
+    add(GuiDecode, trace.guiReceivedUs, trace.builtUs);
+    add(Queue, trace.builtUs, trace.takenUs);
+    add(Paint, trace.takenUs, paintedUs);
+    add(Local, trace.receivedUs, paintedUs);
+    add(EndToEnd, trace.exchangeUs, paintedUs);
+}
+
+void FeedLatency::clear()
+{
+    for (auto &stage : m_stages) {
+        stage.clear();
+    }
+}
+
+QString FeedLatency::report() const
+{
+    static const char *const names[StageCount] = {"network",
+                                                  "decode",
+                                                  "apply",
+                                                  "hold",
+                                                  "pipe",
+                                                  "gui decode",
+                                                  "queue",
+                                                  "paint",
+                                                  "local total",
+                                                  "end to end"};
+    auto ms = [](qint64 us) { return QString::number(static_cast<double>(us) / 1000.0, 'f', 2); };
+
+    QStringList lines;
+    lines << QStringLiteral("%1 frames; p50 / p90 / p99 / max, ms").arg(frames());
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram &h = m_stages[i];
+        if (h.count() == 0) {
+            continue;
+        }
+        QString line = QStringLiteral("  %1 %2 / %3 / %4 / %5")
+                           .arg(QString::fromLatin1(names[i]), -12)
+                           .arg(ms(h.percentileUs(0.50)),
+                                ms(h.percentileUs(0.90)),
+                                ms(h.percentileUs(0.99)),
+                                ms(h.maxUs()));
+        if (h.negative() > 0) {
+            line += QStringLiteral("  (%1 negative, clock offset)").arg(h.negative());
+        }
+        lines << line;
+    }
+    return lines.join(QLatin1Char('\n'));
+}
@@ -0,0 +1,78 @@
+// End-to-end feed latency: exchange event -> backend -> pipe -> decoder -> painted DomWidget.
+
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+#include <array>
+
+// Microseconds since the Unix epoch, on the same clock as the backend's trace stamps.
+qint64 wallClockUs();
+
+// Timestamps of one ladder on its way to the screen, wallClockUs() units; 0 when a
+// stage was not stamped. The first five come from the backend's "trace" object.
+struct FeedTrace {
+    qint64 exchangeUs = 0;    // exchange send time, shifted onto the local clock
+    qint64 receivedUs = 0;    // backend socket returned the frame
+    qint64 decodedUs = 0;     // backend decoded it
+    qint64 appliedUs = 0;     // backend applied it to the book
+    qint64 emittedUs = 0;     // backend wrote the ladder line
+    qint64 guiReceivedUs = 0; // LadderBackend read the line from the pipe
+    qint64 builtUs = 0;       // LadderDecoder built the DomSnapshot
+    qint64 takenUs = 0;       // LadderClient handed it to DomWidget
+};
+
+// Log-bucketed histogram of microsecond latencies: four buckets per power of two,
+// so a reported percentile overstates the true value by at most 25% and memory is fixed.
+class LatencyHistogram {
+public:
+    void record(qint64 us);
+    void clear();
+
+    quint64 count() const { return m_count; }
+    qint64 percentileUs(double p) const; // 0 < p <= 1
+    qint64 maxUs() const { return m_max; }
+    quint64 negative() const { return m_negative; }
+
+private:
+    static constexpr int kSubBuckets = 4;
+    static constexpr int kOctaves = 40; // up to ~2^40 us, far beyond any sane latency
+    static constexpr int kBuckets = kSubBuckets + (kOctaves - 2) * kSubBuckets;
+
+    static int bucketOf(qint64 us);
+    static qint64 bucketUpperUs(int bucket);
+
+    std::array<quint64, kBuckets> m_counts{};
+    quint64 m_count = 0;
+    quint64 m_negative = 0; // clamped to 0: exchange clock offset estimate was off
+    qint64 m_max = 0;
+};
+
+// One ladder column's latency, split by pipeline stage.
+class FeedLatency {
+public:
+    enum Stage {
+        Network,    // exchange -> backend socket (includes clock offset error)
+        Decode,     // backend: socket -> decoded
+        Apply,      // backend: decoded -> book updated
+        Hold,       // backend: book updated -> ladder written (throttle, back-pressure)
+        Pipe,       // stdout -> GUI read
+        GuiDecode,  // GUI read -> snapshot built (decoder thread)
+        Queue,      // snapshot built -> taken by the GUI thread
+        Paint,      // taken -> DomWidget paint finished
+        Local,      // backend socket -> painted
+        EndToEnd,   // exchange -> painted
+        StageCount
+    };
+
+    void record(const FeedTrace &trace, qint64 paintedUs);
+    void clear();
+    quint64 frames() const { return m_stages[Local].count(); }
+
+    // Multi-line table of p50/p90/p99/max per stage, in milliseconds.
+    QString report() const;
+
+private:
+    std::array<LatencyHistogram, StageCount> m_stages;
+};
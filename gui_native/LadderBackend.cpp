@@ -0,0 +1,236 @@
+#include "LadderBackend.h"
+#include "LadderDecoder.h"
+
+#include <QDebug>
+#include <QSet>
+#include <QVector>
+#include <QWeakPointer>
+
+namespace {
+QString backendKey(const QString &backendPath, const QString &exchange)
+{
+    return backendPath + QLatin1Char('|') + exchange;
+}
+
+QHash<QString, QWeakPointer<LadderBackend>> &registry()
+{
+    static QHash<QString, QWeakPointer<LadderBackend>> backends;
+    return backends;
+}
+
+// Every LadderBackend alive, released ones awaiting deleteLater() included.
+QSet<LadderBackend *> &instances()
+{
+    static QSet<LadderBackend *> all;
+    return all;
+}
+} // namespace
+
+QSharedPointer<LadderBackend> LadderBackend::acquire(const QString &backendPath, const QString &exchange)
+{
+    // The backend itself defaults to MEXC when --exchange is omitted.
+    const QString normalized = exchange.isEmpty() ? QStringLiteral("mexc") : exchange;
+    const QString key = backendKey(backendPath, normalized);
+    QSharedPointer<LadderBackend> backend = registry().value(key).toStrongRef();
+    if (!backend) {
+        // deleteLater: the last client may let go from inside one of our own line handlers.
+        backend = QSharedPointer<LadderBackend>(new LadderBackend(backendPath, normalized),
+                                                &QObject::deleteLater);
+        registry().insert(key, backend);
+    }
+    return backend;
+}
+
+LadderBackend::LadderBackend(const QString &backendPath, const QString &exchange)
+    : m_backendPath(backendPath)
+    , m_exchange(exchange)
+{
+    instances().insert(this);
+    m_process.setProgram(m_backendPath);
+    m_process.setArguments({QStringLiteral("--exchange"), m_exchange, QStringLiteral("--multiplex")});
+    m_process.setProcessChannelMode(QProcess::SeparateChannels);
+
+    m_decoder = new LadderDecoder();
+    m_decoder->moveToThread(&m_decodeThread);
+    connect(&m_decodeThread, &QThread::finished, m_decoder, &QObject::deleteLater);
+    connect(m_decoder, &LadderDecoder::frameReady, this, [this](int streamId) {
+        // Queued from the decoder thread; the stream may be gone by now.
+        const auto it = m_streams.constFind(streamId);
+        if (it != m_streams.constEnd() && it->frameReady) {
+            const auto frameReady = it->frameReady;
+            frameReady();
+        }
+    });
+    m_decodeThread.setObjectName(QStringLiteral("LadderDecoder %1").arg(exchange));
+    m_decodeThread.start();
+
+    connect(&m_process, &QProcess::readyReadStandardOutput, this, &LadderBackend::handleReadyRead);
+    connect(&m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        qWarning() << "[LadderBackend]" << m_exchange << "error" << error << m_process.errorString();
+        emit errorOccurred(error);
+    });
+    connect(&m_process,
+            QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this,
+            [this](int exitCode, QProcess::ExitStatus status) {
+                qWarning() << "[LadderBackend]" << m_exchange << "finished" << exitCode << status;
+                emit finished(exitCode, status);
+            });
+}
+
+LadderBackend::~LadderBackend()
+{
+    instances().remove(this);
+    const QString key = backendKey(m_backendPath, m_exchange);
+    if (registry().value(key).isNull()) {
+        registry().remove(key);
+    }
+    if (m_process.state() != QProcess::NotRunning) {
+        m_process.kill();
+        m_process.waitForFinished(2000);
+    }
+    m_decodeThread.quit();
+    m_decodeThread.wait();
+}
+
+void LadderBackend::shutdownAll()
+{
+    const QSet<LadderBackend *> all = instances();
+    for (LadderBackend *backend : all) {
+        backend->shutdown();
+    }
+}
+
+void LadderBackend::shutdown()
+{
+    if (m_process.state() == QProcess::NotRunning) {
+        return;
+    }
+    // Nobody is left to show a "finished" status.
+    m_process.blockSignals(true);
+    m_process.closeWriteChannel();
+    if (!m_process.waitForFinished(1000)) {
+        m_process.kill();
+        m_process.waitForFinished(2000);
+    }
+}
+
+int LadderBackend::addStream(StreamSink sink)
+{
+    const int id = m_nextStreamId++;
+    m_streams.insert(id, std::move(sink));
+    return id;
+}
+
+void LadderBackend::removeStream(int streamId)
+{
+    if (m_streams.remove(streamId) == 0) {
+        return;
+    }
+    m_decoder->removeStream(streamId);
+    send(QByteArrayLiteral(R"({"cmd":"unsubscribe","stream":)") + QByteArray::number(streamId) + '}');
+}
+
+void LadderBackend::ensureRunning()
+{
+    if (m_process.state() != QProcess::NotRunning) {
+        return;
+    }
+    m_buffer.clear();
+    m_sinceOutput.start();
+    m_process.start();
+    // Writes are buffered by QProcess until the process is up, so clients can
+    // subscribe right away.
+    emit restarted();
+}
+
+bool LadderBackend::isRunning() const
+{
+    return m_process.state() != QProcess::NotRunning;
+}
+
+qint64 LadderBackend::msSinceOutput() const
+{
+    return m_sinceOutput.isValid() ? m_sinceOutput.elapsed() : 0;
+}
+
+void LadderBackend::restartProcess()
+{
+    qWarning() << "[LadderBackend]" << m_exchange << "silent for" << msSinceOutput() << "ms, restarting";
+    if (m_process.state() != QProcess::NotRunning) {
+        m_process.kill();
+        m_process.waitForFinished(2000);
+    }
+    ensureRunning();
+}
+
+bool LadderBackend::send(const QByteArray &line)
+{
+    if (m_process.state() == QProcess::NotRunning) {
+        return false;
+    }
+    return m_process.write(line + '\n') == line.size() + 1;
+}
+
+void LadderBackend::prefetch(const QStringList &wireSymbols)
+{
+    ensureRunning();
+    for (const QString &symbol : wireSymbols) {
+        send(QByteArrayLiteral(R"({"cmd":"prefetch","symbol":")") + symbol.toUtf8() + QByteArrayLiteral("\"}"));
+    }
+}
+
+void LadderBackend::handleReadyRead()
+{
+    m_buffer += m_process.readAllStandardOutput();
+    m_sinceOutput.start();
+    const qint64 receivedUs = wallClockUs();
+    QVector<QByteArray> lines;
+    int idx = -1;
+    while ((idx = m_buffer.indexOf('\n')) != -1) {
+        QByteArray line = m_buffer.left(idx);
+        m_buffer.remove(0, idx + 1);
+        if (!line.trimmed().isEmpty()) {
+            lines.push_back(line);
+        }
+    }
+
+    // When the GUI thread falls behind, several ladders for one stream pile up in a
+    // single read. Each is a full snapshot, so only the newest is worth decoding;
+    // trades and acks are always delivered, in order.
+    static const QByteArray ladderTag = QByteArrayLiteral("\"type\":\"ladder\"");
+    static const QByteArray tradeTag = QByteArrayLiteral("\"type\":\"trade\"");
+    QHash<int, int> newestLadder;
+    for (int i = 0; i < lines.size(); ++i) {
+        if (lines[i].contains(ladderTag)) {
+            newestLadder.insert(ladderStreamId(lines[i]), i);
+        }
+    }
+
+    QVector<QByteArray> market;
+    market.reserve(lines.size());
+    for (int i = 0; i < lines.size(); ++i) {
+        const QByteArray &line = lines[i];
+        if (line.contains(ladderTag)) {
+            if (newestLadder.value(ladderStreamId(line)) == i) {
+                market.push_back(line);
+            }
+        } else if (line.contains(tradeTag)) {
+            market.push_back(line);
+        } else {
+            const auto it = m_streams.constFind(ladderStreamId(line));
+            if (it != m_streams.constEnd() && it->control) {
+                // Copy: the handler may remove its own stream while running.
+                const auto control = it->control;
+                control(line);
+            }
+        }
+    }
+    if (!market.isEmpty()) {
+        LadderDecoder *decoder = m_decoder;
+        QMetaObject::invokeMethod(
+            decoder,
+            [decoder, market, receivedUs]() { decoder->decodeLines(market, receivedUs); },
+            Qt::QueuedConnection);
+    }
+}
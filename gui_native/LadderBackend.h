@@ -0,0 +1,88 @@
+// One orderbook_backend process per exchange, shared by every ladder column on it.
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include <functional>
+
+class LadderDecoder;
+
+// The process runs with --multiplex and holds one WebSocket; each LadderClient
+// owns a stream id on it and receives only the lines tagged with that id.
+// Ladder and trade lines are decoded on a per-process worker thread
+// (LadderDecoder); the client is told when a frame is ready to take.
+class LadderBackend : public QObject {
+    Q_OBJECT
+
+public:
+    struct StreamSink {
+        std::function<void(const QByteArray &line)> control; // acks, on the GUI thread
+        std::function<void()> frameReady;                    // decoder() has a frame
+    };
+
+    // Returns the running backend for (backendPath, exchange), creating it on first use.
+    // The process lives as long as at least one client holds the pointer.
+    static QSharedPointer<LadderBackend> acquire(const QString &backendPath, const QString &exchange);
+
+    ~LadderBackend() override;
+
+    // Ends every backend process still alive, including ones whose last client let
+    // go but whose deleteLater() will never run because the event loop has exited.
+    // Call before the application returns from main().
+    static void shutdownAll();
+
+    int addStream(StreamSink sink);
+    void removeStream(int streamId);
+    LadderDecoder &decoder() { return *m_decoder; }
+
+    // Starts the process if it is not running. A fresh process knows no streams,
+    // so restarted() asks every client to subscribe again.
+    void ensureRunning();
+    bool isRunning() const;
+    // Time since the process last wrote anything. A healthy backend sends every
+    // stream a heartbeat once a second, reconnecting or not.
+    qint64 msSinceOutput() const;
+    // Kills a process that stopped writing and starts a fresh one; restarted()
+    // then resubscribes every client.
+    void restartProcess();
+    bool send(const QByteArray &line);
+    // Starts the process if needed and has it fetch the instrument metadata of
+    // `wireSymbols` now, so subscribing one later only waits for its book.
+    void prefetch(const QStringList &wireSymbols);
+
+    QString exchange() const { return m_exchange; }
+    QString errorString() const { return m_process.errorString(); }
+
+signals:
+    void restarted();
+    void errorOccurred(QProcess::ProcessError error);
+    void finished(int exitCode, QProcess::ExitStatus status);
+
+private:
+    LadderBackend(const QString &backendPath, const QString &exchange);
+
+    // Closes stdin, which the backend takes as a shutdown request; kills it if it
+    // has not exited shortly after.
+    void shutdown();
+
+    void handleReadyRead();
+
+    QString m_backendPath;
+    QString m_exchange;
+    QProcess m_process;
+    QByteArray m_buffer;
+    QElapsedTimer m_sinceOutput;
+    QHash<int, StreamSink> m_streams;
+    int m_nextStreamId = 1;
+    QThread m_decodeThread;
+    LadderDecoder *m_decoder = nullptr;
+};
@@ -1,81 +1,22 @@
 #include "LadderClient.h"
+#include "LadderDecoder.h"
 #include "PrintsWidget.h"
 
 #include <QDateTime>
 #include <QDebug>
+#include <QEvent>
 
 #include <json.hpp>
-#include <cmath>
-#include <cstdint>
-#include <limits>
-#include <map>
+#include <algorithm>
 
 using json = nlohmann::json;
 
-LadderClient::LadderClient(const QString &backendPath,
-                           const QString &symbol,
-                           int levels,
-                           const QString &exchange,
-                           DomWidget *dom,
-                           QObject *parent,
-                           PrintsWidget *prints)
-    : QObject(parent)
-    , m_backendPath(backendPath)
-    , m_symbol(symbol)
-    , m_levels(levels)
-    , m_exchange(exchange)
-    , m_dom(dom)
-    , m_initialCenterSent(false)
-    , m_prints(prints)
+namespace {
+// Map UI symbol to exchange-specific wire format.
+QString wireSymbolFor(const QString &symbol, const QString &exchange)
 {
-    m_process.setProgram(m_backendPath);
-    m_process.setProcessChannelMode(QProcess::SeparateChannels);
-
-    connect(&m_process, &QProcess::readyReadStandardOutput, this, &LadderClient::handleReadyRead);
-    connect(&m_process,
-            &QProcess::errorOccurred,
-            this,
-            &LadderClient::handleErrorOccurred);
-    connect(&m_process,
-            QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this,
-            &LadderClient::handleFinished);
-
-    m_watchdogTimer.setSingleShot(true);
-    connect(&m_watchdogTimer, &QTimer::timeout, this, &LadderClient::handleWatchdogTimeout);
-
-    restart(m_symbol, m_levels, m_exchange);
-}
-
-void LadderClient::restart(const QString &symbol, int levels, const QString &exchange)
-{
-    m_symbol = symbol;
-    m_levels = levels;
-    if (!exchange.isEmpty()) {
-        m_exchange = exchange;
-    }
-    m_initialCenterSent = false;
-    m_lastTickSize = 0.0;
-    m_printBuffer.clear();
-    if (m_prints) {
-        QVector<PrintItem> emptyPrints;
-        m_prints->setPrints(emptyPrints);
-        QVector<double> emptyPrices;
-        const int rowH = m_dom ? m_dom->rowHeight() : 20;
-        m_prints->setLadderPrices(emptyPrices, rowH, 0.0);
-        QVector<LocalOrderMarker> emptyOrders;
-        m_prints->setLocalOrders(emptyOrders);
-    }
-
-    if (m_process.state() != QProcess::NotRunning) {
-        m_process.kill();
-        m_process.waitForFinished(2000);
-    }
-    m_lastPrices.clear();
-
-    // Map UI symbol to exchange-specific wire format.
-    QString wireSymbol = m_symbol;
-    if (m_exchange == QStringLiteral("uzxspot"))
+    QString wireSymbol = symbol;
+    if (exchange == QStringLiteral("uzxspot"))
     {
         if (!wireSymbol.contains(QLatin1Char('-')))
         {
@@ -101,28 +42,128 @@ void LadderClient::restart(const QString &symbol, int levels, const QString &exc
             }
         }
     }
-    else if (m_exchange == QStringLiteral("uzxswap"))
+    else if (exchange == QStringLiteral("uzxswap"))
     {
         wireSymbol = wireSymbol.replace(QStringLiteral("-"), QString());
     }
+    return wireSymbol;
+}
+
+QByteArray commandLine(int stream, const char *cmd, const char *key = nullptr, int value = 0)
+{
+    json j;
+    j["cmd"] = cmd;
+    j["stream"] = stream;
+    if (key) {
+        j[key] = value;
+    }
+    return QByteArray::fromStdString(j.dump());
+}
+} // namespace
+
+LadderClient::LadderClient(const QString &backendPath,
+                           const QString &symbol,
+                           int levels,
+                           const QString &exchange,
+                           DomWidget *dom,
+                           QObject *parent,
+                           PrintsWidget *prints)
+    : QObject(parent)
+    , m_backendPath(backendPath)
+    , m_symbol(symbol)
+    , m_levels(levels)
+    , m_exchange(exchange)
+    , m_dom(dom)
+    , m_initialCenterSent(false)
+    , m_prints(prints)
+{
+    m_watchdogTimer.setSingleShot(true);
+    connect(&m_watchdogTimer, &QTimer::timeout, this, &LadderClient::handleWatchdogTimeout);
+
+    if (m_dom) {
+        connect(m_dom, &DomWidget::frameRendered, this, &LadderClient::handleFrameRendered);
+        m_dom->installEventFilter(this);
+        // Columns restored onto a background tab are never shown, so they must
+        // start hidden; the Show event of the current tab's columns resumes them.
+        m_domVisible = m_dom->isVisible();
+    }
 
-    QStringList args;
-    args << "--symbol" << wireSymbol << "--ladder-levels" << QString::number(m_levels);
-    if (!m_exchange.isEmpty()) {
-        args << "--exchange" << m_exchange;
+    restart(m_symbol, m_levels, m_exchange);
+}
+
+LadderClient::~LadderClient()
+{
+    if (m_scheduler) {
+        m_scheduler->removeColumn(m_renderId);
     }
-    m_process.setArguments(args);
+    detachBackend();
+}
 
+QSharedPointer<LadderBackend> LadderClient::prewarm(const QString &backendPath,
+                                                   const QString &exchange,
+                                                   const QStringList &symbols)
+{
+    QSharedPointer<LadderBackend> backend = LadderBackend::acquire(backendPath, exchange);
+    QStringList wireSymbols;
+    for (const QString &symbol : symbols) {
+        const QString wire = wireSymbolFor(symbol.trimmed().toUpper(), backend->exchange());
+        if (!wire.isEmpty() && !wireSymbols.contains(wire)) {
+            wireSymbols.push_back(wire);
+        }
+    }
+    backend->prefetch(wireSymbols);
+    return backend;
+}
+
+void LadderClient::setRenderScheduler(RenderScheduler *scheduler, QWidget *column)
+{
+    if (m_scheduler) {
+        m_scheduler->removeColumn(m_renderId);
+        m_renderId = 0;
+    }
+    m_scheduler = scheduler;
+    if (m_prints) {
+        m_prints->setFramePaced(m_scheduler != nullptr);
+    }
+    if (!m_scheduler) {
+        return;
+    }
+    std::function<bool()> animate;
+    if (PrintsWidget *prints = m_prints) {
+        animate = [prints]() { return prints->advanceAnimation(); };
+    }
+    m_renderId = m_scheduler->addColumn(column, [this]() { applyPendingFrame(); }, std::move(animate));
+}
+
+void LadderClient::restart(const QString &symbol, int levels, const QString &exchange)
+{
+    m_symbol = symbol;
+    m_levels = levels;
+    if (!exchange.isEmpty() && exchange != m_exchange) {
+        detachBackend();
+        m_exchange = exchange;
+    }
+    m_wireSymbol = wireSymbolFor(m_symbol, m_exchange);
     emitStatus(QStringLiteral("Starting backend (%1, %2 levels)...").arg(m_symbol).arg(m_levels));
-    m_process.start();
+
+    if (!m_backend) {
+        attachBackend();
+    }
+    resetViewState();
+    if (m_backend->isRunning()) {
+        // A stuck book would come back from the warm cache as it is; load it afresh.
+        subscribe(m_subscribed);
+    } else {
+        // restarted() subscribes every stream on the fresh process, ours included.
+        m_backend->ensureRunning();
+    }
     armWatchdog();
 }
 
 void LadderClient::stop()
 {
-    if (m_process.state() != QProcess::NotRunning) {
-        m_process.kill();
-        m_process.waitForFinished(2000);
+    if (m_backend) {
+        detachBackend();
         emitStatus(QStringLiteral("Backend stopped"));
     }
     m_watchdogTimer.stop();
@@ -130,42 +171,217 @@ void LadderClient::stop()
 
 bool LadderClient::isRunning() const
 {
-    return m_process.state() != QProcess::NotRunning;
+    return m_backend && m_backend->isRunning();
 }
 
-void LadderClient::setCompression(int factor)
+void LadderClient::attachBackend()
 {
-    m_tickCompression = std::max(1, factor);
+    m_backend = LadderBackend::acquire(m_backendPath, m_exchange);
+    LadderBackend::StreamSink sink;
+    sink.control = [this](const QByteArray &line) { processControlLine(line); };
+    sink.frameReady = [this]() {
+        if (m_scheduler) {
+            m_scheduler->requestFrame(m_renderId);
+        } else {
+            applyPendingFrame();
+        }
+    };
+    m_streamId = m_backend->addStream(std::move(sink));
+    connect(m_backend.data(), &LadderBackend::restarted, this, &LadderClient::subscribe);
+    connect(m_backend.data(), &LadderBackend::errorOccurred, this, &LadderClient::handleErrorOccurred);
+    connect(m_backend.data(), &LadderBackend::finished, this, &LadderClient::handleFinished);
+}
+
+void LadderClient::detachBackend()
+{
+    if (!m_backend) {
+        return;
+    }
+    disconnect(m_backend.data(), nullptr, this, nullptr);
+    m_backend->removeStream(m_streamId);
+    m_backend.reset();
+    m_streamId = 0;
+    m_subscribed = false;
+}
+
+void LadderClient::subscribe(bool reload)
+{
+    json cmd;
+    cmd["cmd"] = "subscribe";
+    cmd["stream"] = m_streamId;
+    cmd["symbol"] = m_wireSymbol.toStdString();
+    cmd["levels"] = m_levels;
+    cmd["compression"] = m_tickCompression;
+    if (reload) {
+        cmd["reload"] = true;
+    }
+    m_subscribed = sendCommand(QByteArray::fromStdString(cmd.dump()));
+    if (!m_domVisible) {
+        sendConsumerReport(0.0);
+    }
+    // Also runs for restarted(), after finished() stopped the watchdog.
+    armWatchdog();
 }
 
-void LadderClient::handleReadyRead()
+bool LadderClient::eventFilter(QObject *watched, QEvent *event)
 {
-    emitStatus("Receiving data...");
-    m_buffer += m_process.readAllStandardOutput();
-    int idx = -1;
-    while ((idx = m_buffer.indexOf('\n')) != -1) {
-        QByteArray line = m_buffer.left(idx);
-        m_buffer.remove(0, idx + 1);
-        if (!line.trimmed().isEmpty()) {
-            processLine(line);
+    if (watched == m_dom && (event->type() == QEvent::Show || event->type() == QEvent::Hide)) {
+        const bool visible = event->type() == QEvent::Show;
+        if (visible != m_domVisible) {
+            m_domVisible = visible;
+            // A hidden column paints nothing; its time off screen is not latency.
+            m_tracePending = false;
+            if (m_backend) {
+                m_backend->decoder().setPaused(m_streamId, !visible);
+            }
+            // Becoming visible makes the backend send a full ladder at once.
+            sendConsumerReport(0.0);
         }
     }
+    return QObject::eventFilter(watched, event);
+}
+
+void LadderClient::handleFrameRendered(double paintMs)
+{
+    if (m_scheduler) {
+        m_scheduler->recordPaint(m_renderId, paintMs);
+    }
+    if (m_tracePending) {
+        m_latency.record(m_paintTrace, wallClockUs());
+        m_tracePending = false;
+    }
+    // Hover and resize repaints carry no new frame; only report fresh ladders.
+    if (m_lastSeq == m_reportedSeq) {
+        return;
+    }
+    sendConsumerReport(paintMs);
+}
+
+void LadderClient::sendConsumerReport(double paintMs)
+{
+    m_reportedSeq = m_lastSeq;
+    json report;
+    report["cmd"] = "consumer-report";
+    report["stream"] = m_streamId;
+    report["seq"] = m_lastSeq;
+    report["paintMs"] = paintMs;
+    report["visible"] = m_domVisible;
+    sendCommand(QByteArray::fromStdString(report.dump()));
+}
+
+void LadderClient::setCompression(int factor)
+{
+    const int clamped = std::max(1, factor);
+    if (clamped == m_tickCompression) {
+        return;
+    }
+    m_tickCompression = clamped;
+    if (m_backend) {
+        m_backend->decoder().setCompression(m_streamId, clamped);
+    }
+    sendCommand(commandLine(m_streamId, "set-compression", "factor", clamped));
+}
+
+void LadderClient::setLevels(int levels)
+{
+    if (levels == m_levels) {
+        return;
+    }
+    if (!isRunning()) {
+        restart(m_symbol, levels);
+        return;
+    }
+    m_levels = levels;
+    // The window changes size, so recentre on the next frame like a restart would.
+    m_initialCenterSent = false;
+    sendCommand(commandLine(m_streamId, "set-levels", "levels", levels));
+    emitStatus(QStringLiteral("Switching to %1 levels...").arg(levels));
+}
+
+void LadderClient::setThrottle(int milliseconds)
+{
+    sendCommand(commandLine(m_streamId, "set-throttle", "ms", std::max(0, milliseconds)));
+}
+
+void LadderClient::switchSymbol(const QString &symbol, int levels, const QString &exchange)
+{
+    const QString targetExchange = exchange.isEmpty() ? m_exchange : exchange;
+    if (!isRunning() || targetExchange != m_exchange) {
+        restart(symbol, levels, targetExchange);
+        return;
+    }
+    if (levels != m_levels) {
+        setLevels(levels);
+    }
+    m_symbol = symbol;
+    m_wireSymbol = wireSymbolFor(m_symbol, m_exchange);
+    resetViewState();
+
+    json cmd;
+    cmd["cmd"] = "resubscribe-symbol";
+    cmd["stream"] = m_streamId;
+    cmd["symbol"] = m_wireSymbol.toStdString();
+    sendCommand(QByteArray::fromStdString(cmd.dump()));
+    emitStatus(QStringLiteral("Switching to %1...").arg(m_symbol));
+    armWatchdog();
+}
+
+void LadderClient::requestKeyframe()
+{
+    sendCommand(commandLine(m_streamId, "request-keyframe"));
+}
+
+QString LadderClient::latencyReport() const
+{
+    QString report = QStringLiteral("[%1@%2] ").arg(m_symbol.toUpper(), m_exchange.toUpper()) + m_latency.report();
+    report += QStringLiteral("\nsymbol switches: %1 warm, %2 loaded").arg(m_cacheHits).arg(m_cacheMisses);
+    if (m_dom) {
+        report += QLatin1Char('\n') + m_dom->repaintReport();
+    }
+    return report;
+}
+
+bool LadderClient::sendCommand(const QByteArray &line)
+{
+    // Writes made while the process is still starting are buffered by QProcess.
+    return m_backend && m_backend->send(line);
+}
+
+void LadderClient::resetViewState()
+{
+    m_initialCenterSent = false;
+    m_lastSeq = 0;
+    m_reportedSeq = 0;
+    m_feedStale = false;
+    m_feedConnected = true;
+    if (m_backend) {
+        // Drops any frame already decoded for the previous symbol or view.
+        m_backend->decoder().resetStream(m_streamId, m_wireSymbol, m_tickCompression);
+        m_backend->decoder().setPaused(m_streamId, !m_domVisible);
+    }
+    if (m_prints) {
+        m_prints->clearPrints();
+        const int rowH = m_dom ? m_dom->rowHeight() : 20;
+        m_prints->setLadderWindow(LadderWindow(), rowH);
+        QVector<LocalOrderMarker> emptyOrders;
+        m_prints->setLocalOrders(emptyOrders);
+    }
 }
 
 void LadderClient::handleErrorOccurred(QProcess::ProcessError error)
 {
-    qWarning() << "[LadderClient] backend error" << error << m_process.errorString();
-    emitStatus("Backend error: " + m_process.errorString());
+    Q_UNUSED(error);
+    emitStatus("Backend error: " + (m_backend ? m_backend->errorString() : QString()));
 }
 
 void LadderClient::handleFinished(int exitCode, QProcess::ExitStatus status)
 {
-    qWarning() << "[LadderClient] backend finished" << exitCode << status;
+    Q_UNUSED(status);
     emitStatus(QString("Backend finished (%1)").arg(exitCode));
     m_watchdogTimer.stop();
 }
 
-void LadderClient::processLine(const QByteArray &line)
+void LadderClient::processControlLine(const QByteArray &line)
 {
     json j;
     try {
@@ -176,167 +392,103 @@ void LadderClient::processLine(const QByteArray &line)
         return;
     }
 
-    const std::string type = j.value("type", std::string());
     armWatchdog();
-    if (type == "trade") {
-        if (!m_prints) {
-            return;
-        }
-        double price = j.value("price", 0.0);
-        const double qtyBase = j.value("qty", 0.0);
-        const std::string side = j.value("side", std::string("buy"));
-        if (price <= 0.0 || qtyBase <= 0.0) {
-            return;
-        }
-        if (m_lastPrices.isEmpty()) {
-            // Don't render until we have ladder prices to align to
-            return;
-        }
-        if (m_lastTickSize > 0.0) {
-            // Snap trade price to the current tick grid so it aligns with ladder rows.
-            const auto tick = static_cast<std::int64_t>(std::llround(price / m_lastTickSize));
-            price = static_cast<double>(tick) * m_lastTickSize;
-        }
-
-        int bestIdx = -1;
-        if (!m_lastPrices.isEmpty()) {
-            bestIdx = 0;
-            double bestDiff = std::numeric_limits<double>::max();
-            for (int i = 0; i < m_lastPrices.size(); ++i) {
-                const double diff = std::abs(m_lastPrices[i] - price);
-                if (diff < bestDiff) {
-                    bestDiff = diff;
-                    bestIdx = i;
-                }
+    const std::string type = j.value("type", std::string());
+    if (type == "heartbeat") {
+        // Once a second from the backend, and at once when its socket drops or the
+        // book is resynced; it keeps the watchdog quiet while the backend reconnects.
+        setFeedStale(j.value("stale", false), j.value("connected", true));
+        return;
+    }
+    if (type == "ack") {
+        const bool ok = j.value("ok", false);
+        const std::string cmd = j.value("cmd", std::string());
+        if (!ok && (cmd == "subscribe" || cmd == "resubscribe-symbol")) {
+            // The backend dropped our stream; the watchdog retries the subscription.
+            if (j.value("error", std::string()) == "channel-limit") {
+                emitStatus(QStringLiteral("MEXC allows 15 symbols per connection; close a column to load %1")
+                               .arg(m_symbol));
+            } else {
+                emitStatus(QStringLiteral("Failed to load %1").arg(m_symbol));
             }
-            price = m_lastPrices.value(bestIdx, price);
         }
-
-        const double qtyQuote = price * qtyBase;
-        if (qtyQuote <= 0.0) {
-            return;
+        const std::string cache = j.value("cache", std::string());
+        if (cache == "hit") {
+            ++m_cacheHits;
+        } else if (cache == "miss") {
+            ++m_cacheMisses;
         }
+    }
+}
 
-        PrintItem it;
-        it.price = price;
-        // Show quote (USDT) notional in the UI circles.
-        it.qty = qtyQuote;
-        it.buy = (side != "sell");
-        it.rowHint = bestIdx;
-        m_printBuffer.push_back(it);
-        const int maxPrints = 200;
-        if (m_printBuffer.size() > maxPrints) {
-            m_printBuffer.erase(m_printBuffer.begin(),
-                                m_printBuffer.begin() + (m_printBuffer.size() - maxPrints));
-        }
-        // ladderPrices уже приходят из ladder-сообщений; здесь только добавляем принт
-        m_prints->setPrints(m_printBuffer);
+void LadderClient::applyPendingFrame()
+{
+    if (!m_backend) {
         return;
     }
-
-    if (type != "ladder") {
+    LadderFrame frame;
+    if (!m_backend->decoder().takeFrame(m_streamId, frame)) {
         return;
     }
+    armWatchdog();
 
-    DomSnapshot snap;
-    snap.bestBid = j.value("bestBid", 0.0);
-    snap.bestAsk = j.value("bestAsk", 0.0);
-    snap.tickSize = j.value("tickSize", 0.0);
-    if (snap.tickSize > 0.0) {
-        m_lastTickSize = snap.tickSize;
+    if (!frame.error.isEmpty()) {
+        emitStatus(frame.error);
     }
-
-    auto rowsIt = j.find("rows");
-    if (rowsIt != j.end() && rowsIt->is_array()) {
-        for (const auto &row : *rowsIt) {
-            DomLevel lvl;
-            lvl.price = row.value("price", 0.0);
-            lvl.bidQty = row.value("bid", 0.0);
-            lvl.askQty = row.value("ask", 0.0);
-            snap.levels.push_back(lvl);
-        }
-        // Ensure levels are sorted top-to-bottom by price so DOM/prints share the same order
-        // regardless of backend row order.
-        std::sort(snap.levels.begin(), snap.levels.end(), [](const DomLevel &a, const DomLevel &b) {
-            return a.price > b.price;
-        });
-
-        // Compression: агрегируем уровни в корзины по m_tickCompression тиков.
-        if (m_tickCompression > 1 && snap.tickSize > 0.0) {
-            std::map<std::int64_t, DomLevel, std::greater<std::int64_t>> buckets;
-            for (const auto &lvl : snap.levels) {
-                const auto tick = static_cast<std::int64_t>(std::llround(lvl.price / snap.tickSize));
-                const std::int64_t bucketTick = (tick / m_tickCompression) * m_tickCompression;
-                DomLevel &dst = buckets[bucketTick];
-                dst.price = static_cast<double>(bucketTick) * snap.tickSize;
-                dst.bidQty += lvl.bidQty;
-                dst.askQty += lvl.askQty;
-            }
-            snap.levels.clear();
-            snap.levels.reserve(static_cast<int>(buckets.size()));
-            for (const auto &kv : buckets) {
-                snap.levels.push_back(kv.second);
-            }
-
-            // Пересчитать bestBid/bestAsk на ближайшее значение из агрегированных корзин,
-            // чтобы подсветка соответствовала фактическому биду/аску внутри бинов.
-            auto snapToBucket = [](double ref, const QVector<DomLevel> &levels) -> double {
-                if (ref <= 0.0 || levels.isEmpty()) {
-                    return ref;
-                }
-                double best = levels.first().price;
-                double bestDist = std::abs(levels.first().price - ref);
-                for (const auto &lvl : levels) {
-                    const double d = std::abs(lvl.price - ref);
-                    if (d < bestDist) {
-                        bestDist = d;
-                        best = lvl.price;
-                    }
-                }
-                return best;
-            };
-            snap.bestBid = snapToBucket(snap.bestBid, snap.levels);
-            snap.bestAsk = snapToBucket(snap.bestAsk, snap.levels);
-        }
+    if (frame.seq != 0) {
+        m_lastSeq = frame.seq;
     }
 
-    // Ping calculation from backend timestamp, if available.
-    const auto tsIt = j.find("timestamp");
-    if (tsIt != j.end() && tsIt->is_number_integer()) {
+    // Ping calculation from backend timestamp, if available. Hidden columns get
+    // it from top-of-book heartbeats that carry no snapshot.
+    if (frame.timestampMs >= 0) {
         const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
-        const qint64 tsMs = static_cast<qint64>(tsIt->get<std::int64_t>());
-        const int pingMs = static_cast<int>(std::max<qint64>(0, nowMs - tsMs));
+        const int pingMs = static_cast<int>(std::max<qint64>(0, nowMs - frame.timestampMs));
         emit pingUpdated(pingMs);
-        emitStatus(QStringLiteral("ping %1 ms").arg(pingMs));
-    } else {
-        emitStatus(QStringLiteral("Snapshot received"));
+        emitStatus(m_feedStale ? QStringLiteral("ping %1 ms, resyncing").arg(pingMs)
+                               : QStringLiteral("ping %1 ms").arg(pingMs));
     }
 
-    if (m_dom) {
-        double centerPrice = 0.0;
-        if (snap.bestBid > 0.0 && snap.bestAsk > 0.0) {
-            centerPrice = (snap.bestBid + snap.bestAsk) * 0.5;
-        } else if (snap.bestBid > 0.0) {
-            centerPrice = snap.bestBid;
-        } else if (snap.bestAsk > 0.0) {
-            centerPrice = snap.bestAsk;
+    if (frame.snapshot) {
+        const DomSnapshot &snap = *frame.snapshot;
+        if (frame.timestampMs < 0) {
+            emitStatus(QStringLiteral("Snapshot received"));
         }
-        if (centerPrice > 0.0 && !m_initialCenterSent) {
-            m_dom->setInitialCenterPrice(centerPrice);
-            m_initialCenterSent = true;
+
+        if (m_dom) {
+            double centerPrice = 0.0;
+            if (snap.bestBid > 0.0 && snap.bestAsk > 0.0) {
+                centerPrice = (snap.bestBid + snap.bestAsk) * 0.5;
+            } else if (snap.bestBid > 0.0) {
+                centerPrice = snap.bestBid;
+            } else if (snap.bestAsk > 0.0) {
+                centerPrice = snap.bestAsk;
+            }
+            if (centerPrice > 0.0 && !m_initialCenterSent) {
+                m_dom->setInitialCenterPrice(centerPrice);
+                m_initialCenterSent = true;
+            }
+            if (frame.trace.receivedUs > 0) {
+                m_paintTrace = frame.trace;
+                m_paintTrace.takenUs = wallClockUs();
+                m_tracePending = true;
+            }
+            m_dom->updateSnapshot(frame.snapshot);
         }
-        m_dom->updateSnapshot(snap);
-    }
 
-    if (m_prints) {
-        m_lastPrices.clear();
-        m_lastPrices.reserve(snap.levels.size());
-        for (const auto &lvl : snap.levels) {
-            m_lastPrices.push_back(lvl.price);
+        if (m_prints) {
+            const int rowH = m_dom ? m_dom->rowHeight() : 20;
+            m_prints->setLadderWindow(snap.window, rowH);
         }
-        const int rowH = m_dom ? m_dom->rowHeight() : 20;
-        const double tickForPrints = snap.tickSize > 0.0 ? snap.tickSize : m_lastTickSize;
-        m_prints->setLadderPrices(m_lastPrices, rowH, tickForPrints * m_tickCompression);
+    } else if (m_lastSeq != m_reportedSeq) {
+        // Only dropped ladders (old symbol or compression): nothing will be painted
+        // for them, so tell the backend right away.
+        sendConsumerReport(0.0);
+    }
+
+    if (frame.hasPrints && m_prints) {
+        // Only the trades decoded since the last frame; the widget keeps the history.
+        m_prints->appendPrints(frame.prints);
     }
 }
 
@@ -359,6 +511,22 @@ void LadderClient::armWatchdog()
     }
 }
 
+void LadderClient::setFeedStale(bool stale, bool connected)
+{
+    if (stale == m_feedStale && (!stale || connected == m_feedConnected)) {
+        return;
+    }
+    m_feedStale = stale;
+    m_feedConnected = connected;
+    if (!stale) {
+        emitStatus(QStringLiteral("Exchange feed restored"));
+    } else if (connected) {
+        emitStatus(QStringLiteral("Reconnected, resyncing book..."));
+    } else {
+        emitStatus(QStringLiteral("Exchange connection lost, reconnecting..."));
+    }
+}
+
 void LadderClient::handleWatchdogTimeout()
 {
     const qint64 now = QDateTime::currentMSecsSinceEpoch();
@@ -366,7 +534,12 @@ void LadderClient::handleWatchdogTimeout()
         // Data arrived while timer was firing.
         return;
     }
-    emitStatus(QStringLiteral("No data received for %1s, restarting backend...")
-                   .arg(m_watchdogIntervalMs / 1000));
+    if (m_backend && m_backend->isRunning() && m_backend->msSinceOutput() >= m_watchdogIntervalMs - 50) {
+        // Not even a heartbeat on any stream: the process is hung, not reconnecting.
+        emitStatus(QStringLiteral("Backend silent for %1s, restarting it...").arg(m_watchdogIntervalMs / 1000));
+        m_backend->restartProcess();
+        return;
+    }
+    emitStatus(QStringLiteral("No data received for %1s, resubscribing...").arg(m_watchdogIntervalMs / 1000));
     restart(m_symbol, m_levels);
 }
@@ -1,13 +1,19 @@
-// Lightweight client that runs orderbook_backend.exe and feeds DomWidget.
+// Lightweight client that subscribes one stream on a shared orderbook_backend.exe
+// and feeds DomWidget.
 
 #pragma once
 
 #include "DomWidget.h"
+#include "FeedLatency.h"
+#include "LadderBackend.h"
 #include "PrintsWidget.h"
+#include "RenderScheduler.h"
 
 #include <QByteArray>
 #include <QObject>
+#include <QPointer>
 #include <QProcess>
+#include <QSharedPointer>
 #include <QString>
 #include <QTimer>
 #include <QVector>
@@ -23,15 +29,39 @@ public:
                           DomWidget *dom,
                           QObject *parent = nullptr,
                           class PrintsWidget *prints = nullptr);
+    ~LadderClient() override;
 
+    // Starts the shared backend for `exchange` before any column asks for it: the
+    // process comes up, opens its socket and fetches the metadata of `symbols`.
+    // It stays warm for as long as the returned pointer is held.
+    static QSharedPointer<LadderBackend> prewarm(const QString &backendPath,
+                                                 const QString &exchange,
+                                                 const QStringList &symbols);
     void restart(const QString &symbol, int levels, const QString &exchange = QString());
     void stop();
     bool isRunning() const;
     void setCompression(int factor);
     int compression() const { return m_tickCompression; }
 
+    // Live reconfiguration over the backend's stdin command channel. These keep the
+    // process, its WebSocket and its book alive; they only fall back to restart()
+    // when no backend is running or the exchange itself changes.
+    // restart() resubscribes this column's stream; other columns on the same
+    // exchange keep running.
+    void setLevels(int levels);
+    void setThrottle(int milliseconds);
+    void switchSymbol(const QString &symbol, int levels, const QString &exchange = QString());
+    void requestKeyframe();
+
+    // Frames wait for `scheduler` to apply them at display refresh instead of being
+    // shown as soon as they are decoded; `column` is this ladder's container.
+    void setRenderScheduler(RenderScheduler *scheduler, QWidget *column);
+
+    // Per-stage latency of every traced ladder this column has painted so far, the
+    // backend's warm-book hits and misses on this column's symbol switches, then
+    // the DOM's full vs partial repaint counts, areas and paint times.
+    QString latencyReport() const;
 private slots:
-    void handleReadyRead();
     void handleErrorOccurred(QProcess::ProcessError error);
     void handleFinished(int exitCode, QProcess::ExitStatus status);
     void handleWatchdogTimeout();
@@ -40,25 +70,53 @@ signals:
     void statusMessage(const QString &message);
     void pingUpdated(int milliseconds);
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
     void emitStatus(const QString &msg);
-    void processLine(const QByteArray &line);
+    void processControlLine(const QByteArray &line);
+    void applyPendingFrame();
     void armWatchdog();
+    void setFeedStale(bool stale, bool connected);
+    void resetViewState();
+    void attachBackend();
+    void detachBackend();
+    // `reload`: have the backend load the book afresh rather than answer from memory.
+    void subscribe(bool reload = false);
+    bool sendCommand(const QByteArray &line);
+    void handleFrameRendered(double paintMs);
+    void sendConsumerReport(double paintMs);
 
     QString m_backendPath;
     QString m_symbol;
+    QString m_wireSymbol;
     int m_levels;
     QString m_exchange;
-    QProcess m_process;
-    QByteArray m_buffer;
+    QSharedPointer<LadderBackend> m_backend;
+    int m_streamId = 0;
+    bool m_subscribed = false;
     DomWidget *m_dom;
     bool m_initialCenterSent = false;
     class PrintsWidget *m_prints;
-    QVector<double> m_lastPrices;
-    double m_lastTickSize = 0.0;
-    QVector<PrintItem> m_printBuffer;
     QTimer m_watchdogTimer;
     qint64 m_lastUpdateMs = 0;
     const int m_watchdogIntervalMs = 15000;
     int m_tickCompression = 1;
+    // Consumer feedback for the backend's adaptive throttle (consumer-report).
+    quint64 m_lastSeq = 0;
+    quint64 m_reportedSeq = 0;
+    bool m_domVisible = true;
+    // The backend lost the exchange socket and our book missed updates (heartbeat).
+    bool m_feedStale = false;
+    bool m_feedConnected = true;
+    // Trace of the ladder handed to m_dom, recorded once its paint finishes.
+    FeedTrace m_paintTrace;
+    bool m_tracePending = false;
+    FeedLatency m_latency;
+    // Subscribes the backend answered from a resident book vs had to load.
+    int m_cacheHits = 0;
+    int m_cacheMisses = 0;
+    QPointer<RenderScheduler> m_scheduler;
+    int m_renderId = 0;
 };
@@ -0,0 +1,323 @@
+#include "LadderDecoder.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+
+using json = nlohmann::json;
+
+namespace {
+const int kMaxPrints = 200;
+} // namespace
+
+int ladderStreamId(const QByteArray &line)
+{
+    static const QByteArray key = QByteArrayLiteral("\"stream\":");
+    const int pos = line.indexOf(key);
+    if (pos < 0) {
+        return -1;
+    }
+    int id = 0;
+    bool any = false;
+    for (int i = pos + key.size(); i < line.size(); ++i) {
+        const char c = line.at(i);
+        if (c < '0' || c > '9') {
+            break;
+        }
+        id = id * 10 + (c - '0');
+        any = true;
+    }
+    return any ? id : -1;
+}
+
+LadderDecoder::LadderDecoder(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void LadderDecoder::resetStream(int streamId, const QString &wireSymbol, int compression)
+{
+    QMutexLocker lock(&m_mutex);
+    StreamState &state = m_streams[streamId];
+    const quint64 seq = state.pending.seq;
+    state = StreamState();
+    state.wireSymbol = wireSymbol;
+    state.compression = std::max(1, compression);
+    // Keep the consumed seq so the next report still covers ladders dropped here.
+    state.pending.seq = seq;
+}
+
+void LadderDecoder::setCompression(int streamId, int compression)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_streams.find(streamId);
+    if (it != m_streams.end()) {
+        it->compression = std::max(1, compression);
+    }
+}
+
+void LadderDecoder::setPaused(int streamId, bool paused)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_streams.find(streamId);
+    if (it == m_streams.end()) {
+        return;
+    }
+    it->paused = paused;
+    if (paused) {
+        // Not worth painting once the column is shown; a keyframe follows then.
+        it->pending.snapshot.reset();
+    }
+}
+
+void LadderDecoder::removeStream(int streamId)
+{
+    QMutexLocker lock(&m_mutex);
+    m_streams.remove(streamId);
+}
+
+bool LadderDecoder::takeFrame(int streamId, LadderFrame &out)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_streams.find(streamId);
+    if (it == m_streams.end() || !it->posted) {
+        return false;
+    }
+    out = std::move(it->pending);
+    it->pending = LadderFrame();
+    it->posted = false;
+    return true;
+}
+
+void LadderDecoder::decodeLines(const QVector<QByteArray> &lines, qint64 receivedUs)
+{
+    for (const QByteArray &line : lines) {
+        decodeLine(ladderStreamId(line), line, receivedUs);
+    }
+}
+
+void LadderDecoder::decodeLine(int streamId, const QByteArray &line, qint64 receivedUs)
+{
+    json j;
+    try {
+        j = json::parse(line.constData(), line.constData() + line.size());
+    } catch (const std::exception &ex) {
+        qWarning() << "[LadderDecoder] parse error:" << ex.what();
+        QMutexLocker lock(&m_mutex);
+        auto it = m_streams.find(streamId);
+        if (it != m_streams.end()) {
+            it->pending.error = QStringLiteral("Parse error: ") + QString::fromUtf8(ex.what());
+            post(streamId, *it);
+        }
+        return;
+    }
+
+    const std::string type = j.value("type", std::string());
+    const QString symbol = QString::fromStdString(j.value("symbol", std::string()));
+
+    if (type == "trade") {
+        double price = j.value("price", 0.0);
+        const double qtyBase = j.value("qty", 0.0);
+        const std::string side = j.value("side", std::string("buy"));
+        if (price <= 0.0 || qtyBase <= 0.0) {
+            return;
+        }
+
+        QMutexLocker lock(&m_mutex);
+        auto it = m_streams.find(streamId);
+        if (it == m_streams.end()) {
+            return;
+        }
+        StreamState &state = *it;
+        // Trades already queued on the pipe for the symbol we just switched away from.
+        if (!symbol.isEmpty() && symbol != state.wireSymbol) {
+            return;
+        }
+        if (!state.lastSnapshot || !state.lastSnapshot->window.isValid()) {
+            // Don't render until we have a ladder window to align to
+            return;
+        }
+        // Snap onto the tick grid and then onto the row's compression bucket, so
+        // the print shows the price of the ladder row it lands on.
+        const LadderWindow &window = state.lastSnapshot->window;
+        const qint64 tick = window.bucketTick(window.tickForPrice(price));
+        price = static_cast<double>(tick) * window.tickSize;
+
+        const double qtyQuote = price * qtyBase;
+        if (qtyQuote <= 0.0) {
+            return;
+        }
+
+        PrintItem item;
+        item.price = price;
+        // Show quote (USDT) notional in the UI circles.
+        item.qty = qtyQuote;
+        item.buy = (side != "sell");
+        item.outsideWindow = window.rowForTick(tick) < 0;
+        QVector<PrintItem> &batch = state.pending.prints;
+        if (batch.size() >= kMaxPrints) {
+            // The GUI fell behind; PrintsWidget keeps no more than this anyway.
+            batch.removeFirst();
+        }
+        batch.push_back(item);
+        state.pending.hasPrints = true;
+        post(streamId, state);
+        return;
+    }
+
+    if (type != "ladder") {
+        return;
+    }
+
+    // Everything below that doesn't depend on per-stream state runs unlocked.
+    const quint64 seq = j.value("seq", quint64(0));
+    const int frameCompression = std::max(1, j.value("compression", 1));
+
+    qint64 timestampMs = -1;
+    const auto tsIt = j.find("timestamp");
+    if (tsIt != j.end() && tsIt->is_number_integer()) {
+        timestampMs = static_cast<qint64>(tsIt->get<std::int64_t>());
+    }
+
+    {
+        // Hidden columns: top-of-book heartbeats from the backend, and full ladders
+        // that were already on the pipe when the column was hidden, only keep the
+        // watchdog and ping going.
+        QMutexLocker lock(&m_mutex);
+        auto it = m_streams.find(streamId);
+        if (it == m_streams.end()) {
+            return;
+        }
+        if (it->paused || j.value("topOfBook", false)) {
+            it->pending.seq = std::max(it->pending.seq, seq);
+            it->pending.timestampMs = timestampMs;
+            post(streamId, *it);
+            return;
+        }
+    }
+
+    DomSnapshot snap;
+    snap.bestBid = j.value("bestBid", 0.0);
+    snap.bestAsk = j.value("bestAsk", 0.0);
+    snap.tickSize = j.value("tickSize", 0.0);
+
+    auto rowsIt = j.find("rows");
+    if (rowsIt != j.end() && rowsIt->is_array()) {
+        snap.levels.reserve(static_cast<int>(rowsIt->size()));
+        for (const auto &row : *rowsIt) {
+            DomLevel lvl;
+            lvl.price = row.value("price", 0.0);
+            lvl.bidQty = row.value("bid", 0.0);
+            lvl.askQty = row.value("ask", 0.0);
+            snap.levels.push_back(lvl);
+        }
+        // Ensure levels are sorted top-to-bottom by price so DOM/prints share the same order
+        // regardless of backend row order.
+        std::sort(snap.levels.begin(), snap.levels.end(), [](const DomLevel &a, const DomLevel &b) {
+            return a.price > b.price;
+        });
+    }
+
+    FeedTrace trace;
+    const auto traceIt = j.find("trace");
+    if (traceIt != j.end() && traceIt->is_object()) {
+        trace.exchangeUs = traceIt->value("exch", qint64(0));
+        trace.receivedUs = traceIt->value("recv", qint64(0));
+        trace.decodedUs = traceIt->value("decoded", qint64(0));
+        trace.appliedUs = traceIt->value("applied", qint64(0));
+        trace.emittedUs = traceIt->value("emitted", qint64(0));
+        trace.guiReceivedUs = receivedUs;
+    }
+    QMutexLocker lock(&m_mutex);
+    auto it = m_streams.find(streamId);
+    if (it == m_streams.end()) {
+        return;
+    }
+    StreamState &state = *it;
+    state.pending.seq = std::max(state.pending.seq, seq);
+
+    const bool staleSymbol = !symbol.isEmpty() && symbol != state.wireSymbol;
+    // Backends that understand set-compression aggregate rows themselves and say so.
+    const bool staleCompression = frameCompression > 1 && frameCompression != state.compression;
+    if (staleSymbol || staleCompression) {
+        // Consumed without painting; the client reports the seq so the backend
+        // doesn't hold back the next ladder. A keyframe for the new view follows.
+        post(streamId, state);
+        return;
+    }
+
+    // Compression: агрегируем уровни в корзины по compression тиков.
+    const int compression = state.compression;
+    if (compression > 1 && frameCompression == 1 && snap.tickSize > 0.0 && !snap.levels.isEmpty()) {
+        std::map<std::int64_t, DomLevel, std::greater<std::int64_t>> buckets;
+        for (const auto &lvl : snap.levels) {
+            const auto tick = static_cast<std::int64_t>(std::llround(lvl.price / snap.tickSize));
+            const std::int64_t bucketTick = (tick / compression) * compression;
+            DomLevel &dst = buckets[bucketTick];
+            dst.price = static_cast<double>(bucketTick) * snap.tickSize;
+            dst.bidQty += lvl.bidQty;
+            dst.askQty += lvl.askQty;
+        }
+        snap.levels.clear();
+        snap.levels.reserve(static_cast<int>(buckets.size()));
+        for (const auto &kv : buckets) {
+            snap.levels.push_back(kv.second);
+        }
+
+        // Пересчитать bestBid/bestAsk на ближайшее значение из агрегированных корзин,
+        // чтобы подсветка соответствовала фактическому биду/аску внутри бинов.
+        auto snapToBucket = [](double ref, const QVector<DomLevel> &levels) -> double {
+            if (ref <= 0.0 || levels.isEmpty()) {
+                return ref;
+            }
+            double best = levels.first().price;
+            double bestDist = std::abs(levels.first().price - ref);
+            for (const auto &lvl : levels) {
+                const double d = std::abs(lvl.price - ref);
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = lvl.price;
+                }
+            }
+            return best;
+        };
+        snap.bestBid = snapToBucket(snap.bestBid, snap.levels);
+        snap.bestAsk = snapToBucket(snap.bestAsk, snap.levels);
+    }
+
+    if (!snap.levels.isEmpty()) {
+        const int rowTicks = frameCompression > 1 ? frameCompression : compression;
+        snap.window = LadderWindow::fromRange(snap.levels.first().price,
+                                              snap.levels.last().price,
+                                              snap.levels.size(),
+                                              snap.tickSize,
+                                              rowTicks);
+    }
+
+    // Built once; the mailbox, trade snapping and the widgets all share it.
+    state.lastSnapshot = QSharedPointer<DomSnapshot>::create(std::move(snap));
+
+    LadderFrame &frame = state.pending;
+    frame.snapshot = state.lastSnapshot;
+    frame.timestampMs = timestampMs;
+    frame.trace = trace;
+    if (frame.trace.receivedUs > 0) {
+        frame.trace.builtUs = wallClockUs();
+    }
+    post(streamId, state);
+}
+
+void LadderDecoder::post(int streamId, StreamState &state)
+{
+    if (state.posted) {
+        // The GUI hasn't collected the previous frame yet; it will get this one instead.
+        return;
+    }
+    state.posted = true;
+    emit frameReady(streamId);
+}
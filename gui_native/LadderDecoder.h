@@ -0,0 +1,72 @@
+// Decodes orderbook_backend ladder/trade lines off the GUI thread.
+
+#pragma once
+
+#include "DomWidget.h"
+#include "FeedLatency.h"
+#include "PrintsWidget.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+// Stream id of a backend line (nlohmann dumps, so a plain integer field); -1 if absent.
+int ladderStreamId(const QByteArray &line);
+
+// Everything a LadderClient needs to repaint one column. Built on the decoder
+// thread and handed over by value; the snapshot itself is shared, never copied.
+struct LadderFrame {
+    DomSnapshotPtr snapshot;     // null if no ladder; its window also lays out PrintsWidget rows
+    qint64 timestampMs = -1;     // backend wall clock of the snapshot, -1 if absent
+    FeedTrace trace;             // receivedUs == 0 unless the backend traced this ladder
+
+    bool hasPrints = false;
+    QVector<PrintItem> prints;   // trades since the last taken frame, already snapped to rows
+
+    quint64 seq = 0;             // newest ladder consumed, painted or dropped
+    QString error;
+};
+
+// One instance per backend process, living on its own thread. Each stream has a
+// mailbox holding at most one pending frame: a newer ladder replaces the older
+// one, trades accumulate, and frameReady() fires only when the mailbox goes
+// from empty to full, so a busy GUI thread never works through a backlog.
+class LadderDecoder : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LadderDecoder(QObject *parent = nullptr);
+
+    // GUI thread. (Re)starts a stream's view: drops its pending frame and trades.
+    void resetStream(int streamId, const QString &wireSymbol, int compression);
+    void setCompression(int streamId, int compression);
+    // Hidden column: ladders only update seq and timestamp, no snapshot is built.
+    void setPaused(int streamId, bool paused);
+    void removeStream(int streamId);
+    bool takeFrame(int streamId, LadderFrame &out);
+
+    // Decoder thread. `receivedUs` is when LadderBackend read the batch off the pipe.
+    void decodeLines(const QVector<QByteArray> &lines, qint64 receivedUs);
+
+signals:
+    void frameReady(int streamId);
+
+private:
+    struct StreamState {
+        QString wireSymbol;
+        int compression = 1;
+        bool paused = false;
+        DomSnapshotPtr lastSnapshot; // the last ladder posted, for trade snapping
+        LadderFrame pending;
+        bool posted = false;
+    };
+
+    void decodeLine(int streamId, const QByteArray &line, qint64 receivedUs);
+    void post(int streamId, StreamState &state);
+
+    QMutex m_mutex;
+    QHash<int, StreamState> m_streams;
+};
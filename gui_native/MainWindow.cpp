@@ -5,6 +5,7 @@
 #include "LadderClient.h"
 #include "PluginsWindow.h"
 #include "PrintsWidget.h"
+#include "RenderScheduler.h"
 #include "SettingsWindow.h"
 #include "TradeManager.h"
 #include "SymbolPickerDialog.h"
@@ -39,7 +40,6 @@
 #include <QTabBar>
 #include <QTimer>
 #include <QToolButton>
-#include <QScrollArea>
 #include <QScrollBar>
 #include <QVariant>
 #include <QVBoxLayout>
@@ -343,6 +343,7 @@ MainWindow::MainWindow(const QString &backendPath,
     , m_connectionStore(new ConnectionStore(this))
     , m_tradeManager(new TradeManager(this))
     , m_connectionsWindow(nullptr)
+    , m_renderScheduler(new RenderScheduler(this))
     , m_tabs()
     , m_nextTabId(1)
     , m_recycledTabIds()
@@ -578,7 +579,12 @@ MainWindow::MainWindow(const QString &backendPath,
     }
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    // MainWindow outlives app.exec(), so released backends never see their
+    // deleteLater(); end the processes here rather than orphan them.
+    LadderBackend::shutdownAll();
+}
 
 void MainWindow::buildUi()
 {
@@ -1228,6 +1234,11 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
         event->accept();
         return;
     }
+    if (key == Qt::Key_L && mods == (Qt::ControlModifier | Qt::ShiftModifier)) {
+        dumpLadderLatency();
+        event->accept();
+        return;
+    }
     if (matchesHotkey(key, mods, m_volumeAdjustKey, m_volumeAdjustMods)) {
         m_capsAdjustMode = true;
         event->accept();
@@ -1654,11 +1665,8 @@ QWidget *MainWindow::buildMainArea(QWidget *parent)
 
 void MainWindow::createInitialWorkspace()
 {
-    if (!m_savedLayout.isEmpty()) {
-        for (const auto &cols : m_savedLayout) {
-            createWorkspaceTab(cols);
-        }
-    } else {
+    QVector<QVector<SavedColumn>> layout = m_savedLayout;
+    if (layout.isEmpty()) {
         QVector<SavedColumn> cols;
         cols.reserve(m_symbols.size());
         for (const QString &s : m_symbols) {
@@ -1672,10 +1680,35 @@ void MainWindow::createInitialWorkspace()
             sc.account = QStringLiteral("MEXC Spot");
             cols.push_back(sc);
         }
+        layout.push_back(cols);
+    }
+    prewarmBackends(layout);
+    for (const auto &cols : layout) {
         createWorkspaceTab(cols);
     }
 }
 
+void MainWindow::prewarmBackends(const QVector<QVector<SavedColumn>> &layout)
+{
+    // One multiplexed backend serves every column of an exchange, so the layout
+    // sizes the pool by its exchanges. Each gets the layout's symbols prefetched;
+    // holding it keeps the process and its socket up even while no column uses it.
+    QHash<QString, QStringList> symbolsByExchange;
+    QStringList order;
+    for (const auto &cols : layout) {
+        for (const SavedColumn &col : cols) {
+            const QString exchange = backendExchangeForAccount(col.account);
+            if (!symbolsByExchange.contains(exchange)) {
+                order.push_back(exchange);
+            }
+            symbolsByExchange[exchange].push_back(col.symbol);
+        }
+    }
+    for (const QString &exchange : order) {
+        m_warmBackends.push_back(LadderClient::prewarm(m_backendPath, exchange, symbolsByExchange.value(exchange)));
+    }
+}
+
 void MainWindow::updateTabUnderline(int index)
 {
     if (!m_workspaceTabs || index < 0) {
@@ -2018,7 +2051,7 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
     prints->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Expanding);
 
     auto *dom = new DomWidget(column);
-    dom->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    dom->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     dom->setVolumeHighlightRules(m_volumeRules);
     prints->setRowHeightOnly(dom->rowHeight());
 
@@ -2026,7 +2059,7 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
     printsDomSplitter->setObjectName(QStringLiteral("DomPrintsSplitter"));
     printsDomSplitter->setChildrenCollapsible(false);
     printsDomSplitter->setHandleWidth(2);
-    printsDomSplitter->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    printsDomSplitter->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
     auto *printsContainer = new QWidget(printsDomSplitter);
     auto *printsLayout = new QVBoxLayout(printsContainer);
@@ -2056,17 +2089,16 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
         handle->setCursor(Qt::SizeHorCursor);
     }
 
-    auto *scroll = new QScrollArea(column);
-    scroll->setFrameShape(QFrame::NoFrame);
-    scroll->setWidgetResizable(true);
-    scroll->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    scroll->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    auto *domScrollBar = new DomScrollBar(Qt::Vertical, scroll);
+    // The ladder scrolls itself (DomWidget keeps a price anchor and paints only what
+    // is visible); the bar beside it just mirrors and drives that position.
+    auto *domScrollBar = new DomScrollBar(Qt::Vertical, column);
     domScrollBar->setObjectName(QStringLiteral("DomScrollBar"));
-    scroll->setVerticalScrollBar(domScrollBar);
-    scroll->setWidget(contentWidget);
+    contentRow->addWidget(domScrollBar);
+    dom->setScrollBar(domScrollBar);
+    connect(dom, &DomWidget::viewportChanged, prints, &PrintsWidget::setTopRow);
+    connect(prints, &PrintsWidget::scrollRequested, dom, &DomWidget::scrollByRows);
 
-    layout->addWidget(scroll, 1);
+    layout->addWidget(contentWidget, 1);
 
     // Notional presets pinned to viewport (always visible regardless of scroll position).
     for (std::size_t i = 0; i < result.notionalValues.size(); ++i)
@@ -2075,7 +2107,7 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
     }
     result.orderNotional = result.notionalValues.at(std::min<std::size_t>(3, result.notionalValues.size() - 1));
     const int presetCount = static_cast<int>(result.notionalValues.size());
-    auto *notionalOverlay = new QWidget(scroll->viewport());
+    auto *notionalOverlay = new QWidget(contentWidget);
     notionalOverlay->setAttribute(Qt::WA_TranslucentBackground, true);
     notionalOverlay->setStyleSheet(QStringLiteral("background: transparent;"));
     auto *notionalLayout = new QVBoxLayout(notionalOverlay);
@@ -2131,22 +2163,22 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
     }
     notionalOverlay->adjustSize();
 
-    auto repositionOverlay = [scroll, notionalOverlay]() {
-        if (!notionalOverlay || !scroll) return;
+    auto repositionOverlay = [contentWidget, notionalOverlay]() {
+        if (!notionalOverlay || !contentWidget) return;
         notionalOverlay->adjustSize();
         const int x = 2;
         const int bottomMargin = 24;
-        int y = scroll->viewport()->height() - notionalOverlay->height() - bottomMargin;
+        int y = contentWidget->height() - notionalOverlay->height() - bottomMargin;
         if (y < 8) y = 8;
-        const int maxY = std::max(0, scroll->viewport()->height() - notionalOverlay->height() - 6);
+        const int maxY = std::max(0, contentWidget->height() - notionalOverlay->height() - 6);
         if (y > maxY) y = maxY;
         notionalOverlay->move(x, y);
         notionalOverlay->raise();
         notionalOverlay->show();
     };
-    scroll->viewport()->installEventFilter(this);
-    scroll->viewport()->setProperty("notionalOverlayPtr",
-                                    QVariant::fromValue<quintptr>(reinterpret_cast<quintptr>(notionalOverlay)));
+    contentWidget->installEventFilter(this);
+    contentWidget->setProperty("notionalOverlayPtr",
+                               QVariant::fromValue<quintptr>(reinterpret_cast<quintptr>(notionalOverlay)));
     repositionOverlay();
     QTimer::singleShot(0, this, repositionOverlay);
 
@@ -2171,13 +2203,9 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
     }
 
     const QString symbolUpper = result.symbol;
-    const auto source = symbolSourceForAccount(result.accountName.isEmpty() ? QStringLiteral("MEXC Spot")
-                                                                            : result.accountName);
-    const QString exchangeArg = (source == SymbolSource::UzxSwap)
-                                    ? QStringLiteral("uzxswap")
-                                    : (source == SymbolSource::UzxSpot) ? QStringLiteral("uzxspot")
-                                                                        : QStringLiteral("mexc");
+    const QString exchangeArg = backendExchangeForAccount(result.accountName);
     auto *client = new LadderClient(m_backendPath, symbolUpper, m_levels, exchangeArg, dom, column, prints);
+    client->setRenderScheduler(m_renderScheduler, column);
     client->setCompression(result.tickCompression);
 
     connect(client,
@@ -2206,15 +2234,10 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
     connect(levelsSpin,
             QOverload<int>::of(&QSpinBox::valueChanged),
             this,
-            [this, client, &column = tab.columnsData.back()](int value) {
+            [this, client](int value) {
                 m_levels = value;
                 if (client) {
-                    const auto src = symbolSourceForAccount(column.accountName);
-                    const QString exch = (src == SymbolSource::UzxSwap)
-                                             ? QStringLiteral("uzxswap")
-                                             : (src == SymbolSource::UzxSpot) ? QStringLiteral("uzxspot")
-                                                                              : QStringLiteral("mexc");
-                    client->restart(column.symbol, value, exch);
+                    client->setLevels(value);
                 }
             });
     connect(compressionButton, &QToolButton::clicked, this, [this, column, compressionButton]() {
@@ -2258,7 +2281,6 @@ MainWindow::DomColumn MainWindow::createDomColumn(const QString &symbol,
     result.container = column;
     result.dom = dom;
     result.prints = prints;
-    result.scrollArea = scroll;
     result.scrollBar = domScrollBar;
     result.client = client;
     result.levelsSpin = levelsSpin;
@@ -3861,12 +3883,27 @@ void MainWindow::refreshActiveLadder()
     }
     const int levels = col->levelsSpin ? col->levelsSpin->value() : m_levels;
     m_levels = levels;
-        const auto src = symbolSourceForAccount(col->accountName);
-        const QString exch = (src == SymbolSource::UzxSwap)
-                                 ? QStringLiteral("uzxswap")
-                                 : (src == SymbolSource::UzxSpot) ? QStringLiteral("uzxspot")
-                                                                  : QStringLiteral("mexc");
-        col->client->restart(col->symbol, levels, exch);
+        col->client->restart(col->symbol, levels, backendExchangeForAccount(col->accountName));
+}
+
+void MainWindow::dumpLadderLatency()
+{
+    int columns = 0;
+    for (const auto &tab : m_tabs) {
+        for (const auto &col : tab.columnsData) {
+            if (col.client) {
+                qInfo().noquote() << col.client->latencyReport();
+                ++columns;
+            }
+        }
+    }
+    qInfo().noquote() << QStringLiteral("[RenderScheduler] %1 frames applied, %2 deferred for the frame budget")
+                             .arg(m_renderScheduler->appliedFrames())
+                             .arg(m_renderScheduler->deferredFrames());
+    if (m_tradeManager) {
+        qInfo().noquote() << m_tradeManager->orderLatencyReport();
+    }
+    statusBar()->showMessage(tr("Latency of %1 ladders written to the log").arg(columns), 3000);
 }
 
 void MainWindow::handleSettingsSearch()
@@ -4742,6 +4779,20 @@ MainWindow::SymbolSource MainWindow::symbolSourceForAccount(const QString &accou
     return SymbolSource::Mexc;
 }
 
+QString MainWindow::backendExchangeForAccount(const QString &accountName) const
+{
+    // Columns without an account trade on MEXC spot.
+    switch (symbolSourceForAccount(accountName.isEmpty() ? QStringLiteral("MEXC Spot") : accountName)) {
+    case SymbolSource::UzxSwap:
+        return QStringLiteral("uzxswap");
+    case SymbolSource::UzxSpot:
+        return QStringLiteral("uzxspot");
+    case SymbolSource::Mexc:
+        break;
+    }
+    return QStringLiteral("mexc");
+}
+
 void MainWindow::fetchSymbolLibrary(SymbolSource source, SymbolPickerDialog *dlg)
 {
     if (source == SymbolSource::Mexc) {
@@ -4946,12 +4997,7 @@ void MainWindow::applySymbolToColumn(DomColumn &col,
 
     const int levels = col.levelsSpin ? col.levelsSpin->value() : m_levels;
     if (col.client) {
-        const auto src = symbolSourceForAccount(col.accountName);
-        const QString exch = (src == SymbolSource::UzxSwap)
-                                 ? QStringLiteral("uzxswap")
-                                 : (src == SymbolSource::UzxSpot) ? QStringLiteral("uzxspot")
-                                                                  : QStringLiteral("mexc");
-        col.client->restart(sym, levels, exch);
+        col.client->switchSymbol(sym, levels, backendExchangeForAccount(col.accountName));
     }
 }
 
@@ -14,6 +14,7 @@
 #include <QNetworkAccessManager>
 #include <QSet>
 #include <QHash>
+#include <QSharedPointer>
 #include <array>
 
 class QLabel;
@@ -32,17 +33,18 @@ class QCompleter;
 class QPushButton;
 class QIcon;
 class QEvent;
-class QScrollArea;
 class QScrollBar;
 class QSpinBox;
 class QSpinBox;
 
 class DomWidget;
+class LadderBackend;
 class LadderClient;
 class PrintsWidget;
 class PluginsWindow;
 class ConnectionStore;
 class ConnectionsWindow;
+class RenderScheduler;
 class SymbolPickerDialog;
 
 struct SavedColumn {
@@ -119,7 +121,6 @@ private:
         DomWidget *dom = nullptr;
         LadderClient *client = nullptr;
         PrintsWidget *prints = nullptr;
-        QScrollArea *scrollArea = nullptr;
         QScrollBar *scrollBar = nullptr;
         QWidget *floatingWindow = nullptr;
         QLabel *tickerLabel = nullptr;
@@ -189,6 +190,7 @@ private:
     QVector<VolumeHighlightRule> defaultVolumeHighlightRules() const;
     void applyVolumeRulesToAllDoms();
     void refreshActiveLadder();
+    void dumpLadderLatency();
     DomColumn *focusedDomColumn();
     void adjustVolumeRulesBySteps(int steps);
     QVector<SettingsWindow::HotkeyEntry> currentCustomHotkeys() const;
@@ -225,6 +227,8 @@ private:
     void fetchSymbolLibrary();
     void fetchSymbolLibrary(SymbolSource source, SymbolPickerDialog *dlg = nullptr);
     SymbolSource symbolSourceForAccount(const QString &accountName) const;
+    QString backendExchangeForAccount(const QString &accountName) const;
+    void prewarmBackends(const QVector<QVector<SavedColumn>> &layout);
     void mergeSymbolLibrary(const QStringList &symbols, const QSet<QString> &apiOff);
     void addNotification(const QString &text, bool unread = true);
     void updateAlertsBadge();
@@ -304,6 +308,9 @@ private:
     ConnectionStore *m_connectionStore;
     TradeManager *m_tradeManager;
     ConnectionsWindow *m_connectionsWindow;
+    RenderScheduler *m_renderScheduler;
+    // One backend per exchange of the saved layout, started before its columns.
+    QVector<QSharedPointer<LadderBackend>> m_warmBackends;
 
     QVector<WorkspaceTab> m_tabs;
     int m_nextTabId;
@@ -0,0 +1,193 @@
+#include "OrderChannel.h"
+
+#include <QDebug>
+#include <QHostInfo>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QStringList>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+bool isSecure(const QUrl &url)
+{
+    return url.scheme() == QLatin1String("https");
+}
+
+quint16 portOf(const QUrl &url)
+{
+    return static_cast<quint16>(url.port(isSecure(url) ? 443 : 80));
+}
+} // namespace
+
+OrderChannel::OrderChannel(const QUrl &baseUrl, const QString &pingPath, QObject *parent)
+    : QObject(parent)
+    , m_baseUrl(baseUrl)
+    , m_pingPath(pingPath)
+    , m_ssl(QSslConfiguration::defaultConfiguration())
+{
+    // Offer HTTP/2 so a single multiplexed connection carries every order.
+    m_ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QByteArrayLiteral("http/1.1")});
+    m_pingTimer.setInterval(kPingIntervalMs);
+    connect(&m_pingTimer, &QTimer::timeout, this, &OrderChannel::ping);
+}
+
+void OrderChannel::start()
+{
+    if (!m_pingTimer.isActive()) {
+        m_pingTimer.start();
+    }
+    lookupHost(true);
+}
+
+void OrderChannel::stop()
+{
+    m_pingTimer.stop();
+    m_network.clearConnectionCache();
+}
+
+void OrderChannel::lookupHost(bool thenConnect)
+{
+    // Resolving here fills Qt's host cache, which the connection itself reads.
+    auto clock = std::make_shared<QElapsedTimer>();
+    clock->start();
+    QHostInfo::lookupHost(m_baseUrl.host(), this, [this, clock, thenConnect](const QHostInfo &info) {
+        m_stages[Dns].record(clock->nsecsElapsed() / 1000);
+        if (info.error() != QHostInfo::NoError) {
+            qWarning() << "[OrderChannel]" << m_baseUrl.host() << "lookup failed:" << info.errorString();
+            return;
+        }
+        if (!thenConnect) {
+            return;
+        }
+        if (isSecure(m_baseUrl)) {
+            m_network.connectToHostEncrypted(m_baseUrl.host(), portOf(m_baseUrl), m_ssl);
+        } else {
+            m_network.connectToHost(m_baseUrl.host(), portOf(m_baseUrl));
+        }
+    });
+}
+
+void OrderChannel::ping()
+{
+    if (m_sinceUse.isValid() && m_sinceUse.elapsed() < kPingIntervalMs) {
+        // Orders kept the connection busy; nothing to refresh.
+        return;
+    }
+    lookupHost(false);
+    QUrl url = m_baseUrl;
+    url.setPath(m_pingPath);
+    QNetworkRequest request(url);
+    QNetworkReply *reply = dispatch(request, QByteArrayLiteral("GET"), QByteArray());
+    ++m_pings;
+    connect(reply, &QNetworkReply::finished, reply, &QObject::deleteLater);
+}
+
+QNetworkReply *OrderChannel::dispatch(QNetworkRequest &request, const QByteArray &verb, const QByteArray &body)
+{
+    if (isSecure(request.url())) {
+        // Same configuration as the preconnect, so the request finds that connection.
+        request.setSslConfiguration(m_ssl);
+    }
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    if (verb == "GET") {
+        return m_network.get(request);
+    }
+    if (verb == "POST") {
+        return m_network.post(request, body);
+    }
+    return m_network.sendCustomRequest(request, verb, body);
+}
+
+QNetworkReply *OrderChannel::send(QNetworkRequest request, const QByteArray &verb, const QByteArray &body)
+{
+    struct Stamps {
+        QElapsedTimer clock;
+        qint64 connectingNs = -1;
+        qint64 encryptedNs = -1;
+        qint64 sentNs = -1;
+        qint64 headersNs = -1;
+    };
+    auto stamps = std::make_shared<Stamps>();
+    stamps->clock.start();
+    m_sinceUse.start();
+
+    QNetworkReply *reply = dispatch(request, verb, body);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [stamps]() {
+        if (stamps->connectingNs < 0) {
+            stamps->connectingNs = stamps->clock.nsecsElapsed();
+        }
+    });
+    connect(reply, &QNetworkReply::requestSent, this, [stamps]() {
+        stamps->sentNs = stamps->clock.nsecsElapsed();
+    });
+#endif
+    connect(reply, &QNetworkReply::encrypted, this, [stamps]() {
+        stamps->encryptedNs = stamps->clock.nsecsElapsed();
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [stamps]() {
+        if (stamps->headersNs < 0) {
+            stamps->headersNs = stamps->clock.nsecsElapsed();
+        }
+    });
+    const QString path = request.url().path();
+    connect(reply, &QNetworkReply::finished, this, [this, stamps, path]() {
+        const Stamps &s = *stamps;
+        Timing timing;
+        timing.us.fill(-1);
+        timing.reused = s.connectingNs < 0 && s.encryptedNs < 0;
+        if (!timing.reused) {
+            // Plain HTTP (a mock exchange) has no TLS step: the handshake ends with the write.
+            const qint64 end = s.encryptedNs >= 0 ? s.encryptedNs : s.sentNs;
+            if (end >= 0) {
+                timing.us[Handshake] = (end - std::max<qint64>(0, s.connectingNs)) / 1000;
+            }
+        }
+        if (s.sentNs >= 0) {
+            timing.us[Request] = s.sentNs / 1000;
+        }
+        if (s.headersNs >= 0) {
+            timing.us[FirstByte] = (s.headersNs - std::max<qint64>(0, s.sentNs)) / 1000;
+        }
+        timing.us[Total] = s.clock.nsecsElapsed() / 1000;
+
+        for (int i = Handshake; i < StageCount; ++i) {
+            if (timing.us[i] >= 0) {
+                m_stages[i].record(timing.us[i]);
+            }
+        }
+        ++m_requests;
+        m_reused += timing.reused ? 1 : 0;
+        emit requestTimed(path, timing);
+    });
+    return reply;
+}
+
+QString OrderChannel::report() const
+{
+    static const char *const names[StageCount] = {"dns", "handshake", "request", "first byte", "total"};
+    auto ms = [](qint64 us) { return QString::number(static_cast<double>(us) / 1000.0, 'f', 2); };
+
+    QStringList lines;
+    lines << QStringLiteral("%1 order requests (%2 on an open connection), %3 keep-alive pings; "
+                            "p50 / p90 / p99 / max, ms")
+                 .arg(m_requests)
+                 .arg(m_reused)
+                 .arg(m_pings);
+    for (int i = 0; i < StageCount; ++i) {
+        const LatencyHistogram &h = m_stages[i];
+        if (h.count() == 0) {
+            continue;
+        }
+        lines << QStringLiteral("  %1 %2 / %3 / %4 / %5")
+                     .arg(QString::fromLatin1(names[i]), -12)
+                     .arg(ms(h.percentileUs(0.50)),
+                          ms(h.percentileUs(0.90)),
+                          ms(h.percentileUs(0.99)),
+                          ms(h.maxUs()));
+    }
+    return lines.join(QLatin1Char('\n'));
+}
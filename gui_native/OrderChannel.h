@@ -0,0 +1,80 @@
+// Dedicated HTTPS channel for one account's order entry.
+
+#pragma once
+
+#include "FeedLatency.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QSslConfiguration>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+
+#include <array>
+
+class QNetworkReply;
+class QNetworkRequest;
+
+// Orders get their own QNetworkAccessManager, so they never queue behind the shared
+// one's polling and its pooled connection is theirs alone. start() resolves the host
+// and opens the TLS connection (offering HTTP/2) before the first click; while no
+// order goes out, a cheap GET every kPingIntervalMs keeps the server from closing
+// it and reopens it after a drop. Every order request is timed per stage.
+class OrderChannel : public QObject {
+    Q_OBJECT
+
+public:
+    enum Stage {
+        Dns,       // the channel's own lookups, which keep Qt's host cache warm
+        Handshake, // TCP connect + TLS; only requests that had to open a connection
+        Request,   // send() -> request written, handshake included (Qt 6.3+)
+        FirstByte, // request written (send() before Qt 6.3) -> response headers
+        Total,     // send() -> reply finished
+        StageCount
+    };
+
+    // One finished request in microseconds; -1 for stages it did not go through.
+    struct Timing {
+        std::array<qint64, StageCount> us{};
+        bool reused = true; // went out on a connection that was already open
+    };
+
+    // `pingPath` is a cheap unauthenticated GET on `baseUrl`'s host.
+    OrderChannel(const QUrl &baseUrl, const QString &pingPath, QObject *parent = nullptr);
+
+    void start();
+    // Closes the pooled connections; start() opens them again.
+    void stop();
+
+    // Sends `request` (a URL on the channel's host) with `verb`, timing it. The
+    // channel's handlers run before any the caller connects to the reply.
+    QNetworkReply *send(QNetworkRequest request, const QByteArray &verb, const QByteArray &body = QByteArray());
+
+    // p50/p90/p99/max per stage over every order request so far, plus how many
+    // of them found the connection already open.
+    QString report() const;
+
+signals:
+    void requestTimed(const QString &path, const OrderChannel::Timing &timing);
+
+private:
+    static constexpr int kPingIntervalMs = 20000;
+
+    void lookupHost(bool thenConnect);
+    void ping();
+    QNetworkReply *dispatch(QNetworkRequest &request, const QByteArray &verb, const QByteArray &body);
+
+    QUrl m_baseUrl;
+    QString m_pingPath;
+    QNetworkAccessManager m_network;
+    QSslConfiguration m_ssl;
+    QTimer m_pingTimer;
+    QElapsedTimer m_sinceUse; // since the last order request
+    std::array<LatencyHistogram, StageCount> m_stages;
+    quint64 m_requests = 0;
+    quint64 m_reused = 0;
+    quint64 m_pings = 0;
+};
@@ -5,13 +5,13 @@
 #include <QPainter>
 #include <QPaintEvent>
 #include <QTimerEvent>
+#include <QWheelEvent>
 #include <QtGlobal>
 #include <QDebug>
 #include <QDateTime>
 
 #include <algorithm>
 #include <cmath>
-#include <limits>
 
 namespace {
 QString formatQty(double v)
@@ -27,101 +27,116 @@ PrintsWidget::PrintsWidget(QWidget *parent)
     : QWidget(parent)
 {
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    m_ring.resize(kCapacity);
 }
 
-void PrintsWidget::setPrints(const QVector<PrintItem> &items)
+void PrintsWidget::appendPrints(const QVector<PrintItem> &batch)
 {
-    // Keep rowHint as provided by LadderClient; also use it to calibrate offset vs price rows.
-    m_items = items;
-    for (const auto &it : m_items) {
-        if (it.rowHint >= 0) {
-            const int priceRow = rowForPrice(it.price);
-            if (priceRow >= 0) {
-                calibrateRowOffset(it.rowHint, priceRow);
-            }
-        }
+    if (batch.isEmpty()) {
+        return;
     }
-
-    QHash<QString, double> nextProgress;
-    nextProgress.reserve(items.size());
-    bool hasNew = false;
-    for (const auto &it : m_items) {
-        const QString key = makeKey(it);
-        if (m_spawnProgress.contains(key)) {
-            nextProgress.insert(key, m_spawnProgress.value(key));
+    // Anything older than the last kCapacity would be overwritten right away.
+    const int size = static_cast<int>(batch.size());
+    for (int i = std::max(0, size - kCapacity); i < size; ++i) {
+        PrintSlot *slot = nullptr;
+        if (m_count < kCapacity) {
+            slot = &m_ring[(m_head + m_count) % kCapacity];
+            ++m_count;
         } else {
-            nextProgress.insert(key, 0.0);
-            hasNew = true;
+            slot = &m_ring[m_head];
+            m_head = (m_head + 1) % kCapacity;
         }
+        slot->item = batch[i];
+        slot->id = m_nextId++;
+        slot->spawn = 0.0;
     }
-    m_spawnProgress = nextProgress;
-    bool needTimer = false;
-    for (auto it = m_spawnProgress.cbegin(); it != m_spawnProgress.cend(); ++it) {
-        if (it.value() < 0.999) {
-            needTimer = true;
-            break;
-        }
+    if (!m_framePaced && !m_animTimer.isActive()) {
+        m_animTimer.start(16, this);
     }
-    if (needTimer) {
-        if (!m_animTimer.isActive()) {
-            m_animTimer.start(16, this);
-        }
-    } else {
+    update();
+}
+
+void PrintsWidget::clearPrints()
+{
+    m_head = 0;
+    m_count = 0;
+    m_animFromId = m_nextId;
+    m_animTimer.stop();
+    update();
+}
+
+PrintsWidget::PrintSlot &PrintsWidget::slotForId(quint64 id)
+{
+    const quint64 oldestId = m_nextId - static_cast<quint64>(m_count);
+    return m_ring[(m_head + static_cast<int>(id - oldestId)) % kCapacity];
+}
+
+void PrintsWidget::setFramePaced(bool paced)
+{
+    m_framePaced = paced;
+    if (m_framePaced) {
         m_animTimer.stop();
     }
-    update();
 }
 
-void PrintsWidget::setLadderPrices(const QVector<double> &prices, int rowHeight, double tickSize)
+bool PrintsWidget::advanceAnimation()
 {
-    const bool resetMapping = m_prices.isEmpty() || prices.isEmpty();
-    m_prices = prices;
-    m_priceToRow.clear();
-    m_priceToRow.reserve(m_prices.size());
-    for (int i = 0; i < m_prices.size(); ++i) {
-        m_priceToRow.insert(m_prices[i], i);
+    // Prints overwritten before they settled no longer count.
+    m_animFromId = std::max(m_animFromId, m_nextId - static_cast<quint64>(m_count));
+    if (m_animFromId == m_nextId) {
+        return false;
     }
-    m_firstPrice = m_prices.isEmpty() ? 0.0 : m_prices.first();
-    m_descending = m_prices.size() < 2 ? true : (m_prices.first() > m_prices.last());
-    if (tickSize > 0.0) {
-        m_tickSize = tickSize;
-    } else {
-        m_tickSize = 0.0;
-        for (int i = 1; i < m_prices.size(); ++i) {
-            const double diff = std::abs(m_prices[i - 1] - m_prices[i]);
-            if (diff > 1e-9) {
-                m_tickSize = diff;
-                break;
+    for (quint64 id = m_animFromId; id < m_nextId; ++id) {
+        PrintSlot &slot = slotForId(id);
+        slot.spawn += (1.0 - slot.spawn) * 0.3;
+        if (slot.spawn > 0.999) {
+            slot.spawn = 1.0;
+            if (id == m_animFromId) {
+                ++m_animFromId;
             }
         }
     }
+    update();
+    return m_animFromId != m_nextId;
+}
+
+void PrintsWidget::setLadderWindow(const LadderWindow &window, int rowHeight)
+{
+    m_window = window.isValid() ? window : LadderWindow();
     m_rowHeight = std::max(10, std::min(rowHeight, 40));
 
-    const int totalHeight = m_prices.size() * m_rowHeight + kDomInfoAreaHeight;
-    if (resetMapping) {
-        m_rowOffset = 0;
-        m_rowOffsetValid = false;
-    }
-    if (m_hoverRow >= m_prices.size()) {
+    if (m_hoverRow >= m_window.rows) {
         m_hoverRow = -1;
         m_hoverText.clear();
     }
-    setMinimumHeight(totalHeight);
-    setMaximumHeight(totalHeight);
-    updateGeometry();
     update();
 }
 
 void PrintsWidget::setRowHeightOnly(int rowHeight)
 {
     m_rowHeight = std::max(10, std::min(rowHeight, 40));
-    const int totalHeight = m_prices.size() * m_rowHeight + kDomInfoAreaHeight;
-    setMinimumHeight(totalHeight);
-    setMaximumHeight(totalHeight);
-    updateGeometry();
     update();
 }
 
+void PrintsWidget::setTopRow(int row)
+{
+    if (row != m_topRow) {
+        m_topRow = row;
+        update();
+    }
+}
+
+void PrintsWidget::wheelEvent(QWheelEvent *event)
+{
+    m_wheelRemainder += event->angleDelta().y();
+    const int notches = m_wheelRemainder / 120;
+    m_wheelRemainder -= notches * 120;
+    if (notches != 0) {
+        emit scrollRequested(-notches * 3);
+    }
+    event->accept();
+}
+
 void PrintsWidget::setLocalOrders(const QVector<LocalOrderMarker> &orders)
 {
     m_orderMarkers = orders;
@@ -130,18 +145,11 @@ void PrintsWidget::setLocalOrders(const QVector<LocalOrderMarker> &orders)
 
 void PrintsWidget::setHoverInfo(int row, double price, const QString &text)
 {
-    const int rowCount = m_prices.size();
+    // DomWidget rows and ours come from the same window, so the row is used as is.
+    const int rowCount = m_window.rows;
     const bool domRowValid = (row >= 0 && row < rowCount);
-    int resolvedRow = -1;
     const bool priceValid = (rowCount > 0) && std::isfinite(price);
-    int priceRow = -1;
-    if (priceValid) {
-        priceRow = rowForPrice(price);
-    }
-    if (domRowValid && priceValid && priceRow >= 0) {
-        calibrateRowOffset(row, priceRow);
-    }
-    resolvedRow = domRowValid ? row : applyRowOffset(priceRow);
+    const int resolvedRow = domRowValid ? row : (priceValid ? rowForPrice(price) : -1);
     QString newText = resolvedRow >= 0 ? text : QString();
     if (m_hoverRow == resolvedRow && m_hoverText == newText && m_hoverPriceValid == priceValid) {
         if (!priceValid || qFuzzyCompare(m_hoverPrice, price)) {
@@ -163,7 +171,7 @@ void PrintsWidget::paintEvent(QPaintEvent *event)
 
     p.fillRect(rect(), QColor("#151515"));
 
-    if (m_prices.isEmpty()) {
+    if (!m_window.isValid()) {
         return;
     }
 
@@ -175,10 +183,14 @@ void PrintsWidget::paintEvent(QPaintEvent *event)
                                                                               : fm.height());
     const int w = width();
 
+    // Rows are laid out in ladder coordinates; the view starts at the ladder's top row.
+    p.translate(0, -m_topRow * m_rowHeight);
+
     // Horizontal grid lines to match ladder rows.
     p.setPen(QColor("#303030"));
-    const int rows = m_prices.size();
-    for (int i = 0; i <= rows; ++i) {
+    const int rows = m_window.rows;
+    const int lastGridRow = std::min(rows, m_topRow + height() / m_rowHeight + 1);
+    for (int i = m_topRow; i <= lastGridRow; ++i) {
         const int y = i * m_rowHeight;
         p.drawLine(0, y, w, y);
     }
@@ -190,17 +202,11 @@ void PrintsWidget::paintEvent(QPaintEvent *event)
         hoverRowRect = QRect(0, m_hoverRow * m_rowHeight, w, m_rowHeight);
     }
 
-    const int count = m_items.size();
+    const int count = m_count;
 
-    // Map a print to the y coordinate: prefer its rowHint, else fallback to nearest price.
+    // Map a print to the y coordinate of its price's row in the current window.
     auto itemToY = [&](const PrintItem &item, int *outRowIdx = nullptr) -> int {
-        int rowIdx = item.rowHint;
-        if (rowIdx < 0 || rowIdx >= m_prices.size()) {
-            rowIdx = rowForPrice(item.price);
-        }
-        if (rowIdx >= 0) {
-            rowIdx = applyRowOffset(rowIdx);
-        }
+        const int rowIdx = rowForPrice(item.price);
         if (outRowIdx) {
             *outRowIdx = rowIdx;
         }
@@ -224,23 +230,22 @@ void PrintsWidget::paintEvent(QPaintEvent *event)
     for (int i = startIdx + 1; i < count; ++i) {
         int rowIdx1 = -1;
         int rowIdx2 = -1;
-        const int y1 = itemToY(m_items[i - 1], &rowIdx1);
-        const int y2 = itemToY(m_items[i], &rowIdx2);
+        const int y1 = itemToY(printAt(i - 1).item, &rowIdx1);
+        const int y2 = itemToY(printAt(i).item, &rowIdx2);
         const double x1 = padding + (i - 1 - startIdx) * slotW + slotW * 0.5;
         const double x2 = padding + (i - startIdx) * slotW + slotW * 0.5;
         p.drawLine(QPointF(x1, y1), QPointF(x2, y2));
     }
 
     for (int i = startIdx; i < count; ++i) {
-        const PrintItem &it = m_items[i];
+        const PrintSlot &slot = printAt(i);
+        const PrintItem &it = slot.item;
         int rowIdx = -1;
         const int y = itemToY(it, &rowIdx);
         const double xCenter = padding + (i - startIdx) * slotW + slotW * 0.5;
 
         const double magnitude = std::log10(1.0 + std::abs(it.qty));
-        const QString key = makeKey(it);
-        double spawn = m_spawnProgress.value(key, 1.0);
-        spawn = std::clamp(spawn, 0.0, 1.0);
+        const double spawn = std::clamp(slot.spawn, 0.0, 1.0);
         const double eased = 1.0 - std::pow(1.0 - spawn, 3.0);
 
         const int baseRadius = std::max(10, std::min(18, 9 + static_cast<int>(std::round(magnitude * 5.0))));
@@ -248,6 +253,10 @@ void PrintsWidget::paintEvent(QPaintEvent *event)
         QRect circleRect(static_cast<int>(xCenter - animatedRadius), y - animatedRadius, animatedRadius * 2, animatedRadius * 2);
         QColor c = it.buy ? QColor("#4caf50") : QColor("#e53935");
         c.setAlpha(static_cast<int>(210 * (0.7 + 0.3 * eased)));
+        if (it.outsideWindow) {
+            // Traded beyond the ladder: parked on the edge row, drawn faint.
+            c.setAlpha(c.alpha() / 3);
+        }
         p.setBrush(c);
         QColor border = it.buy ? QColor("#2f6c37") : QColor("#992626");
         p.setPen(QPen(border, 2));
@@ -289,10 +298,7 @@ void PrintsWidget::paintEvent(QPaintEvent *event)
         };
         QHash<quint64, Agg> agg;
         for (const auto &ord : m_orderMarkers) {
-            int rowIdx = rowForPrice(ord.price);
-            if (rowIdx >= 0) {
-                rowIdx = applyRowOffset(rowIdx);
-            }
+            const int rowIdx = rowForPrice(ord.price);
             if (rowIdx < 0 || rowIdx >= rows) {
                 continue;
             }
@@ -386,98 +392,26 @@ void PrintsWidget::paintEvent(QPaintEvent *event)
 void PrintsWidget::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_animTimer.timerId()) {
-        bool any = false;
-        for (auto it = m_spawnProgress.begin(); it != m_spawnProgress.end(); ++it) {
-            double value = it.value();
-            if (value < 0.999) {
-                value += (1.0 - value) * 0.3;
-                if (value > 0.999) {
-                    value = 1.0;
-                } else {
-                    any = true;
-                }
-                it.value() = value;
-            }
-        }
-        if (!any) {
+        if (!advanceAnimation()) {
             m_animTimer.stop();
         }
-        update();
         return;
     }
     QWidget::timerEvent(event);
 }
 
-QString PrintsWidget::makeKey(const PrintItem &item) const
-{
-    return QStringLiteral("%1_%2_%3")
-        .arg(item.price, 0, 'f', 5)
-        .arg(item.qty, 0, 'f', 3)
-        .arg(item.buy ? QLatin1Char('B') : QLatin1Char('S'));
-}
-
 int PrintsWidget::rowForPrice(double price) const
 {
-    if (m_prices.isEmpty()) {
+    if (!m_window.isValid()) {
         return -1;
     }
-    // First try exact match; DOM and prints share the same ladder values.
-    auto it = m_priceToRow.constFind(price);
-    if (it != m_priceToRow.constEnd()) {
-        return it.value();
-    }
-
-    // If ladder is sorted descending (high -> low), use tickSize to snap index.
-    if (m_tickSize > 0.0 && m_prices.size() > 1) {
-        const bool descending = m_prices.first() > m_prices.last();
-        double delta = descending ? (m_prices.first() - price) / m_tickSize
-                                  : (price - m_prices.first()) / m_tickSize;
-        const int idx = static_cast<int>(std::llround(delta));
-        if (idx >= 0 && idx < m_prices.size()) {
-            return idx;
-        }
-    }
-
-    int bestIdx = 0;
-    double bestDist = std::numeric_limits<double>::max();
-    for (int i = 0; i < m_prices.size(); ++i) {
-        const double d = std::abs(m_prices[i] - price);
-        if (d < bestDist) {
-            bestDist = d;
-            bestIdx = i;
-        }
-    }
-    return bestIdx;
-}
-
-int PrintsWidget::applyRowOffset(int row) const
-{
-    if (row < 0 || m_prices.isEmpty()) {
+    // Exact inside the window; prices beyond it stay on the edge row nearest to them.
+    const qint64 tick = m_window.tickForPrice(price);
+    const int row = m_window.rowForTick(tick);
+    if (row >= 0) {
         return row;
     }
-    const int maxRow = static_cast<int>(m_prices.size()) - 1;
-    int adjusted = row;
-    if (m_rowOffsetValid) {
-        adjusted += m_rowOffset;
-    }
-    adjusted = std::clamp<int>(adjusted, 0, maxRow);
-    return adjusted;
-}
-
-void PrintsWidget::calibrateRowOffset(int domRow, int priceRow)
-{
-    if (domRow < 0 || priceRow < 0) {
-        return;
-    }
-    const int diff = domRow - priceRow;
-    const int maxOffset = std::max<int>(4, static_cast<int>(m_prices.size()) / 5);
-    if (std::abs(diff) > maxOffset) {
-        return;
-    }
-    if (!m_rowOffsetValid || diff != m_rowOffset) {
-        m_rowOffset = diff;
-        m_rowOffsetValid = true;
-    }
+    return tick > m_window.topTick ? 0 : m_window.rows - 1;
 }
 
 QSize PrintsWidget::sizeHint() const
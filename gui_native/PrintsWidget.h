@@ -5,12 +5,13 @@
 #include <QColor>
 #include <QHash>
 #include <QBasicTimer>
+#include "DomTypes.h"
 
 struct PrintItem {
     double price = 0.0;
     double qty = 0.0;
     bool buy = true;
-    int rowHint = -1;
+    bool outsideWindow = false; // traded beyond the ladder window shown at the time
 };
 
 struct LocalOrderMarker {
@@ -25,42 +26,68 @@ class PrintsWidget : public QWidget {
 public:
     explicit PrintsWidget(QWidget *parent = nullptr);
 
-    void setPrints(const QVector<PrintItem> &items);
-    void setLadderPrices(const QVector<double> &prices, int rowHeight, double tickSize);
+    // Newest prints, oldest first. Each gets the next print id and starts its spawn
+    // animation; beyond kCapacity the oldest prints are overwritten.
+    void appendPrints(const QVector<PrintItem> &batch);
+    void clearPrints();
+    // Rows follow `window`, the one DomWidget paints, row for row.
+    void setLadderWindow(const LadderWindow &window, int rowHeight);
     void setRowHeightOnly(int rowHeight);
     void setLocalOrders(const QVector<LocalOrderMarker> &orders);
+    // Paced: a RenderScheduler calls advanceAnimation() once per display refresh
+    // instead of the widget running its own 16 ms timer.
+    void setFramePaced(bool paced);
+    // One step of the spawn animation; false once every print has settled.
+    bool advanceAnimation();
 
 public slots:
     void setHoverInfo(int row, double price, const QString &text);
+    // Ladder row drawn at the top; follows DomWidget::viewportChanged.
+    void setTopRow(int row);
+
+signals:
+    // Wheel over the prints scrolls the ladder next to them.
+    void scrollRequested(int rows);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
     void timerEvent(QTimerEvent *event) override;
     QSize sizeHint() const override;
     QSize minimumSizeHint() const override;
 
 private:
-    QString makeKey(const PrintItem &item) const;
+    // One ring slot: a print, its id and how far its spawn animation got (0..1).
+    struct PrintSlot {
+        PrintItem item;
+        quint64 id = 0;
+        double spawn = 1.0;
+    };
+
+    static constexpr int kCapacity = 200;
+
     int rowForPrice(double price) const;
-    int applyRowOffset(int row) const;
-    void calibrateRowOffset(int domRow, int priceRow);
+    // i-th retained print, 0 being the oldest.
+    const PrintSlot &printAt(int i) const { return m_ring[(m_head + i) % kCapacity]; }
+    PrintSlot &slotForId(quint64 id);
 
-    QVector<PrintItem> m_items;
-    QVector<double> m_prices;
-    QHash<double, int> m_priceToRow;
+    // Fixed kCapacity slots; m_count prints starting at m_head, ids consecutive.
+    QVector<PrintSlot> m_ring;
+    int m_head = 0;
+    int m_count = 0;
+    quint64 m_nextId = 1;
+    // Prints settle in the order they arrived, so the animating ones are always
+    // the newest: ids [m_animFromId, m_nextId).
+    quint64 m_animFromId = 1;
+    LadderWindow m_window;
     int m_rowHeight = 20;
-    QHash<QString, double> m_spawnProgress;
+    int m_topRow = 0;
+    int m_wheelRemainder = 0;
     QBasicTimer m_animTimer;
+    bool m_framePaced = false;
     int m_hoverRow = -1;
     double m_hoverPrice = 0.0;
     bool m_hoverPriceValid = false;
     QString m_hoverText;
-    double m_tickSize = 0.0;
-    bool m_descending = true;
-    double m_firstPrice = 0.0;
-    int m_rowOffset = 0;
-    bool m_rowOffsetValid = false;
-    // Keep prints widget height aligned with DomWidget (which has an extra info area at the bottom).
-    static constexpr int kDomInfoAreaHeight = 26;
     QVector<LocalOrderMarker> m_orderMarkers;
 };
@@ -0,0 +1,339 @@
+// Offscreen paint benchmark for DomWidget and PrintsWidget (target shah_render_bench).
+//
+// Feeds synthetic ladders and trades through the widgets' public API and renders
+// every frame into a QImage, so paint cost can be compared on a headless box:
+//     QT_QPA_PLATFORM=offscreen ./shah_render_bench --dpr 2
+
+#include "DomWidget.h"
+#include "PrintsWidget.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QVector>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace {
+std::uint64_t allocationCount = 0; // the GUI thread is the only one that paints
+
+void *countedAlloc(std::size_t size)
+{
+    ++allocationCount;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+// Counting replacements for the global allocation functions, as in the backend's
+// --bench. Qt's own threads count too, but stay idle while a frame is rendered.
+void *operator new(std::size_t size)
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+constexpr double kTick = 0.01;
+constexpr QSize kDomSize(260, 1000);
+constexpr QSize kPrintsSize(140, 1000);
+
+struct Scenario {
+    const char *name;
+    int levelsPerSide;
+    double churn;    // share of rows whose quantity changes each frame
+    bool shift;      // the mid price walks, so the window moves
+    int volumeRules;
+    int localOrders;
+    int tradesPerFrame;
+};
+
+const Scenario kScenarios[] = {
+    {"steady-120", 120, 0.02, false, 0, 0, 1},
+    {"steady-500", 500, 0.02, false, 0, 0, 1},
+    {"steady-2000", 2000, 0.02, false, 0, 0, 1},
+    {"churn-120", 120, 0.5, true, 0, 0, 4},
+    {"churn-500", 500, 0.5, true, 0, 0, 4},
+    {"churn-2000", 2000, 0.5, true, 0, 0, 4},
+    {"rules-500", 500, 0.2, false, 12, 0, 2},
+    {"orders-500", 500, 0.2, false, 0, 200, 2},
+};
+
+// Builds the ladders the decoder would: one contiguous row per tick, best bid and
+// ask at the middle.
+class SyntheticBook {
+public:
+    SyntheticBook(const Scenario &scenario, quint32 seed)
+        : m_scenario(scenario)
+        , m_rng(seed)
+    {
+        m_qty.resize(scenario.levelsPerSide * 2);
+        for (double &q : m_qty) {
+            q = m_size(m_rng);
+        }
+    }
+
+    qint64 midTick() const { return m_midTick; }
+
+    DomSnapshotPtr next()
+    {
+        const int rows = static_cast<int>(m_qty.size());
+        std::uniform_int_distribution<int> row(0, rows - 1);
+        const int changes = std::max(1, static_cast<int>(rows * m_scenario.churn));
+        for (int i = 0; i < changes; ++i) {
+            m_qty[row(m_rng)] = m_size(m_rng);
+        }
+        if (m_scenario.shift) {
+            m_midTick += std::uniform_int_distribution<int>(-1, 1)(m_rng);
+        }
+
+        auto snap = QSharedPointer<DomSnapshot>::create();
+        const qint64 topTick = m_midTick + m_scenario.levelsPerSide;
+        snap->levels.reserve(rows);
+        for (int i = 0; i < rows; ++i) {
+            DomLevel level;
+            level.price = static_cast<double>(topTick - i) * kTick;
+            if (i < m_scenario.levelsPerSide) {
+                level.askQty = m_qty[i];
+            } else {
+                level.bidQty = m_qty[i];
+            }
+            snap->levels.push_back(level);
+        }
+        snap->tickSize = kTick;
+        snap->bestAsk = static_cast<double>(m_midTick + 1) * kTick;
+        snap->bestBid = static_cast<double>(m_midTick) * kTick;
+        snap->window = LadderWindow::fromRange(snap->levels.first().price, snap->levels.last().price, rows, kTick, 1);
+        return snap;
+    }
+
+    QVector<PrintItem> trades()
+    {
+        QVector<PrintItem> out;
+        std::uniform_int_distribution<int> side(0, 1);
+        for (int i = 0; i < m_scenario.tradesPerFrame; ++i) {
+            PrintItem item;
+            item.buy = side(m_rng) == 1;
+            item.price = static_cast<double>(m_midTick + (item.buy ? 1 : 0)) * kTick;
+            item.qty = item.price * m_size(m_rng);
+            out.push_back(item);
+        }
+        return out;
+    }
+
+private:
+    const Scenario &m_scenario;
+    std::mt19937 m_rng;
+    std::uniform_real_distribution<double> m_size{0.01, 2500.0};
+    QVector<double> m_qty;
+    qint64 m_midTick = 10000; // 100.00
+};
+
+struct Samples {
+    std::vector<qint64> ns;
+    std::uint64_t allocations = 0;
+
+    qint64 percentile(double p)
+    {
+        if (ns.empty()) {
+            return 0;
+        }
+        const auto rank = static_cast<std::size_t>(p * static_cast<double>(ns.size() - 1));
+        std::nth_element(ns.begin(), ns.begin() + static_cast<std::ptrdiff_t>(rank), ns.end());
+        return ns[rank];
+    }
+
+    double allocationsPerFrame() const
+    {
+        return ns.empty() ? 0.0 : static_cast<double>(allocations) / static_cast<double>(ns.size());
+    }
+};
+
+// Renders the whole widget, as a full repaint would, and records time and allocations.
+void renderFrame(QWidget &widget, QImage &target, Samples &samples)
+{
+    target.fill(Qt::transparent);
+    const std::uint64_t allocsBefore = allocationCount;
+    QElapsedTimer timer;
+    timer.start();
+    widget.render(&target);
+    samples.ns.push_back(timer.nsecsElapsed());
+    samples.allocations += allocationCount - allocsBefore;
+}
+
+QImage frameImage(const QSize &size, double dpr)
+{
+    QImage image(size * dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    return image;
+}
+
+QJsonObject runScenario(const Scenario &scenario, int frames, double dpr)
+{
+    SyntheticBook book(scenario, 12345);
+
+    DomWidget dom;
+    dom.resize(kDomSize);
+    PrintsWidget prints;
+    prints.resize(kPrintsSize);
+    prints.setFramePaced(true); // stepped below, as RenderScheduler does
+
+    if (scenario.volumeRules > 0) {
+        QVector<VolumeHighlightRule> rules;
+        for (int i = 0; i < scenario.volumeRules; ++i) {
+            VolumeHighlightRule rule;
+            rule.threshold = 1000.0 * (i + 1) * (i + 1);
+            rule.color = QColor::fromHsv((i * 29) % 360, 160, 220);
+            rules.push_back(rule);
+        }
+        dom.setVolumeHighlightRules(rules);
+    }
+    if (scenario.localOrders > 0) {
+        QVector<DomWidget::LocalOrderMarker> domOrders;
+        QVector<LocalOrderMarker> printOrders;
+        for (int i = 0; i < scenario.localOrders; ++i) {
+            const bool buy = (i % 2) == 0;
+            const qint64 tick = book.midTick() + (buy ? -(i / 2) : 1 + i / 2);
+            DomWidget::LocalOrderMarker order;
+            order.price = static_cast<double>(tick) * kTick;
+            order.quantity = 50.0 + i;
+            order.side = buy ? OrderSide::Buy : OrderSide::Sell;
+            order.orderId = QString::number(i);
+            domOrders.push_back(order);
+            LocalOrderMarker marker;
+            marker.price = order.price;
+            marker.quantity = order.quantity;
+            marker.buy = buy;
+            printOrders.push_back(marker);
+        }
+        dom.setLocalOrders(domOrders);
+        prints.setLocalOrders(printOrders);
+    }
+    dom.setInitialCenterPrice(static_cast<double>(book.midTick()) * kTick);
+    QObject::connect(&dom, &DomWidget::viewportChanged, &prints, &PrintsWidget::setTopRow);
+
+    QImage domImage = frameImage(kDomSize, dpr);
+    QImage printsImage = frameImage(kPrintsSize, dpr);
+    Samples domSamples;
+    Samples printsSamples;
+    domSamples.ns.reserve(frames);
+    printsSamples.ns.reserve(frames);
+
+    // A few untimed frames build the label caches and the chrome layer.
+    const int warmup = std::min(frames, 30);
+    for (int frame = -warmup; frame < frames; ++frame) {
+        const DomSnapshotPtr snap = book.next();
+        dom.updateSnapshot(snap);
+        prints.setLadderWindow(snap->window, dom.rowHeight());
+        prints.appendPrints(book.trades());
+        prints.advanceAnimation();
+        if (frame < 0) {
+            dom.render(&domImage);
+            prints.render(&printsImage);
+            continue;
+        }
+        renderFrame(dom, domImage, domSamples);
+        renderFrame(prints, printsImage, printsSamples);
+    }
+
+    std::fprintf(stderr, "%-12s %5d %9.1f %9.1f %9.1f %10.1f %9.1f %9.1f %9.1f %10.1f\n",
+                 scenario.name, scenario.levelsPerSide,
+                 domSamples.percentile(0.50) / 1000.0, domSamples.percentile(0.99) / 1000.0,
+                 domSamples.percentile(1.0) / 1000.0, domSamples.allocationsPerFrame(),
+                 printsSamples.percentile(0.50) / 1000.0, printsSamples.percentile(0.99) / 1000.0,
+                 printsSamples.percentile(1.0) / 1000.0, printsSamples.allocationsPerFrame());
+
+    auto stats = [](Samples &s) {
+        return QJsonObject{{QStringLiteral("p50Us"), s.percentile(0.50) / 1000.0},
+                           {QStringLiteral("p99Us"), s.percentile(0.99) / 1000.0},
+                           {QStringLiteral("maxUs"), s.percentile(1.0) / 1000.0},
+                           {QStringLiteral("allocsPerFrame"), s.allocationsPerFrame()}};
+    };
+    return QJsonObject{{QStringLiteral("type"), QStringLiteral("render_bench")},
+                       {QStringLiteral("scenario"), QString::fromLatin1(scenario.name)},
+                       {QStringLiteral("levelsPerSide"), scenario.levelsPerSide},
+                       {QStringLiteral("frames"), frames},
+                       {QStringLiteral("dpr"), dpr},
+                       {QStringLiteral("dom"), stats(domSamples)},
+                       {QStringLiteral("prints"), stats(printsSamples)}};
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // The DPR has to be chosen before QApplication exists; the widgets read it
+    // from their screen, exactly as on a HiDPI monitor.
+    double dpr = 1.0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (qstrcmp(argv[i], "--dpr") == 0) {
+            dpr = std::clamp(std::atof(argv[i + 1]), 1.0, 4.0);
+        }
+    }
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    qputenv("QT_SCALE_FACTOR", QByteArray::number(dpr));
+
+    QApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Offscreen DomWidget/PrintsWidget paint benchmark"));
+    parser.addHelpOption();
+    parser.addOption({QStringLiteral("frames"), QStringLiteral("Timed frames per scenario."), QStringLiteral("n"),
+                      QStringLiteral("600")});
+    parser.addOption({QStringLiteral("dpr"), QStringLiteral("Device pixel ratio (1-4)."), QStringLiteral("ratio"),
+                      QStringLiteral("1")});
+    parser.addOption({QStringLiteral("scenario"), QStringLiteral("Run only scenarios whose name contains this."),
+                      QStringLiteral("name")});
+    parser.process(app);
+
+    const int frames = std::max(1, parser.value(QStringLiteral("frames")).toInt());
+    const QString filter = parser.value(QStringLiteral("scenario"));
+
+    std::fprintf(stderr, "%-12s %5s %9s %9s %9s %10s %9s %9s %9s %10s\n", "scenario", "lvls", "dom p50",
+                 "dom p99", "dom max", "dom alloc", "prt p50", "prt p99", "prt max", "prt alloc");
+    for (const Scenario &scenario : kScenarios) {
+        if (!filter.isEmpty() && !QString::fromLatin1(scenario.name).contains(filter)) {
+            continue;
+        }
+        const QJsonObject result = runScenario(scenario, frames, dpr);
+        std::printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+    }
+    std::fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "RenderScheduler.h"
+
+#include <QApplication>
+#include <QCursor>
+#include <QScreen>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+RenderScheduler::RenderScheduler(QWidget *window)
+    : QObject(window)
+    , m_window(window)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &RenderScheduler::tick);
+    m_clock.start();
+}
+
+int RenderScheduler::addColumn(QWidget *column, std::function<void()> apply, std::function<bool()> animate)
+{
+    const int id = m_nextId++;
+    Column entry;
+    entry.widget = column;
+    entry.apply = std::move(apply);
+    entry.animate = std::move(animate);
+    m_columns.insert(id, std::move(entry));
+    return id;
+}
+
+void RenderScheduler::removeColumn(int id)
+{
+    m_columns.remove(id);
+}
+
+void RenderScheduler::requestFrame(int id)
+{
+    auto it = m_columns.find(id);
+    if (it == m_columns.end()) {
+        return;
+    }
+    if (!it->pending) {
+        it->pending = true;
+        it->pendingSinceMs = m_clock.elapsed();
+    }
+    ensureRunning();
+}
+
+void RenderScheduler::recordPaint(int id, double paintMs)
+{
+    auto it = m_columns.find(id);
+    if (it == m_columns.end() || paintMs <= 0.0) {
+        return;
+    }
+    const double cost = it->applyMs + paintMs;
+    it->costMs = it->costMs > 0.0 ? it->costMs * 0.8 + cost * 0.2 : cost;
+    it->applyMs = 0.0;
+}
+
+void RenderScheduler::ensureRunning()
+{
+    if (m_timer.isActive()) {
+        return;
+    }
+    // Follow the screen the window is on; 60 Hz when it does not say.
+    const QScreen *screen = m_window ? m_window->screen() : QGuiApplication::primaryScreen();
+    const double hz = screen && screen->refreshRate() > 1.0 ? screen->refreshRate() : 60.0;
+    m_timer.start(std::max(4, static_cast<int>(std::lround(1000.0 / hz))));
+}
+
+RenderScheduler::Priority RenderScheduler::priorityOf(const Column &column, QWidget *focus) const
+{
+    QWidget *widget = column.widget.data();
+    if (!widget || !widget->isVisible() || widget->window()->isMinimized()) {
+        return Hidden;
+    }
+    if (focus && (widget == focus || widget->isAncestorOf(focus))) {
+        return Focused;
+    }
+    if (widget->rect().contains(widget->mapFromGlobal(QCursor::pos()))) {
+        return Hovered;
+    }
+    return Visible;
+}
+
+void RenderScheduler::tick()
+{
+    struct Due {
+        int id;
+        Priority priority;
+    };
+    QVector<Due> due;
+    QWidget *focus = QApplication::focusWidget();
+    for (auto it = m_columns.begin(); it != m_columns.end(); ++it) {
+        if (it->pending || it->animating) {
+            due.push_back({it.key(), priorityOf(*it, focus)});
+        }
+    }
+    if (due.isEmpty()) {
+        m_timer.stop();
+        return;
+    }
+    std::stable_sort(due.begin(), due.end(), [](const Due &a, const Due &b) { return a.priority > b.priority; });
+
+    const double budgetMs = m_timer.interval() * kBudgetShare;
+    const qint64 nowMs = m_clock.elapsed();
+    double spentMs = 0.0;
+    for (const Due &d : due) {
+        // apply() can end up removing columns (a restart from inside a status handler).
+        auto it = m_columns.find(d.id);
+        if (it == m_columns.end()) {
+            continue;
+        }
+        if (it->pending) {
+            const double estimateMs = it->costMs;
+            const bool overBudget = spentMs + estimateMs > budgetMs;
+            if (d.priority < Hovered && overBudget && nowMs - it->pendingSinceMs < kMaxDeferMs) {
+                ++m_deferred;
+                continue;
+            }
+            it->pending = false;
+            QElapsedTimer applyTimer;
+            applyTimer.start();
+            const auto apply = it->apply;
+            apply();
+            const double applyMs = static_cast<double>(applyTimer.nsecsElapsed()) / 1.0e6;
+            ++m_applied;
+            spentMs += std::max(applyMs, estimateMs);
+            it = m_columns.find(d.id);
+            if (it == m_columns.end()) {
+                continue;
+            }
+            it->applyMs = applyMs;
+            // New prints may have started an animation.
+            it->animating = static_cast<bool>(it->animate);
+        }
+        if (it->animating) {
+            // Hidden columns step too (their update() paints nothing), so they do
+            // not come back with half-grown prints.
+            it->animating = it->animate();
+        }
+    }
+}
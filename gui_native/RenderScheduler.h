@@ -0,0 +1,74 @@
+// Paces ladder repaints across every column of the main window.
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+
+#include <functional>
+
+// Backends only mark a column as having a frame waiting. Once per display refresh
+// the scheduler hands each such column its newest frame (older ones never reach a
+// widget) and steps running print animations. The focused column goes first, then
+// the one under the mouse, then the rest on screen, then hidden ones. Columns
+// below the hovered one are deferred to the next refresh once the estimated cost
+// of this one passes the budget, but never for longer than kMaxDeferMs.
+class RenderScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RenderScheduler(QWidget *window);
+
+    // `column` is the column's container (for focus, hover and visibility). `apply`
+    // takes and shows the newest frame; `animate` advances animations one step and
+    // returns false once nothing moves any more. Returns the id for the calls below.
+    int addColumn(QWidget *column, std::function<void()> apply, std::function<bool()> animate = {});
+    void removeColumn(int id);
+
+    // A new frame is waiting for the column; it is applied on the next refresh.
+    void requestFrame(int id);
+    // Paint time of the frame the column last applied, for its cost estimate.
+    void recordPaint(int id, double paintMs);
+
+    // Frames applied and deferrals for the budget so far (the latency dump logs them).
+    quint64 appliedFrames() const { return m_applied; }
+    quint64 deferredFrames() const { return m_deferred; }
+
+private:
+    enum Priority {
+        Hidden,
+        Visible,
+        Hovered,
+        Focused
+    };
+
+    struct Column {
+        QPointer<QWidget> widget;
+        std::function<void()> apply;
+        std::function<bool()> animate;
+        bool pending = false;
+        bool animating = false;
+        qint64 pendingSinceMs = 0;
+        double costMs = 0.0;  // smoothed apply + paint time
+        double applyMs = 0.0; // apply time of the last frame, until its paint is recorded
+    };
+
+    static constexpr double kBudgetShare = 0.75; // of the refresh interval
+    static constexpr qint64 kMaxDeferMs = 250;
+
+    void tick();
+    void ensureRunning();
+    Priority priorityOf(const Column &column, QWidget *focus) const;
+
+    QPointer<QWidget> m_window;
+    QHash<int, Column> m_columns;
+    int m_nextId = 1;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    quint64 m_applied = 0;
+    quint64 m_deferred = 0;
+};
@@ -0,0 +1,387 @@
+#include "RequestSigner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr quint32 kRound[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+constexpr qint64 kPow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+quint32 rotr(quint32 x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+void compress(std::array<quint32, 8> &h, const quint8 *p)
+{
+    quint32 w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (quint32(p[i * 4]) << 24) | (quint32(p[i * 4 + 1]) << 16) | (quint32(p[i * 4 + 2]) << 8)
+               | quint32(p[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        const quint32 s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const quint32 s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    quint32 a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; ++i) {
+        const quint32 t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRound[i] + w[i];
+        const quint32 t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += k;
+}
+
+void appendInt(QByteArray &out, qint64 value)
+{
+    char digits[24];
+    int n = 0;
+    const bool negative = value < 0;
+    quint64 v = negative ? 0 - static_cast<quint64>(value) : static_cast<quint64>(value);
+    do {
+        digits[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (negative) {
+        out.append('-');
+    }
+    while (n > 0) {
+        out.append(digits[--n]);
+    }
+}
+
+// Same text as QString::number(value, 'f', decimals), without going through a QString.
+// Rounding the scaled double matches Qt's exact rounding unless the product lies
+// within its own rounding error of a half, or is past 2^53 where it is no longer an
+// integer-exact double (or past qint64). Those few go through Qt.
+void appendFixed(QByteArray &out, double value, int decimals)
+{
+    decimals = qBound(0, decimals, 8);
+    const double product = std::fabs(value) * static_cast<double>(kPow10[decimals]);
+    if (!(product < 0x1p53) || std::fabs(product - std::floor(product) - 0.5) <= product * 0x1p-50) {
+        out.append(QByteArray::number(value, 'f', decimals));
+        return;
+    }
+    const qint64 scaled = std::llround(product);
+    if (value < 0 && scaled != 0) {
+        out.append('-');
+    }
+    appendInt(out, scaled / kPow10[decimals]);
+    if (decimals == 0) {
+        return;
+    }
+    out.append('.');
+    qint64 frac = scaled % kPow10[decimals];
+    for (int i = decimals - 1; i >= 0; --i) {
+        out.append(static_cast<char>('0' + frac / kPow10[i]));
+        frac %= kPow10[i];
+    }
+}
+
+// Calls `sink` with each UTF-8 byte of `value`; symbols and prices are ASCII, so
+// the conversion (and its allocation) is only paid for anything else.
+template <typename Sink>
+void forEachUtf8(QStringView value, Sink sink)
+{
+    bool ascii = true;
+    for (QChar c : value) {
+        if (c.unicode() >= 0x80) {
+            ascii = false;
+            break;
+        }
+    }
+    if (ascii) {
+        for (QChar c : value) {
+            sink(static_cast<char>(c.unicode()));
+        }
+        return;
+    }
+    const QByteArray utf8 = value.toUtf8();
+    for (char c : utf8) {
+        sink(c);
+    }
+}
+
+void appendPercentEncoded(QByteArray &out, QStringView value)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    forEachUtf8(value, [&out](char ch) {
+        const auto c = static_cast<quint8>(ch);
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-'
+            || c == '.' || c == '_' || c == '~') {
+            out.append(ch);
+        } else {
+            out.append('%');
+            out.append(hex[c >> 4]);
+            out.append(hex[c & 0xF]);
+        }
+    });
+}
+
+void appendJsonString(QByteArray &out, QStringView value)
+{
+    static const char hex[] = "0123456789abcdef";
+    out.append('"');
+    forEachUtf8(value, [&out](char ch) {
+        const auto c = static_cast<quint8>(ch);
+        if (c == '"' || c == '\\') {
+            out.append('\\');
+            out.append(ch);
+        } else if (c < 0x20) {
+            out.append("\\u00", 4);
+            out.append(hex[c >> 4]);
+            out.append(hex[c & 0xF]);
+        } else {
+            out.append(ch);
+        }
+    });
+    out.append('"');
+}
+
+// `key` is one of our own ASCII field names; nothing to escape.
+void appendJsonKey(QByteArray &out, const char *key)
+{
+    if (out.size() > 1) {
+        out.append(',');
+    }
+    out.append('"');
+    out.append(key);
+    out.append("\":", 2);
+}
+} // namespace
+
+void RequestSigner::Sha256::reset()
+{
+    h = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    length = 0;
+}
+
+void RequestSigner::Sha256::update(const char *data, qsizetype size)
+{
+    const auto *p = reinterpret_cast<const quint8 *>(data);
+    std::size_t used = static_cast<std::size_t>(length % 64);
+    length += static_cast<quint64>(size);
+    if (used != 0) {
+        const std::size_t take = std::min<std::size_t>(64 - used, static_cast<std::size_t>(size));
+        std::memcpy(block.data() + used, p, take);
+        p += take;
+        size -= static_cast<qsizetype>(take);
+        used += take;
+        if (used < 64) {
+            return;
+        }
+        compress(h, block.data());
+    }
+    for (; size >= 64; p += 64, size -= 64) {
+        compress(h, p);
+    }
+    std::memcpy(block.data(), p, static_cast<std::size_t>(size));
+}
+
+std::array<quint8, 32> RequestSigner::Sha256::finish()
+{
+    const quint64 bits = length * 8;
+    static const char pad[64] = {'\x80'};
+    const std::size_t used = static_cast<std::size_t>(length % 64);
+    update(pad, static_cast<qsizetype>(used < 56 ? 56 - used : 120 - used));
+    char tail[8];
+    for (int i = 0; i < 8; ++i) {
+        tail[i] = static_cast<char>(bits >> (56 - i * 8));
+    }
+    update(tail, 8);
+
+    std::array<quint8, 32> digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<quint8>(h[i] >> 24);
+        digest[i * 4 + 1] = static_cast<quint8>(h[i] >> 16);
+        digest[i * 4 + 2] = static_cast<quint8>(h[i] >> 8);
+        digest[i * 4 + 3] = static_cast<quint8>(h[i]);
+    }
+    return digest;
+}
+
+RequestSigner::RequestSigner()
+{
+    // Reserved capacity survives resize(0) on Qt 5 as well.
+    m_buffer.reserve(512);
+    m_timestamp.reserve(16);
+    m_signature.reserve(64);
+    setSecret(QByteArray());
+}
+
+void RequestSigner::setSecret(const QByteArray &secret)
+{
+    std::array<quint8, 64> key{};
+    if (secret.size() > 64) {
+        Sha256 hash;
+        hash.reset();
+        hash.update(secret.constData(), secret.size());
+        const auto digest = hash.finish();
+        std::memcpy(key.data(), digest.data(), digest.size());
+    } else {
+        std::memcpy(key.data(), secret.constData(), static_cast<std::size_t>(secret.size()));
+    }
+
+    char pad[64];
+    m_inner.reset();
+    for (int i = 0; i < 64; ++i) {
+        pad[i] = static_cast<char>(key[i] ^ 0x36);
+    }
+    m_inner.update(pad, 64);
+    m_outer.reset();
+    for (int i = 0; i < 64; ++i) {
+        pad[i] = static_cast<char>(key[i] ^ 0x5c);
+    }
+    m_outer.update(pad, 64);
+}
+
+std::array<quint8, 32> RequestSigner::mac(const Sha256 &inner) const
+{
+    Sha256 in = inner;
+    const auto innerDigest = in.finish();
+    Sha256 out = m_outer;
+    out.update(reinterpret_cast<const char *>(innerDigest.data()), innerDigest.size());
+    return out.finish();
+}
+
+void RequestSigner::beginQuery()
+{
+    m_clock.start();
+    m_buffer.resize(0);
+}
+
+void RequestSigner::addQuery(const char *key, QStringView value)
+{
+    if (!m_buffer.isEmpty()) {
+        m_buffer.append('&');
+    }
+    m_buffer.append(key);
+    m_buffer.append('=');
+    appendPercentEncoded(m_buffer, value);
+}
+
+void RequestSigner::addQuery(const char *key, qint64 value)
+{
+    if (!m_buffer.isEmpty()) {
+        m_buffer.append('&');
+    }
+    m_buffer.append(key);
+    m_buffer.append('=');
+    appendInt(m_buffer, value);
+}
+
+void RequestSigner::addQuery(const char *key, double value, int decimals)
+{
+    if (!m_buffer.isEmpty()) {
+        m_buffer.append('&');
+    }
+    m_buffer.append(key);
+    m_buffer.append('=');
+    appendFixed(m_buffer, value, decimals);
+}
+
+const QByteArray &RequestSigner::signQuery()
+{
+    static const char hex[] = "0123456789abcdef";
+    Sha256 inner = m_inner;
+    inner.update(m_buffer.constData(), m_buffer.size());
+    const auto digest = mac(inner);
+    m_buffer.append("&signature=", 11);
+    for (quint8 byte : digest) {
+        m_buffer.append(hex[byte >> 4]);
+        m_buffer.append(hex[byte & 0xF]);
+    }
+    m_cost.record(m_clock.nsecsElapsed());
+    return m_buffer;
+}
+
+void RequestSigner::beginJson()
+{
+    m_clock.start();
+    m_buffer.resize(0);
+    m_buffer.append('{');
+}
+
+void RequestSigner::addJson(const char *key, QStringView value)
+{
+    appendJsonKey(m_buffer, key);
+    appendJsonString(m_buffer, value);
+}
+
+void RequestSigner::addJson(const char *key, qint64 value)
+{
+    appendJsonKey(m_buffer, key);
+    appendInt(m_buffer, value);
+}
+
+void RequestSigner::addJson(const char *key, double value, int decimals)
+{
+    appendJsonKey(m_buffer, key);
+    m_buffer.append('"');
+    appendFixed(m_buffer, value, decimals);
+    m_buffer.append('"');
+}
+
+const QByteArray &RequestSigner::signUzx(qint64 timestampSec, const char *method, QStringView path)
+{
+    static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    m_buffer.append('}');
+    m_timestamp.resize(0);
+    appendInt(m_timestamp, timestampSec);
+
+    Sha256 inner = m_inner;
+    inner.update(m_timestamp.constData(), m_timestamp.size());
+    inner.update(method, static_cast<qsizetype>(std::strlen(method)));
+    forEachUtf8(path, [&inner](char c) { inner.update(&c, 1); });
+    inner.update(m_buffer.constData(), m_buffer.size());
+    const auto digest = mac(inner);
+
+    m_signature.resize(0);
+    for (std::size_t i = 0; i < digest.size(); i += 3) {
+        const quint32 chunk = (quint32(digest[i]) << 16) | (i + 1 < digest.size() ? quint32(digest[i + 1]) << 8 : 0)
+                              | (i + 2 < digest.size() ? quint32(digest[i + 2]) : 0);
+        m_signature.append(base64[(chunk >> 18) & 0x3F]);
+        m_signature.append(base64[(chunk >> 12) & 0x3F]);
+        m_signature.append(i + 1 < digest.size() ? base64[(chunk >> 6) & 0x3F] : '=');
+        m_signature.append(i + 2 < digest.size() ? base64[chunk & 0x3F] : '=');
+    }
+    m_cost.record(m_clock.nsecsElapsed());
+    return m_buffer;
+}
+
+QString RequestSigner::report() const
+{
+    auto us = [](qint64 ns) { return QString::number(static_cast<double>(ns) / 1000.0, 'f', 2); };
+    return QStringLiteral("  %1 %2 / %3 / %4 / %5 us, %6 requests built and signed")
+        .arg(QStringLiteral("signing"), -12)
+        .arg(us(m_cost.percentileUs(0.50)),
+             us(m_cost.percentileUs(0.90)),
+             us(m_cost.percentileUs(0.99)),
+             us(m_cost.maxUs()))
+        .arg(m_cost.count());
+}
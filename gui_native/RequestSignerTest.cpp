@@ -0,0 +1,191 @@
+// RequestSigner against Qt (target shah_signer_test, run by ctest).
+//
+// Signatures: RequestSigner has its own SHA-256 and HMAC, and every order and
+// cancel is signed with them. signQuery()'s hex and signUzx()'s base64 must equal
+// QMessageAuthenticationCode over the exact bytes sent, for the RFC 4231 keys and
+// data, an empty secret, secrets around and past the 64-byte block, and messages
+// across the 55/56/64-byte padding boundaries.
+//
+// Numbers: addQuery(key, double, decimals) formats without a QString; whatever it
+// sends has to be the text QString::number(value, 'f', decimals) would give, or the
+// exchange sees a different price than the one signed for. Checks large values,
+// values whose scaled form sits on or next to a half, and a random spread in between.
+
+#include "RequestSigner.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QMessageAuthenticationCode>
+#include <QString>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+int checks = 0;
+int failures = 0;
+
+void expect(bool ok, const QByteArray &what, const QByteArray &got, const QByteArray &want)
+{
+    ++checks;
+    if (!ok && ++failures <= 20) {
+        std::printf("FAIL %s: got %s, want %s\n", what.constData(), got.constData(), want.constData());
+    }
+}
+
+QByteArray hmac(const QByteArray &secret, const QByteArray &message)
+{
+    return QMessageAuthenticationCode::hash(message, secret, QCryptographicHash::Sha256);
+}
+
+// Signs `key`=`value` as a MEXC query; `key` goes in raw, so it can carry any bytes.
+void checkQuery(RequestSigner &signer, const QByteArray &secret, const QByteArray &key, const QString &value)
+{
+    signer.setSecret(secret);
+    signer.beginQuery();
+    signer.addQuery(key.constData(), QStringView(value));
+    const QByteArray query = signer.signQuery();
+    const qsizetype at = query.lastIndexOf("&signature=");
+    const QByteArray message = query.left(at);
+    const QByteArray got = query.mid(at + 11);
+    const QByteArray want = hmac(secret, message).toHex();
+    expect(got == want,
+           "query, secret " + QByteArray::number(secret.size()) + " bytes, message "
+               + QByteArray::number(message.size()) + " bytes",
+           got,
+           want);
+}
+
+// Signs a UZX body; `method` goes in raw, so it can carry any bytes.
+void checkUzx(RequestSigner &signer, const QByteArray &secret, const QByteArray &method, const QString &path)
+{
+    signer.setSecret(secret);
+    signer.beginJson();
+    signer.addJson("symbol", QStringView(u"BTC-USDT"));
+    signer.addJson("price", 65000.5, 2);
+    const QByteArray body = signer.signUzx(1700000000, method.constData(), QStringView(path));
+    const QByteArray message = signer.uzxTimestamp() + method + path.toUtf8() + body;
+    const QByteArray got = signer.uzxSignature();
+    const QByteArray want = hmac(secret, message).toBase64();
+    expect(got == want,
+           "uzx, secret " + QByteArray::number(secret.size()) + " bytes, message "
+               + QByteArray::number(message.size()) + " bytes",
+           got,
+           want);
+}
+
+void checkSignatures()
+{
+    RequestSigner signer;
+
+    // RFC 4231 test cases 1-7. The signer always wraps the data in a request, so the
+    // digests are compared with Qt's over the wrapped bytes, not the RFC's.
+    QByteArray key4;
+    for (char c = 0x01; c <= 0x19; ++c) {
+        key4.append(c);
+    }
+    const QByteArray rfcKeys[] = {QByteArray(20, '\x0b'),
+                                  QByteArrayLiteral("Jefe"),
+                                  QByteArray(20, '\xaa'),
+                                  key4,
+                                  QByteArray(20, '\x0c'),
+                                  QByteArray(131, '\xaa'),
+                                  QByteArray(131, '\xaa')};
+    const QByteArray rfcData[] = {
+        QByteArrayLiteral("Hi There"),
+        QByteArrayLiteral("what do ya want for nothing?"),
+        QByteArray(50, '\xdd'),
+        QByteArray(50, '\xcd'),
+        QByteArrayLiteral("Test With Truncation"),
+        QByteArrayLiteral("Test Using Larger Than Block-Size Key - Hash Key First"),
+        QByteArrayLiteral("This is a test using a larger than block-size key and a larger than block-size data. "
+                          "The key needs to be hashed before being used by the HMAC algorithm.")};
+    for (int i = 0; i < 7; ++i) {
+        checkQuery(signer, rfcKeys[i], rfcData[i], QString());
+        checkUzx(signer, rfcKeys[i], rfcData[i], QStringLiteral("/v2/trade/spot/order"));
+    }
+
+    // Secrets: empty, one byte, either side of the block size, hashed first.
+    QByteArray binary;
+    for (int i = 0; i < 200; ++i) {
+        binary.append(static_cast<char>(i * 37 + 11));
+    }
+    const int secretSizes[] = {0, 1, 32, 63, 64, 65, 128, 200};
+    for (int size : secretSizes) {
+        const QByteArray secret = binary.left(size);
+        // "v=" plus `n` bytes: every message length from 2 to 201, so the padding
+        // lands on both sides of 55/56 and of each 64-byte block.
+        for (int n = 0; n < 200; ++n) {
+            checkQuery(signer, secret, "v", QString(n, QLatin1Char('a')));
+        }
+        for (int n = 0; n < 80; ++n) {
+            checkUzx(signer, secret, "POST", QStringLiteral("/") + QString(n, QLatin1Char('p')));
+        }
+    }
+}
+
+void checkFixed(RequestSigner &signer, double value, int decimals)
+{
+    signer.beginQuery();
+    signer.addQuery("v", value, decimals);
+    const QByteArray &query = signer.signQuery();
+    const QByteArray got = query.mid(2, query.indexOf("&signature=") - 2);
+    const QByteArray want = QString::number(value, 'f', decimals).toLatin1();
+    expect(got == want,
+           QByteArray::number(value, 'g', 17) + " to " + QByteArray::number(decimals) + " decimals",
+           got,
+           want);
+}
+} // namespace
+
+int main()
+{
+    checkSignatures();
+
+    RequestSigner signer;
+    signer.setSecret(QByteArrayLiteral("test-secret"));
+
+    // At and past 2^53 the scaled value is no longer an exact integer, and past
+    // 2^63 it does not fit a qint64.
+    const double large[] = {1e15,
+                            4503599627370495.5,
+                            4503599627370497.0,
+                            9007199254740992.0,
+                            9007199254740993.0,
+                            92233720368.54775807,
+                            123456789012.345678,
+                            1e17,
+                            1e19,
+                            1e300};
+    for (double value : large) {
+        for (int decimals = 0; decimals <= 8; ++decimals) {
+            checkFixed(signer, value, decimals);
+        }
+    }
+
+    // Half-way in decimal: exact binary halves (0.125) round up, the rest go by
+    // whichever side of the half the binary value falls (1.115 is 1.11499...).
+    const double halves[] = {0.125, 0.375, 2.5, 1.005, 1.115, 0.285, 2.675, 1234.5675, 1.0000000005};
+    for (double value : halves) {
+        for (int decimals = 0; decimals <= 8; ++decimals) {
+            checkFixed(signer, value, decimals);
+        }
+    }
+    for (int i = 0; i < 100000; ++i) {
+        checkFixed(signer, i / 1000.0 + 0.0005, 3);
+        checkFixed(signer, i * 0.005, 2);
+        checkFixed(signer, i * 0.5, 0);
+        checkFixed(signer, i * 0.00000005, 7);
+    }
+
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int i = 0; i < 200000; ++i) {
+        const double value = std::pow(10.0, unit(rng) * 20.0 - 8.0) * unit(rng);
+        checkFixed(signer, value, static_cast<int>(rng() % 9));
+    }
+
+    std::printf("%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
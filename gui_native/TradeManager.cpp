@@ -1,12 +1,10 @@
 #include "TradeManager.h"
 
-#include <QCryptographicHash>
 #include <QDateTime>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QList>
-#include <QMessageAuthenticationCode>
 #include <QNetworkRequest>
 #include <QUrl>
 #include <QStringList>
@@ -15,6 +13,8 @@
 #include <cstddef>
 
 namespace {
+constexpr qint64 kRecvWindowMs = 5000;
+
 QString normalizedSymbol(const QString &symbol)
 {
     QString s = symbol.trimmed().toUpper();
@@ -422,6 +422,10 @@ TradeManager::TradeManager(QObject *parent)
 
 TradeManager::~TradeManager()
 {
+    // Before the contexts its signal handlers point at.
+    for (auto it = m_contexts.constBegin(); it != m_contexts.constEnd(); ++it) {
+        delete it.value()->orderChannel;
+    }
     qDeleteAll(m_contexts);
 }
 
@@ -434,6 +438,7 @@ void TradeManager::setCredentials(ConnectionStore::Profile profile, const MexcCr
         account = defaultAccountName(profile);
     }
     ctx.accountName = account;
+    ctx.signer.setSecret(creds.secretKey.toUtf8());
 }
 
 MexcCredentials TradeManager::credentials(ConnectionStore::Profile profile) const
@@ -505,6 +510,7 @@ void TradeManager::connectToExchange(ConnectionStore::Profile profile)
     closeWebSocket(ctx);
     ctx.listenKey.clear();
     ctx.hasSubscribed = false;
+    ctx.orderChannel->start();
     if (ctx.profile == ConnectionStore::Profile::UzxSpot
         || ctx.profile == ConnectionStore::Profile::UzxSwap) {
         setState(ctx, ConnectionState::Connecting, tr("Connecting to UZX..."));
@@ -526,6 +532,7 @@ void TradeManager::disconnect(ConnectionStore::Profile profile)
         return;
     }
     closeWebSocket(*ctx);
+    ctx->orderChannel->stop();
     clearLocalOrderSnapshots(*ctx);
     ctx->listenKey.clear();
     ctx->hasSubscribed = false;
@@ -577,6 +584,21 @@ TradePosition TradeManager::positionForSymbol(const QString &symbol, const QStri
     }
     return TradePosition{};
 }
+
+QString TradeManager::orderLatencyReport() const
+{
+    QStringList parts;
+    for (auto it = m_contexts.constBegin(); it != m_contexts.constEnd(); ++it) {
+        const Context *ctx = it.value();
+        parts << QStringLiteral("%1 order path: %2")
+                     .arg(contextTag(ctx->accountName), ctx->orderChannel->report());
+        if (ctx->signer.costNs().count() > 0) {
+            parts << ctx->signer.report();
+        }
+    }
+    return parts.join(QLatin1Char('\n'));
+}
+
 void TradeManager::placeLimitOrder(const QString &symbol,
                                    const QString &accountName,
                                    double price,
@@ -610,27 +632,25 @@ void TradeManager::placeLimitOrder(const QString &symbol,
         || profile == ConnectionStore::Profile::UzxSpot) {
         const bool isSwap = (profile == ConnectionStore::Profile::UzxSwap);
         const QString wireSym = uzxWireSymbol(sym, isSwap);
-        QJsonObject payload;
-        const QString priceStr = QString::number(price, 'f', 8);
-        const QString amountStr = QString::number(quantity, 'f', 8);
-        payload.insert(QStringLiteral("product_name"), wireSym);
-        payload.insert(QStringLiteral("order_type"), 2);
-        payload.insert(QStringLiteral("price"), priceStr);
-        payload.insert(QStringLiteral("amount"), amountStr);
-        payload.insert(QStringLiteral("order_buy_or_sell"), side == OrderSide::Buy ? 1 : 2);
+        const QString path = isSwap ? QStringLiteral("/v2/trade/swap/order")
+                                    : QStringLiteral("/v2/trade/spot/order");
+        RequestSigner &signer = ctx.signer;
+        signer.beginJson();
+        signer.addJson("product_name", wireSym);
+        signer.addJson("order_type", qint64(2));
+        signer.addJson("price", price, 8);
+        signer.addJson("amount", quantity, 8);
+        signer.addJson("order_buy_or_sell", qint64(side == OrderSide::Buy ? 1 : 2));
         if (isSwap) {
-            payload.insert(QStringLiteral("number"), amountStr);
-            payload.insert(QStringLiteral("trade_ccy"), 1);
-            payload.insert(QStringLiteral("pos_side"),
-                           side == OrderSide::Buy ? QStringLiteral("LG") : QStringLiteral("ST"));
+            signer.addJson("number", quantity, 8);
+            signer.addJson("trade_ccy", qint64(1));
+            signer.addJson("pos_side", side == OrderSide::Buy ? QStringLiteral("LG") : QStringLiteral("ST"));
         }
-        const QByteArray body = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+        const QByteArray body = signer.signUzx(QDateTime::currentSecsSinceEpoch(), "POST", path);
+        QNetworkRequest req = makeUzxRequest(path, ctx);
         emit logMessage(QStringLiteral("%1 UZX REST body: %2")
                             .arg(contextTag(ctx.accountName), QString::fromUtf8(body)));
-        const QString path = isSwap ? QStringLiteral("/v2/trade/swap/order")
-                                    : QStringLiteral("/v2/trade/spot/order");
-        QNetworkRequest req = makeUzxRequest(path, body, QStringLiteral("POST"), ctx);
-        auto *reply = m_network.post(req, body);
+        auto *reply = ctx.orderChannel->send(req, QByteArrayLiteral("POST"), body);
         connect(reply,
                 &QNetworkReply::finished,
                 this,
@@ -706,27 +726,22 @@ void TradeManager::placeLimitOrder(const QString &symbol,
         return;
     }
 
-    QUrlQuery query;
-    query.addQueryItem(QStringLiteral("symbol"), sym);
-    query.addQueryItem(QStringLiteral("side"),
-                       side == OrderSide::Buy ? QStringLiteral("BUY") : QStringLiteral("SELL"));
-    query.addQueryItem(QStringLiteral("type"), QStringLiteral("LIMIT"));
-    query.addQueryItem(QStringLiteral("timeInForce"), QStringLiteral("GTC"));
-    query.addQueryItem(QStringLiteral("price"), QString::number(price, 'f', 8));
-    query.addQueryItem(QStringLiteral("quantity"), QString::number(quantity, 'f', 8));
-    query.addQueryItem(QStringLiteral("recvWindow"), QStringLiteral("5000"));
-    query.addQueryItem(QStringLiteral("timestamp"),
-                       QString::number(QDateTime::currentMSecsSinceEpoch()));
-
-    QUrlQuery signedQuery = query;
-    signedQuery.addQueryItem(QStringLiteral("signature"),
-                             QString::fromLatin1(signPayload(query, ctx)));
+    RequestSigner &signer = ctx.signer;
+    signer.beginQuery();
+    signer.addQuery("symbol", sym);
+    signer.addQuery("side", side == OrderSide::Buy ? QStringLiteral("BUY") : QStringLiteral("SELL"));
+    signer.addQuery("type", QStringLiteral("LIMIT"));
+    signer.addQuery("timeInForce", QStringLiteral("GTC"));
+    signer.addQuery("price", price, 8);
+    signer.addQuery("quantity", quantity, 8);
+    signer.addQuery("recvWindow", kRecvWindowMs);
+    signer.addQuery("timestamp", QDateTime::currentMSecsSinceEpoch());
 
     QNetworkRequest request = makePrivateRequest(QStringLiteral("/api/v3/order"),
-                                                 signedQuery,
+                                                 signer.signQuery(),
                                                  QByteArray(),
                                                  ctx);
-    auto *reply = m_network.post(request, QByteArray());
+    auto *reply = ctx.orderChannel->send(request, QByteArrayLiteral("POST"));
     connect(reply,
             &QNetworkReply::finished,
             this,
@@ -809,20 +824,17 @@ void TradeManager::cancelAllOrders(const QString &symbol, const QString &account
                         .arg(contextTag(ctx.accountName), sym));
     ctx.pendingCancelSymbols.insert(sym);
 
-    QUrlQuery query;
-    query.addQueryItem(QStringLiteral("symbol"), sym);
-    query.addQueryItem(QStringLiteral("recvWindow"), QStringLiteral("5000"));
-    query.addQueryItem(QStringLiteral("timestamp"),
-                       QString::number(QDateTime::currentMSecsSinceEpoch()));
-    QUrlQuery signedQuery = query;
-    signedQuery.addQueryItem(QStringLiteral("signature"),
-                             QString::fromLatin1(signPayload(query, ctx)));
+    RequestSigner &signer = ctx.signer;
+    signer.beginQuery();
+    signer.addQuery("symbol", sym);
+    signer.addQuery("recvWindow", kRecvWindowMs);
+    signer.addQuery("timestamp", QDateTime::currentMSecsSinceEpoch());
 
     QNetworkRequest req = makePrivateRequest(QStringLiteral("/api/v3/openOrders"),
-                                             signedQuery,
+                                             signer.signQuery(),
                                              QByteArray(),
                                              ctx);
-    auto *reply = m_network.sendCustomRequest(req, QByteArrayLiteral("DELETE"));
+    auto *reply = ctx.orderChannel->send(req, QByteArrayLiteral("DELETE"));
     connect(reply, &QNetworkReply::finished, this, [this, reply, sym, ctxPtr = &ctx]() {
         const QNetworkReply::NetworkError err = reply->error();
         const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
@@ -906,41 +918,15 @@ void TradeManager::emitPositionChanged(Context &ctx, const QString &symbol)
     emit positionChanged(ctx.accountName, symbol, ctx.positions.value(symbol));
 }
 
-QByteArray TradeManager::signPayload(const QUrlQuery &query, const Context &ctx) const
-{
-    const QByteArray payload = query.query(QUrl::FullyEncoded).toUtf8();
-    return QMessageAuthenticationCode::hash(payload,
-                                            ctx.credentials.secretKey.toUtf8(),
-                                            QCryptographicHash::Sha256)
-        .toHex();
-}
-
-QByteArray TradeManager::signUzxPayload(const QByteArray &body,
-                                        const QString &method,
-                                        const QString &path,
-                                        const Context &ctx) const
-{
-    const QString ts = QString::number(QDateTime::currentSecsSinceEpoch());
-    const QString base = ts + method.toUpper() + path + QString::fromUtf8(body);
-    const QByteArray sig = QMessageAuthenticationCode::hash(base.toUtf8(),
-                                                            ctx.credentials.secretKey.toUtf8(),
-                                                            QCryptographicHash::Sha256)
-                               .toBase64();
-    QByteArray out;
-    out.append(ts.toUtf8());
-    out.append('\n');
-    out.append(sig);
-    return out;
-}
-
 QNetworkRequest TradeManager::makePrivateRequest(const QString &path,
-                                                 const QUrlQuery &query,
+                                                 const QByteArray &query,
                                                  const QByteArray &contentType,
                                                  const Context &ctx) const
 {
     QUrl url(m_baseUrl + path);
     if (!query.isEmpty()) {
-        url.setQuery(query);
+        // Sent exactly as signed: the query only holds unreserved characters and %XX.
+        url.setQuery(QString::fromLatin1(query), QUrl::StrictMode);
     }
     QNetworkRequest req(url);
     if (!contentType.isEmpty()) {
@@ -950,36 +936,26 @@ QNetworkRequest TradeManager::makePrivateRequest(const QString &path,
     return req;
 }
 
-QNetworkRequest TradeManager::makeUzxRequest(const QString &path,
-                                             const QByteArray &body,
-                                             const QString &method,
-                                             const Context &ctx) const
+QNetworkRequest TradeManager::makeUzxRequest(const QString &path, const Context &ctx) const
 {
     QUrl url(m_uzxBaseUrl + path);
     QNetworkRequest req(url);
     req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
-    const QByteArray tsSig = signUzxPayload(body, method, path, ctx);
-    const QList<QByteArray> parts = tsSig.split('\n');
-    const QByteArray ts = parts.value(0);
-    const QByteArray sig = parts.value(1);
     req.setRawHeader("UZX-ACCESS-KEY", ctx.credentials.apiKey.toUtf8());
-    req.setRawHeader("UZX-ACCESS-SIGN", sig);
-    req.setRawHeader("UZX-ACCESS-TIMESTAMP", ts);
+    req.setRawHeader("UZX-ACCESS-SIGN", ctx.signer.uzxSignature());
+    req.setRawHeader("UZX-ACCESS-TIMESTAMP", ctx.signer.uzxTimestamp());
     req.setRawHeader("UZX-ACCESS-PASSPHRASE", ctx.credentials.passphrase.toUtf8());
     return req;
 }
 
 void TradeManager::requestListenKey(Context &ctx)
 {
-    QUrlQuery query;
-    query.addQueryItem(QStringLiteral("timestamp"),
-                       QString::number(QDateTime::currentMSecsSinceEpoch()));
-    query.addQueryItem(QStringLiteral("recvWindow"), QStringLiteral("5000"));
-    QUrlQuery signedQuery = query;
-    signedQuery.addQueryItem(QStringLiteral("signature"),
-                             QString::fromLatin1(signPayload(query, ctx)));
+    RequestSigner &signer = ctx.signer;
+    signer.beginQuery();
+    signer.addQuery("timestamp", QDateTime::currentMSecsSinceEpoch());
+    signer.addQuery("recvWindow", kRecvWindowMs);
     QNetworkRequest request = makePrivateRequest(QStringLiteral("/api/v3/userDataStream"),
-                                                 signedQuery,
+                                                 signer.signQuery(),
                                                  QByteArrayLiteral("application/json"),
                                                  ctx);
     auto *reply = m_network.post(request, QByteArrayLiteral("{}"));
@@ -1107,8 +1083,7 @@ void TradeManager::sendListenKeyKeepAlive(Context &ctx)
     if (ctx.listenKey.isEmpty()) {
         return;
     }
-    QUrlQuery query;
-    query.addQueryItem(QStringLiteral("listenKey"), ctx.listenKey);
+    const QByteArray query = "listenKey=" + QUrl::toPercentEncoding(ctx.listenKey);
     QNetworkRequest request = makePrivateRequest(QStringLiteral("/api/v3/userDataStream"),
                                                  query,
                                                  QByteArray(),
@@ -1153,15 +1128,12 @@ void TradeManager::fetchOpenOrders(Context &ctx)
         return;
     }
     ctx.openOrdersPending = true;
-    QUrlQuery query;
-    query.addQueryItem(QStringLiteral("recvWindow"), QStringLiteral("5000"));
-    query.addQueryItem(QStringLiteral("timestamp"),
-                       QString::number(QDateTime::currentMSecsSinceEpoch()));
-    QUrlQuery signedQuery = query;
-    signedQuery.addQueryItem(QStringLiteral("signature"),
-                             QString::fromLatin1(signPayload(query, ctx)));
+    RequestSigner &signer = ctx.signer;
+    signer.beginQuery();
+    signer.addQuery("recvWindow", kRecvWindowMs);
+    signer.addQuery("timestamp", QDateTime::currentMSecsSinceEpoch());
     QNetworkRequest req = makePrivateRequest(QStringLiteral("/api/v3/openOrders"),
-                                             signedQuery,
+                                             signer.signQuery(),
                                              QByteArray(),
                                              ctx);
     auto *reply = m_network.get(req);
@@ -1453,6 +1425,27 @@ TradeManager::Context &TradeManager::ensureContext(ConnectionStore::Profile prof
     ctx->reconnectTimer.setParent(self);
     ctx->privateSocket.setParent(self);
 
+    const bool isUzx = profile == ConnectionStore::Profile::UzxSpot
+                       || profile == ConnectionStore::Profile::UzxSwap;
+    ctx->orderChannel = new OrderChannel(QUrl(isUzx ? m_uzxBaseUrl : m_baseUrl),
+                                         isUzx ? QStringLiteral("/v2/time") : QStringLiteral("/api/v3/ping"),
+                                         self);
+    self->connect(ctx->orderChannel, &OrderChannel::requestTimed, self,
+                  [self, ctx](const QString &path, const OrderChannel::Timing &timing) {
+                      auto ms = [](qint64 us) {
+                          return us < 0 ? QStringLiteral("-")
+                                        : QString::number(static_cast<double>(us) / 1000.0, 'f', 1);
+                      };
+                      emit self->logMessage(QStringLiteral("%1 %2 took %3 ms (handshake %4, first byte %5, %6)")
+                                                .arg(contextTag(ctx->accountName),
+                                                     path,
+                                                     ms(timing.us[OrderChannel::Total]),
+                                                     ms(timing.us[OrderChannel::Handshake]),
+                                                     ms(timing.us[OrderChannel::FirstByte]),
+                                                     timing.reused ? QStringLiteral("open connection")
+                                                                   : QStringLiteral("new connection")));
+                  });
+
     ctx->keepAliveTimer.setInterval(25 * 60 * 1000);
     self->connect(&ctx->keepAliveTimer, &QTimer::timeout, self, [self, ctx]() {
         self->sendListenKeyKeepAlive(*ctx);
@@ -3,6 +3,8 @@
 #include "TradeTypes.h"
 #include "ConnectionStore.h"
 #include "DomWidget.h"
+#include "OrderChannel.h"
+#include "RequestSigner.h"
 
 #include <QObject>
 #include <QAbstractSocket>
@@ -10,7 +12,6 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QSet>
-#include <QUrlQuery>
 #include <QTimer>
 #include <QWebSocket>
 
@@ -47,6 +48,9 @@ public:
 
     TradePosition positionForSymbol(const QString &symbol, const QString &accountName) const;
 
+    // Per-account order-path timings (OrderChannel::report()), for the latency dump.
+    QString orderLatencyReport() const;
+
 signals:
     void connectionStateChanged(ConnectionStore::Profile profile,
                                 TradeManager::ConnectionState state,
@@ -86,6 +90,8 @@ private:
         QString accountName;
         ConnectionState state{ConnectionState::Disconnected};
         QWebSocket privateSocket;
+        OrderChannel *orderChannel = nullptr; // placing and cancelling orders
+        RequestSigner signer;                 // keyed with credentials.secretKey
         QTimer keepAliveTimer;
         QTimer reconnectTimer;
         QTimer wsPingTimer;
@@ -107,19 +113,13 @@ private:
     ConnectionStore::Profile profileFromAccountName(const QString &accountName) const;
 
     void setState(Context &ctx, ConnectionState state, const QString &message = QString());
-    QByteArray signPayload(const QUrlQuery &query, const Context &ctx) const;
-    QByteArray signUzxPayload(const QByteArray &body,
-                              const QString &method,
-                              const QString &path,
-                              const Context &ctx) const;
+    // `query` is already percent-encoded (RequestSigner::signQuery()).
     QNetworkRequest makePrivateRequest(const QString &path,
-                                       const QUrlQuery &query,
+                                       const QByteArray &query,
                                        const QByteArray &contentType,
                                        const Context &ctx) const;
-    QNetworkRequest makeUzxRequest(const QString &path,
-                                   const QByteArray &body,
-                                   const QString &method,
-                                   const Context &ctx) const;
+    // Headers from the signature of the last RequestSigner::signUzx().
+    QNetworkRequest makeUzxRequest(const QString &path, const Context &ctx) const;
     void handleOrderFill(Context &ctx, const QString &symbol, OrderSide side, double price, double quantity);
     void emitPositionChanged(Context &ctx, const QString &symbol);
     bool ensureCredentials(const Context &ctx) const;
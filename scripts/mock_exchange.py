@@ -0,0 +1,542 @@
+"""Local stand-in for the MEXC and UZX market data endpoints orderbook_backend uses.
+
+One port serves both venues over plain HTTP/WebSocket:
+
+  MEXC  GET /api/v3/exchangeInfo, /api/v3/depth, /api/v3/time
+        WS  /ws  (SUBSCRIPTION / UNSUBSCRIPTION / PING, protobuf
+                  PushDataV3ApiWrapper with publicAggreDepths and publicAggreDeals)
+  UZX   GET /notification/{spot|swap}/<SYMBOL>/orderbook
+        WS  /notification/ws  (sub / unsub, full JSON books, ping / pong)
+
+Books are synthetic: a random walk with configurable update rate, bursts, level
+churn, sweeps and trades. Every connection sees the same book per symbol, so REST
+snapshots and WebSocket updates agree.
+
+    python scripts/mock_exchange.py --port 8765 --rate 100 --burst 5 --churn 20
+    orderbook_backend --exchange mexc --symbol TESTUSDT \
+        --endpoint ws://127.0.0.1:8765/ws --rest-endpoint http://127.0.0.1:8765
+
+Standard library only.
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import json
+import random
+import struct
+import time
+import zlib
+from typing import Dict, List, Optional, Set, Tuple
+from urllib.parse import parse_qs, urlsplit
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+# A client that lets this much pile up in its socket buffer is dropped, like the
+# real exchanges do with slow consumers.
+MAX_CLIENT_BACKLOG = 64 * 1024 * 1024
+
+
+def log(prefix: str, message: str) -> None:
+    print(f"[{prefix}] {message}", flush=True)
+
+
+def now_ms() -> int:
+    return int(time.time() * 1000)
+
+
+# --- protobuf (write side of backend/src/MexcProto.cpp) ---------------------------
+
+
+def pb_varint(value: int) -> bytes:
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def pb_bytes(field: int, payload: bytes) -> bytes:
+    return pb_varint((field << 3) | 2) + pb_varint(len(payload)) + payload
+
+
+def pb_string(field: int, text: str) -> bytes:
+    return pb_bytes(field, text.encode())
+
+
+def pb_uint(field: int, value: int) -> bytes:
+    return pb_varint(field << 3) + pb_varint(value)
+
+
+def mexc_wrapper(channel: str, symbol: str, body_field: int, body: bytes) -> bytes:
+    ts = now_ms()
+    return (
+        pb_string(1, channel)
+        + pb_bytes(body_field, body)
+        + pb_string(3, symbol)
+        + pb_uint(5, ts)
+        + pb_uint(6, ts)
+    )
+
+
+def mexc_depth(symbol: str, asks: List[Tuple[str, str]], bids: List[Tuple[str, str]], version: int) -> bytes:
+    body = b"".join(pb_bytes(1, pb_string(1, p) + pb_string(2, q)) for p, q in asks)
+    body += b"".join(pb_bytes(2, pb_string(1, p) + pb_string(2, q)) for p, q in bids)
+    body += pb_string(3, "spot@public.aggre.depth.v3.api.pb@100ms")
+    body += pb_string(4, str(version)) + pb_string(5, str(version))
+    return mexc_wrapper(f"spot@public.aggre.depth.v3.api.pb@100ms@{symbol}", symbol, 313, body)
+
+
+def mexc_deals(symbol: str, deals: List[Tuple[str, str, bool]]) -> bytes:
+    ts = now_ms()
+    body = b"".join(
+        pb_bytes(1, pb_string(1, p) + pb_string(2, q) + pb_uint(3, 1 if buy else 2) + pb_uint(4, ts))
+        for p, q, buy in deals
+    )
+    body += pb_string(2, "spot@public.aggre.deals.v3.api.pb@100ms")
+    return mexc_wrapper(f"spot@public.aggre.deals.v3.api.pb@100ms@{symbol}", symbol, 314, body)
+
+
+# --- synthetic market ---------------------------------------------------------------
+
+
+class SyntheticBook:
+    """Price levels in integer ticks around a wandering mid."""
+
+    def __init__(self, symbol: str, args: argparse.Namespace) -> None:
+        # Same symbol, same book across runs with the same --seed.
+        self.rng = random.Random(args.seed ^ zlib.crc32(symbol.encode()))
+        self.symbol = symbol
+        self.decimals = args.decimals
+        self.tick = 10.0 ** -args.decimals
+        self.depth = args.depth
+        self.mid = int(round(args.price / self.tick))
+        self.version = 1
+        self.bids: Dict[int, float] = {}
+        self.asks: Dict[int, float] = {}
+        for i in range(1, self.depth + 1):
+            self.bids[self.mid - i] = self.random_qty()
+            self.asks[self.mid + i] = self.random_qty()
+
+    def random_qty(self) -> float:
+        return round(self.rng.expovariate(1.0 / 50.0) + 0.01, 4)
+
+    def price(self, tick: int) -> str:
+        return f"{tick * self.tick:.{self.decimals}f}"
+
+    def best_bid(self) -> int:
+        return max(self.bids) if self.bids else self.mid - 1
+
+    def best_ask(self) -> int:
+        return min(self.asks) if self.asks else self.mid + 1
+
+    def snapshot(self, limit: int) -> Tuple[List[List[str]], List[List[str]]]:
+        bids = sorted(self.bids.items(), reverse=True)[:limit]
+        asks = sorted(self.asks.items())[:limit]
+        return (
+            [[self.price(t), f"{q}"] for t, q in bids],
+            [[self.price(t), f"{q}"] for t, q in asks],
+        )
+
+    def churn(self, count: int) -> Dict[Tuple[str, int], float]:
+        """Random size changes, adds and removals near the top; returns the changed levels."""
+        changes: Dict[Tuple[str, int], float] = {}
+        for _ in range(count):
+            side = "bid" if self.rng.random() < 0.5 else "ask"
+            book = self.bids if side == "bid" else self.asks
+            offset = int(self.rng.expovariate(1.0 / 8.0)) + 1
+            tick = self.best_bid() - offset + 1 if side == "bid" else self.best_ask() + offset - 1
+            if self.rng.random() < 0.15 and tick in book:
+                del book[tick]
+                changes[(side, tick)] = 0.0
+            else:
+                book[tick] = self.random_qty()
+                changes[(side, tick)] = book[tick]
+        self.version += 1
+        return changes
+
+    def sweep(self, size: int) -> Tuple[Dict[Tuple[str, int], float], List[Tuple[str, str, bool]]]:
+        """A market order eats `size` levels on one side; returns level changes and trades."""
+        buy = self.rng.random() < 0.5
+        book = self.asks if buy else self.bids
+        side = "ask" if buy else "bid"
+        changes: Dict[Tuple[str, int], float] = {}
+        trades: List[Tuple[str, str, bool]] = []
+        for tick in sorted(book, reverse=not buy)[:size]:
+            trades.append((self.price(tick), f"{book.pop(tick)}", buy))
+            changes[(side, tick)] = 0.0
+        # The other side follows the price so the book stays uncrossed.
+        self.mid = (self.best_ask() - 1) if buy else (self.best_bid() + 1)
+        other = self.bids if buy else self.asks
+        other_side = "bid" if buy else "ask"
+        for i in range(1, size + 1):
+            tick = self.mid - i if buy else self.mid + i
+            if tick not in other:
+                other[tick] = self.random_qty()
+                changes[(other_side, tick)] = other[tick]
+        self.version += 1
+        return changes, trades
+
+    def trades(self, count: int) -> List[Tuple[str, str, bool]]:
+        out = []
+        for _ in range(count):
+            buy = self.rng.random() < 0.5
+            tick = self.best_ask() if buy else self.best_bid()
+            out.append((self.price(tick), f"{round(self.rng.expovariate(1.0 / 5.0) + 0.01, 4)}", buy))
+        return out
+
+    def trim(self) -> None:
+        """Keep `depth` levels per side so long runs don't grow without bound."""
+        for book, reverse in ((self.bids, True), (self.asks, False)):
+            for tick in sorted(book, reverse=reverse)[self.depth * 2 :]:
+                del book[tick]
+
+
+# --- WebSocket ------------------------------------------------------------------------
+
+
+class WsClient:
+    def __init__(self, venue: str, reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> None:
+        self.venue = venue
+        self.reader = reader
+        self.writer = writer
+        self.symbols: Set[str] = set()
+        self.closed = False
+
+    def send(self, opcode: int, payload: bytes) -> None:
+        if self.closed:
+            return
+        if self.writer.is_closing():
+            # Peer went away; the read side notices and unregisters the client.
+            self.closed = True
+            return
+        if self.writer.transport.get_write_buffer_size() > MAX_CLIENT_BACKLOG:
+            log("ws", f"dropping slow {self.venue} client")
+            self.close()
+            return
+        n = len(payload)
+        if n < 126:
+            header = struct.pack("!BB", 0x80 | opcode, n)
+        elif n < 65536:
+            header = struct.pack("!BBH", 0x80 | opcode, 126, n)
+        else:
+            header = struct.pack("!BBQ", 0x80 | opcode, 127, n)
+        self.writer.write(header + payload)
+
+    def send_text(self, text: str) -> None:
+        self.send(0x1, text.encode())
+
+    def send_binary(self, data: bytes) -> None:
+        self.send(0x2, data)
+
+    def close(self) -> None:
+        if not self.closed:
+            self.closed = True
+            self.writer.close()
+
+    async def read_message(self) -> Optional[Tuple[int, bytes]]:
+        """Returns (opcode, payload) of the next complete data message, None on close."""
+        message = bytearray()
+        message_opcode = 0
+        while True:
+            head = await self.reader.readexactly(2)
+            fin = head[0] & 0x80
+            opcode = head[0] & 0x0F
+            masked = head[1] & 0x80
+            n = head[1] & 0x7F
+            if n == 126:
+                (n,) = struct.unpack("!H", await self.reader.readexactly(2))
+            elif n == 127:
+                (n,) = struct.unpack("!Q", await self.reader.readexactly(8))
+            mask = await self.reader.readexactly(4) if masked else b"\0\0\0\0"
+            data = bytearray(await self.reader.readexactly(n))
+            for i in range(n):
+                data[i] ^= mask[i % 4]
+
+            if opcode == 0x8:
+                self.send(0x8, bytes(data[:2]))
+                return None
+            if opcode == 0x9:
+                self.send(0xA, bytes(data))
+                continue
+            if opcode == 0xA:
+                continue
+            if opcode != 0x0:
+                message_opcode = opcode
+            message += data
+            if fin:
+                return message_opcode, bytes(message)
+
+
+class MockExchange:
+    def __init__(self, args: argparse.Namespace) -> None:
+        self.args = args
+        self.books: Dict[str, SyntheticBook] = {}
+        self.clients: Set[WsClient] = set()
+        self.publishers: Dict[str, asyncio.Task] = {}
+        self.sent_messages = 0
+        self.sent_bytes = 0
+
+    def book(self, symbol: str) -> SyntheticBook:
+        if symbol not in self.books:
+            self.books[symbol] = SyntheticBook(symbol, self.args)
+        return self.books[symbol]
+
+    # --- REST ---
+
+    def rest(self, path: str, query: Dict[str, List[str]]) -> Tuple[int, dict]:
+        symbol = query.get("symbol", [""])[0]
+        if path == "/api/v3/time":
+            return 200, {"serverTime": now_ms()}
+        if path == "/api/v3/exchangeInfo" and symbol:
+            book = self.book(symbol)
+            return 200, {
+                "symbols": [
+                    {
+                        "symbol": symbol,
+                        "status": "1",
+                        "quotePrecision": book.decimals,
+                        "quoteAssetPrecision": book.decimals,
+                    }
+                ]
+            }
+        if path == "/api/v3/depth" and symbol:
+            limit = int(query.get("limit", ["100"])[0])
+            book = self.book(symbol)
+            bids, asks = book.snapshot(limit)
+            return 200, {"lastUpdateId": book.version, "bids": bids, "asks": asks}
+        parts = path.strip("/").split("/")
+        if len(parts) == 4 and parts[0] == "notification" and parts[3] == "orderbook":
+            book = self.book(parts[2])
+            bids, asks = book.snapshot(self.args.depth)
+            return 200, {"code": 0, "data": {"bids": bids, "asks": asks, "ts": now_ms()}}
+        return 404, {"code": 404, "msg": f"no mock for {path}"}
+
+    # --- publishing ---
+
+    def ensure_publisher(self, symbol: str) -> None:
+        if symbol not in self.publishers:
+            self.publishers[symbol] = asyncio.get_running_loop().create_task(self.publish(symbol))
+
+    async def publish(self, symbol: str) -> None:
+        args = self.args
+        book = self.book(symbol)
+        interval = 1.0 / args.rate
+        next_at = time.monotonic()
+        tick = 0
+        while True:
+            next_at += interval
+            subscribers = [c for c in self.clients if symbol in c.symbols and not c.closed]
+            if not subscribers:
+                self.publishers.pop(symbol, None)
+                return
+            for _ in range(args.burst):
+                tick += 1
+                if args.sweep_every and tick % args.sweep_every == 0:
+                    changes, trades = book.sweep(args.sweep_levels)
+                else:
+                    changes = book.churn(args.churn)
+                    trades = book.trades(args.trades) if book.rng.random() < args.trade_chance else []
+                book.trim()
+                self.broadcast(book, subscribers, changes, trades)
+            delay = next_at - time.monotonic()
+            if delay > 0:
+                await asyncio.sleep(delay)
+            else:
+                # Running behind: don't try to catch up with a burst of bursts.
+                next_at = time.monotonic()
+                await asyncio.sleep(0)
+
+    def broadcast(
+        self,
+        book: SyntheticBook,
+        subscribers: List[WsClient],
+        changes: Dict[Tuple[str, int], float],
+        trades: List[Tuple[str, str, bool]],
+    ) -> None:
+        mexc: List[bytes] = []
+        uzx: Optional[str] = None
+        for client in subscribers:
+            if client.venue == "mexc":
+                if not mexc:
+                    asks = [(book.price(t), f"{q}") for (s, t), q in changes.items() if s == "ask"]
+                    bids = [(book.price(t), f"{q}") for (s, t), q in changes.items() if s == "bid"]
+                    mexc.append(mexc_depth(book.symbol, asks, bids, book.version))
+                    if trades:
+                        mexc.append(mexc_deals(book.symbol, trades))
+                for frame in mexc:
+                    client.send_binary(frame)
+                    self.sent_bytes += len(frame)
+            else:
+                if uzx is None:
+                    bids, asks = book.snapshot(self.args.depth)
+                    uzx = json.dumps(
+                        {"ts": now_ms(), "data": {"product_name": book.symbol, "bids": bids, "asks": asks}}
+                    )
+                client.send_text(uzx)
+                self.sent_bytes += len(uzx)
+            self.sent_messages += 1
+
+    # --- connections ---
+
+    async def handle(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> None:
+        try:
+            request = await reader.readuntil(b"\r\n\r\n")
+        except (asyncio.IncompleteReadError, asyncio.LimitOverrunError, ConnectionError):
+            writer.close()
+            return
+        lines = request.decode("latin-1").split("\r\n")
+        method, target, _ = (lines[0].split(" ") + ["", "", ""])[:3]
+        headers = {}
+        for line in lines[1:]:
+            if ":" in line:
+                k, v = line.split(":", 1)
+                headers[k.strip().lower()] = v.strip()
+        url = urlsplit(target)
+
+        if headers.get("upgrade", "").lower() == "websocket":
+            await self.serve_websocket(url.path, headers, reader, writer)
+            return
+
+        status, body = self.rest(url.path, parse_qs(url.query)) if method == "GET" else (405, {})
+        payload = json.dumps(body).encode()
+        reason = "OK" if status == 200 else "Error"
+        writer.write(
+            f"HTTP/1.1 {status} {reason}\r\nContent-Type: application/json\r\n"
+            f"Content-Length: {len(payload)}\r\nConnection: close\r\n\r\n".encode()
+            + payload
+        )
+        try:
+            await writer.drain()
+        except ConnectionError:
+            pass
+        writer.close()
+
+    async def serve_websocket(
+        self, path: str, headers: Dict[str, str], reader: asyncio.StreamReader, writer: asyncio.StreamWriter
+    ) -> None:
+        venue = "mexc" if path == "/ws" else "uzx" if path == "/notification/ws" else ""
+        if not venue or "sec-websocket-key" not in headers:
+            writer.write(b"HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n")
+            writer.close()
+            return
+        accept = base64.b64encode(hashlib.sha1((headers["sec-websocket-key"] + WS_GUID).encode()).digest())
+        writer.write(
+            b"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            b"Sec-WebSocket-Accept: " + accept + b"\r\n\r\n"
+        )
+
+        client = WsClient(venue, reader, writer)
+        self.clients.add(client)
+        log("ws", f"{venue} client connected ({len(self.clients)} open)")
+        pinger = asyncio.get_running_loop().create_task(self.ping_loop(client))
+        try:
+            while True:
+                message = await client.read_message()
+                if message is None:
+                    break
+                opcode, data = message
+                if opcode == 0x1:
+                    self.on_text(client, data.decode(errors="replace"))
+                await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            pinger.cancel()
+            self.clients.discard(client)
+            client.close()
+            log("ws", f"{venue} client gone ({len(self.clients)} open)")
+
+    async def ping_loop(self, client: WsClient) -> None:
+        if self.args.server_ping <= 0:
+            return
+        while not client.closed:
+            await asyncio.sleep(self.args.server_ping)
+            client.send_text(json.dumps({"method": "PING"} if client.venue == "mexc" else {"ping": now_ms()}))
+
+    def on_text(self, client: WsClient, text: str) -> None:
+        try:
+            msg = json.loads(text)
+        except ValueError:
+            return
+        if client.venue == "mexc":
+            method = msg.get("method", "")
+            if method == "PING":
+                client.send_text(json.dumps({"id": 0, "code": 0, "msg": "PONG"}))
+                return
+            if method in ("SUBSCRIPTION", "UNSUBSCRIPTION"):
+                params = msg.get("params", [])
+                for channel in params:
+                    symbol = channel.rsplit("@", 1)[-1]
+                    if method == "SUBSCRIPTION":
+                        client.symbols.add(symbol)
+                        self.ensure_publisher(symbol)
+                    else:
+                        client.symbols.discard(symbol)
+                client.send_text(json.dumps({"id": msg.get("id", 0), "code": 0, "msg": ",".join(params)}))
+            return
+
+        event = msg.get("event", "")
+        symbol = msg.get("params", {}).get("symbol", "")
+        if event == "sub" and symbol:
+            client.symbols.add(symbol)
+            self.ensure_publisher(symbol)
+        elif event == "unsub":
+            client.symbols.discard(symbol)
+
+    async def report(self) -> None:
+        last_messages, last_bytes, last_at = 0, 0, time.monotonic()
+        while True:
+            await asyncio.sleep(5.0)
+            at = time.monotonic()
+            span = at - last_at
+            log(
+                "mock",
+                f"{(self.sent_messages - last_messages) / span:.0f} msg/s, "
+                f"{(self.sent_bytes - last_bytes) / span / 1024:.0f} KiB/s, "
+                f"{len(self.clients)} clients, {len(self.publishers)} symbols",
+            )
+            last_messages, last_bytes, last_at = self.sent_messages, self.sent_bytes, at
+
+
+async def serve(args: argparse.Namespace) -> None:
+    mock = MockExchange(args)
+    server = await asyncio.start_server(mock.handle, args.host, args.port)
+    log("mock", f"listening on {args.host}:{args.port}")
+    asyncio.get_running_loop().create_task(mock.report())
+    async with server:
+        await server.serve_forever()
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Mock MEXC/UZX market data server for load tests")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8765)
+    parser.add_argument("--rate", type=float, default=10.0, help="update rounds per second per symbol")
+    parser.add_argument("--burst", type=int, default=1, help="messages sent back-to-back per round")
+    parser.add_argument("--churn", type=int, default=5, help="levels changed per depth update")
+    parser.add_argument("--sweep-every", type=int, default=0, help="every Nth update is a sweep (0: never)")
+    parser.add_argument("--sweep-levels", type=int, default=10, help="levels one sweep takes out")
+    parser.add_argument("--trades", type=int, default=3, help="trades per trade message")
+    parser.add_argument("--trade-chance", type=float, default=0.5, help="chance an update also sends trades")
+    parser.add_argument("--depth", type=int, default=500, help="levels per side in the book")
+    parser.add_argument("--price", type=float, default=100.0, help="starting mid price")
+    parser.add_argument("--decimals", type=int, default=2, help="price decimals (tick = 10^-decimals)")
+    parser.add_argument("--server-ping", type=float, default=0.0, help="seconds between server PINGs (0: off)")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    if args.rate <= 0:
+        parser.error("--rate must be positive")
+    try:
+        asyncio.run(serve(args))
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())